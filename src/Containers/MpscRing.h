@@ -0,0 +1,134 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  MpscRing.h - Multiple-Writer Single-Reader Lock Free Ringbuffer
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace zyn {
+
+/**
+ * Bounded queue for many writers and a single reader
+ *
+ * - no system calls and no allocation (post initialization)
+ * - a writer only retries if another writer took the same slot first
+ * - the reader can look at the oldest item before taking it
+ * - writing into a full queue fails and is counted
+ *
+ * Every slot carries a sequence number, which tells whether it is free for
+ * the current lap of the writers or filled for the current lap of the reader.
+ */
+template<class T>
+class MpscRing
+{
+    public:
+        //! @param size is rounded up to a power of two
+        explicit MpscRing(size_t size);
+        ~MpscRing(void);
+        MpscRing(const MpscRing&) = delete;
+
+        //! @return false if the queue is full
+        bool push(const T &item);
+        //! @return the oldest item or NULL if empty (reader only)
+        T *front(void);
+        //! drop the item front() returned (reader only)
+        void pop(void);
+        //! reader only
+        bool empty(void) const;
+
+        std::atomic<uint32_t> overflows; //failed push() calls
+
+    private:
+        struct Slot {
+            std::atomic<size_t> seq;
+            T item;
+        };
+
+        Slot         *slots;
+        const size_t  mask;
+        alignas(64) std::atomic<size_t> head; //next slot to write
+        alignas(64) size_t tail;              //next slot to read
+};
+
+static inline size_t mpscRingSize(size_t size)
+{
+    size_t n = 2;
+    while(n < size)
+        n *= 2;
+    return n;
+}
+
+template<class T>
+MpscRing<T>::MpscRing(size_t size)
+    :overflows(0), slots(new Slot[mpscRingSize(size)]),
+    mask(mpscRingSize(size) - 1), head(0), tail(0)
+{
+    for(size_t i = 0; i <= mask; ++i)
+        slots[i].seq.store(i, std::memory_order_relaxed);
+}
+
+template<class T>
+MpscRing<T>::~MpscRing(void)
+{
+    delete [] slots;
+}
+
+template<class T>
+bool MpscRing<T>::push(const T &item)
+{
+    size_t pos = head.load(std::memory_order_relaxed);
+    Slot *slot;
+    while(true) {
+        slot = &slots[pos & mask];
+        const size_t seq = slot->seq.load(std::memory_order_acquire);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if(diff == 0) {
+            //free for this lap, try to claim it
+            if(head.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed))
+                break;
+        } else if(diff < 0) {
+            //the reader has not freed it yet
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else
+            pos = head.load(std::memory_order_relaxed);
+    }
+
+    slot->item = item;
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template<class T>
+T *MpscRing<T>::front(void)
+{
+    Slot *slot = &slots[tail & mask];
+    if(slot->seq.load(std::memory_order_acquire) != tail + 1)
+        return NULL;
+    return &slot->item;
+}
+
+template<class T>
+void MpscRing<T>::pop(void)
+{
+    slots[tail & mask].seq.store(tail + mask + 1, std::memory_order_release);
+    ++tail;
+}
+
+template<class T>
+bool MpscRing<T>::empty(void) const
+{
+    return slots[tail & mask].seq.load(std::memory_order_acquire) != tail + 1;
+}
+
+}
@@ -45,11 +45,46 @@ const char *getStatus(int status)
     }
 }
 
-NotePool::NotePool(void)
-    :needs_cleaning(0)
+NotePool::NotePool(Allocator &memory_, int polyphony)
+    :ndesc(NULL), sdesc(NULL), needs_cleaning(0), ndesc_used(0), sdesc_used(0),
+    memory(memory_), max_notes(0)
 {
-    memset(ndesc, 0, sizeof(ndesc));
-    memset(sdesc, 0, sizeof(sdesc));
+    memset(key_first, -1, sizeof(key_first));
+    memset(key_last, -1, sizeof(key_last));
+    if(!resize(polyphony))
+        throw std::bad_alloc();
+}
+
+NotePool::~NotePool(void)
+{
+    memory.devalloc(ndesc);
+    memory.devalloc(sdesc);
+}
+
+bool NotePool::resize(int polyphony)
+{
+    assert(ndesc_used == 0 && !needs_cleaning);
+    if(polyphony == max_notes)
+        return true;
+
+    //Allocate both before releasing the old storage, so a failure leaves
+    //the pool usable
+    NoteDescriptor  *nd = NULL;
+    SynthDescriptor *sd = NULL;
+    try {
+        nd = memory.valloc<NoteDescriptor>(polyphony);
+        sd = memory.valloc<SynthDescriptor>(polyphony*EXPECTED_USAGE);
+    } catch(std::bad_alloc &) {
+        memory.devalloc(nd);
+        return false;
+    }
+
+    memory.devalloc(ndesc);
+    memory.devalloc(sdesc);
+    ndesc     = nd;
+    sdesc     = sd;
+    max_notes = polyphony;
+    return true;
 }
 
 bool NotePool::NoteDescriptor::playing(void) const
@@ -112,12 +147,8 @@ void NotePool::NoteDescriptor::makeUnsustainable(void)
 
 NotePool::activeNotesIter NotePool::activeNotes(NoteDescriptor &n)
 {
-    const int off_d1 = &n-ndesc;
-    int off_d2 = 0;
-    assert(off_d1 <= POLYPHONY);
-    for(int i=0; i<off_d1; ++i)
-        off_d2 += ndesc[i].size;
-    return NotePool::activeNotesIter{sdesc+off_d2,sdesc+off_d2+n.size};
+    assert(&n-ndesc <= max_notes);
+    return NotePool::activeNotesIter{sdesc+n.sdesc_id,sdesc+n.sdesc_id+n.size};
 }
 
 bool NotePool::NoteDescriptor::operator==(NoteDescriptor nd)
@@ -125,31 +156,12 @@ bool NotePool::NoteDescriptor::operator==(NoteDescriptor nd)
     return age == nd.age && note == nd.note && sendto == nd.sendto && size == nd.size && status == nd.status;
 }
 
-//return either the first unused descriptor or the last valid descriptor which
-//matches note/sendto
-static int getMergeableDescriptor(note_t note, uint8_t sendto, bool legato,
-        NotePool::NoteDescriptor *ndesc)
+//A note started within the current buffer can take more synths
+static bool mergeable(const NotePool::NoteDescriptor &nd, note_t note,
+        uint8_t sendto, bool legato)
 {
-    int desc_id;
-
-    for(desc_id = 0; desc_id != POLYPHONY; ++desc_id) {
-        if(ndesc[desc_id].off())
-            break;
-    }
-
-    if(desc_id != 0) {
-        auto &nd = ndesc[desc_id-1];
-        if(nd.age == 0 && nd.note == note && nd.sendto == sendto
-                && nd.playing() && nd.legatoMirror == legato && nd.canSustain())
-            return desc_id-1;
-    }
-
-    //Out of free descriptors
-    if(desc_id == POLYPHONY || !ndesc[desc_id].off()) {
-        return -1;
-    }
-
-    return desc_id;
+    return nd.age == 0 && nd.note == note && nd.sendto == sendto
+        && nd.playing() && nd.legatoMirror == legato && nd.canSustain();
 }
 
 NotePool::activeDescIter NotePool::activeDesc(void)
@@ -164,15 +176,37 @@ NotePool::constActiveDescIter NotePool::activeDesc(void) const
     return constActiveDescIter{*this};
 }
 
+NotePool::keyDescIter NotePool::keyDesc(note_t note)
+{
+    cleanup();
+    return keyDescIter{ndesc, key_first[note]};
+}
+
+void NotePool::linkKey(int i)
+{
+    NoteDescriptor &nd = ndesc[i];
+    nd.key_next = -1;
+    if(key_last[nd.note] >= 0)
+        ndesc[key_last[nd.note]].key_next = i;
+    else
+        key_first[nd.note] = i;
+    key_last[nd.note] = i;
+}
+
+void NotePool::indexKeys(void)
+{
+    memset(key_first, -1, sizeof(key_first));
+    memset(key_last, -1, sizeof(key_last));
+    for(int i=0; i<ndesc_used; ++i)
+        linkKey(i);
+}
+
 int NotePool::usedNoteDesc(void) const
 {
     if(needs_cleaning)
         const_cast<NotePool*>(this)->cleanup();
 
-    int cnt = 0;
-    for(int i=0; i<POLYPHONY; ++i)
-        cnt += (ndesc[i].size != 0);
-    return cnt;
+    return ndesc_used;
 }
 
 int NotePool::usedSynthDesc(void) const
@@ -180,37 +214,42 @@ int NotePool::usedSynthDesc(void) const
     if(needs_cleaning)
         const_cast<NotePool*>(this)->cleanup();
 
-    int cnt = 0;
-    for(int i=0; i<POLYPHONY*EXPECTED_USAGE; ++i)
-        cnt += (bool)sdesc[i].note;
-    return cnt;
+    return sdesc_used;
 }
 
 void NotePool::insertNote(note_t note, uint8_t sendto, SynthDescriptor desc, PortamentoRealtime *portamento_realtime, bool legato)
 {
-    //Get first free note descriptor
-    int desc_id = getMergeableDescriptor(note, sendto, legato, ndesc);
-    int sdesc_id = 0;
-    if(desc_id < 0)
+    //Free descriptors are only at the end of the pool after cleaning
+    cleanup();
+
+    //Out of free synth descriptors
+    if(sdesc_used == max_notes*EXPECTED_USAGE)
         goto error;
 
-    //Get first free synth descriptor
-    while(1) {
-        if (sdesc_id == POLYPHONY*EXPECTED_USAGE)
-                goto error;
-        if (sdesc[sdesc_id].note == 0)
-                break;
-        sdesc_id++;
+    //Merge with the last descriptor if it is the same note started within
+    //this buffer, else take the first free one
+    if(ndesc_used == 0 || !mergeable(ndesc[ndesc_used-1], note, sendto, legato)) {
+        //Out of free note descriptors
+        if(ndesc_used == max_notes)
+            goto error;
+        NoteDescriptor &nd = ndesc[ndesc_used++];
+        nd.size    = 0;
+        nd.sdesc_id = sdesc_used;
+        nd.note     = note;
+        linkKey(ndesc_used-1);
     }
 
-    ndesc[desc_id].note                = note;
-    ndesc[desc_id].sendto              = sendto;
-    ndesc[desc_id].size               += 1;
-    ndesc[desc_id].status              = KEY_PLAYING;
-    ndesc[desc_id].legatoMirror        = legato;
-    ndesc[desc_id].portamentoRealtime  = portamento_realtime;
+    {
+        NoteDescriptor &nd = ndesc[ndesc_used-1];
+        nd.note                = note;
+        nd.sendto              = sendto;
+        nd.size               += 1;
+        nd.status              = KEY_PLAYING;
+        nd.legatoMirror        = legato;
+        nd.portamentoRealtime  = portamento_realtime;
+    }
 
-    sdesc[sdesc_id] = desc;
+    sdesc[sdesc_used++] = desc;
     return;
 error:
     //Avoid leaking note
@@ -268,41 +307,41 @@ void NotePool::applyLegato(note_t note, const LegatoParams &par, PortamentoRealt
                 std::cerr << "failed to create legato note: " << ba.what() << std::endl;
             }
     }
+    indexKeys();
 }
 
 void NotePool::makeUnsustainable(note_t note)
 {
-    for(auto &desc:activeDesc()) {
-        if(desc.note == note) {
-            desc.makeUnsustainable();
-            if(desc.sustained())
-                release(desc);
-        }
+    for(auto &desc:keyDesc(note)) {
+        desc.makeUnsustainable();
+        if(desc.sustained())
+            release(desc);
     }
 }
 
 bool NotePool::full(void) const
 {
-    for(int i=0; i<POLYPHONY; ++i)
-        if(ndesc[i].off())
-            return false;
-    return true;
+    if(needs_cleaning)
+        const_cast<NotePool*>(this)->cleanup();
+
+    return ndesc_used == max_notes;
 }
 
 bool NotePool::synthFull(int sdesc_count) const
 {
-    int actually_free=sizeof(sdesc)/sizeof(sdesc[0]);
-    for(const auto &desc:activeDesc()) {
-        actually_free -= desc.size;
-    }
-    return actually_free < sdesc_count;
+    if(needs_cleaning)
+        const_cast<NotePool*>(this)->cleanup();
+
+    return max_notes*EXPECTED_USAGE - sdesc_used < sdesc_count;
 }
 
 //Note that isn't KEY_PLAYING or KEY_RELEASED_AND_SUSTAINED
 bool NotePool::existsRunningNote(void) const
 {
-    //printf("running note # =%d\n", getRunningNotes());
-    return getRunningNotes();
+    for(auto &desc:activeDesc())
+        if(desc.playing() || desc.sustained() || desc.latched())
+            return true;
+    return false;
 }
 
 int NotePool::getRunningNotes(void) const
@@ -323,6 +362,10 @@ int NotePool::getRunningNotes(void) const
 
 void NotePool::enforceKeyLimit(int limit)
 {
+    //Every running note has a descriptor
+    if(usedNoteDesc() <= limit)
+        return;
+
     int notes_to_kill = getRunningNotes() - limit;
     if(notes_to_kill <= 0)
         return;
@@ -382,32 +425,42 @@ void NotePool::limitVoice(int preferred_note)
     NoteDescriptor *oldest_playing = NULL;
     NoteDescriptor *oldest_playing_samenote = NULL;
 
+    // The candidates on the preferred note come from its key, from the
+    // oldest one
+    if (preferred_note >= 0 && preferred_note < 256) {
+        for(auto &nd : keyDesc(preferred_note)) {
+            if (nd.released()) {
+                if (!oldest_released_samenote || oldest_released_samenote->age)
+                    oldest_released_samenote = &nd;
+            } else if (nd.sustained()) {
+                if (!oldest_sustained_samenote || oldest_sustained_samenote->age)
+                    oldest_sustained_samenote = &nd;
+            } else if (nd.latched()) {
+                if (!oldest_latched_samenote || oldest_latched_samenote->age)
+                    oldest_latched_samenote = &nd;
+            } else if (nd.playing()) {
+                if (!oldest_playing_samenote || oldest_playing_samenote->age)
+                    oldest_playing_samenote = &nd;
+            }
+        }
+    }
+
+    // The descriptors are ordered from the oldest note, so the first of each
+    // kind is the oldest, and nothing is preferred over a released note
     for(auto &nd : activeDesc()) {
         // printf("Scanning %d (%s (%d), age %u)\n", nd.note, getStatus(nd.status), nd.status, nd.age);
         if (nd.released()) {
-            if (!oldest_released || nd.age > oldest_released->age)
-                oldest_released = &nd;
-            if (nd.note == preferred_note &&
-                (!oldest_released_samenote || oldest_released_samenote->age))
-                oldest_released_samenote = &nd;
+            oldest_released = &nd;
+            break;
         } else if (nd.sustained()) {
-            if (!oldest_sustained || nd.age > oldest_sustained->age)
+            if (!oldest_sustained)
                 oldest_sustained = &nd;
-            if (nd.note == preferred_note &&
-                (!oldest_sustained_samenote || oldest_sustained_samenote->age))
-                oldest_sustained_samenote = &nd;
         } else if (nd.latched()) {
-            if (!oldest_latched || nd.age > oldest_latched->age)
+            if (!oldest_latched)
                 oldest_latched = &nd;
-            if (nd.note == preferred_note &&
-                (!oldest_latched_samenote || oldest_latched_samenote->age))
-                oldest_latched_samenote = &nd;
         } else if (nd.playing()) {
-            if (!oldest_playing || nd.age > oldest_playing->age)
+            if (!oldest_playing)
                 oldest_playing = &nd;
-            if (nd.note == preferred_note &&
-                (!oldest_playing_samenote || oldest_playing_samenote->age))
-                oldest_playing_samenote = &nd;
         }
     }
 
@@ -504,10 +557,8 @@ void NotePool::killAllNotes(void)
 
 void NotePool::killNote(note_t note)
 {
-    for(auto &d:activeDesc()) {
-        if(d.note == note)
-            kill(d);
-    }
+    for(auto &d:keyDesc(note))
+        kill(d);
 }
 
 void NotePool::kill(NoteDescriptor &d)
@@ -538,59 +589,39 @@ void NotePool::cleanup(void)
     if(!needs_cleaning)
         return;
     needs_cleaning = false;
-    int new_length[POLYPHONY] = {};
-    int cur_length[POLYPHONY] = {};
     //printf("Cleanup Start\n");
     //dump();
 
-    //Identify the current length of all segments
-    //and the lengths discarding invalid entries
-
-    int last_valid_desc = 0;
-    for(int i=0; i<POLYPHONY; ++i)
-        if(!ndesc[i].off())
-            last_valid_desc = i;
-
-    //Find the real numbers of allocated notes
-    {
-        int cum_old = 0;
-
-        for(int i=0; i<=last_valid_desc; ++i) {
-            cur_length[i] = ndesc[i].size;
-            for(int j=0; j<ndesc[i].size; ++j)
-                new_length[i] += (bool)sdesc[cum_old++].note;
-        }
-    }
-
-
-    //Move the note descriptors
-    {
-        int cum_new = 0;
-        for(int i=0; i<=last_valid_desc; ++i) {
-            ndesc[i].size = new_length[i];
-            if(new_length[i] != 0)
-                ndesc[cum_new++] = ndesc[i];
-            else {
-                ndesc[i].setStatus(KEY_OFF);
-                if (ndesc[i].portamentoRealtime)
-                    ndesc[i].portamentoRealtime->memory.dealloc(ndesc[i].portamentoRealtime);
-            }
+    //Compact both pools in one pass, the order of the notes and of their
+    //synths is kept
+    int nd_new = 0;
+    int sd_new = 0;
+    for(int i=0; i<ndesc_used; ++i)
+        key_first[ndesc[i].note] = key_last[ndesc[i].note] = -1;
+    for(int i=0; i<ndesc_used; ++i) {
+        NoteDescriptor &nd = ndesc[i];
+        const int first = sd_new;
+        for(int j=nd.sdesc_id; j<nd.sdesc_id+nd.size; ++j)
+            if(sdesc[j].note)
+                sdesc[sd_new++] = sdesc[j];
+
+        nd.size = sd_new - first;
+        if(nd.size != 0) {
+            nd.sdesc_id = first;
+            ndesc[nd_new] = nd;
+            linkKey(nd_new++);
+        } else {
+            nd.setStatus(KEY_OFF);
+            if (nd.portamentoRealtime)
+                nd.portamentoRealtime->memory.dealloc(nd.portamentoRealtime);
         }
-        memset(ndesc+cum_new, 0, sizeof(*ndesc)*(POLYPHONY-cum_new));
-    }
-
-    //Move the synth descriptors
-    {
-        int total_notes=0;
-        for(int i=0; i<=last_valid_desc; ++i)
-            total_notes+=cur_length[i];
-
-        int cum_new = 0;
-        for(int i=0; i<total_notes; ++i)
-            if(sdesc[i].note)
-                sdesc[cum_new++] = sdesc[i];
-        memset(sdesc+cum_new, 0, sizeof(*sdesc)*(POLYPHONY*EXPECTED_USAGE-cum_new));
     }
+    memset(ndesc+nd_new, 0, sizeof(*ndesc)*(ndesc_used-nd_new));
+    for(int i=nd_new; i<ndesc_used; ++i)
+        ndesc[i].key_next = -1;
+    memset(sdesc+sd_new, 0, sizeof(*sdesc)*(sdesc_used-sd_new));
+    ndesc_used = nd_new;
+    sdesc_used = sd_new;
     //printf("Cleanup Done\n");
     //dump();
 }
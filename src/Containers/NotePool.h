@@ -21,6 +21,7 @@ namespace zyn {
 
 typedef uint8_t note_t; //Global MIDI note definition
 
+class Allocator;
 struct LegatoParams;
 class PortamentoRealtime;
 class NotePool
@@ -39,6 +40,11 @@ class NotePool
             uint8_t status;
             bool    legatoMirror;
             PortamentoRealtime *portamentoRealtime;
+            //first SynthDescriptor of this note (synth descriptors of one
+            //note are contiguous and in the order of the note descriptors)
+            uint16_t sdesc_id;
+            //next newer NoteDescriptor of the same note, -1 if none
+            int16_t key_next;
             bool operator==(NoteDescriptor);
 
             //status checks
@@ -67,10 +73,21 @@ class NotePool
         };
 
 
-        //Pool of notes
-        NoteDescriptor   ndesc[POLYPHONY];
-        SynthDescriptor  sdesc[POLYPHONY*EXPECTED_USAGE];
+        //Pool of notes, polyphony() note descriptors and
+        //polyphony()*EXPECTED_USAGE synth descriptors
+        //ndesc is ordered from the oldest to the newest note, which the
+        //voice stealing relies on
+        NoteDescriptor  *ndesc;
+        SynthDescriptor *sdesc;
         bool             needs_cleaning;
+        //Used prefixes of ndesc and sdesc (valid unless needs_cleaning)
+        int              ndesc_used;
+        int              sdesc_used;
+        //Oldest and newest note descriptor per key (-1 if none), the
+        //descriptors of a key are linked through key_next, so events for a
+        //key do not need to scan the pool
+        int16_t          key_first[256];
+        int16_t          key_last[256];
 
 
         //Iterators
@@ -84,11 +101,7 @@ class NotePool
         struct activeDescIter {
             activeDescIter(NotePool &_np):np(_np)
             {
-                int off=0;
-                for(int i=0; i<POLYPHONY; ++i, ++off)
-                    if(np.ndesc[i].status == 0)
-                        break;
-                _end = np.ndesc+off;
+                _end = np.ndesc+np.ndesc_used;
             }
             NoteDescriptor *begin() {return np.ndesc;};
             NoteDescriptor *end() { return _end; };
@@ -96,14 +109,24 @@ class NotePool
             NotePool &np;
         };
 
+        struct keyDescIter {
+            struct iterator {
+                NoteDescriptor &operator*() {return ndesc[i];}
+                iterator &operator++() {i = ndesc[i].key_next; return *this;}
+                bool operator!=(const iterator &o) const {return i != o.i;}
+                NoteDescriptor *ndesc;
+                int i;
+            };
+            iterator begin() {return iterator{ndesc, first};}
+            iterator end() {return iterator{ndesc, -1};}
+            NoteDescriptor *ndesc;
+            int first;
+        };
+
         struct constActiveDescIter {
             constActiveDescIter(const NotePool &_np):np(_np)
             {
-                int off=0;
-                for(int i=0; i<POLYPHONY; ++i, ++off)
-                    if(np.ndesc[i].status == 0)
-                        break;
-                _end = np.ndesc+off;
+                _end = np.ndesc+np.ndesc_used;
             }
             const NoteDescriptor *begin() const {return np.ndesc;};
             const NoteDescriptor *end() const { return _end; };
@@ -115,12 +138,23 @@ class NotePool
 
         activeDescIter activeDesc(void);
         constActiveDescIter activeDesc(void) const;
+        //Descriptors of one note, from the oldest to the newest. A note
+        //started while iterating may compact the pool, so the loop has to
+        //check the note of each descriptor.
+        keyDescIter keyDesc(note_t note);
 
         //Counts of descriptors used for tests
         int usedNoteDesc(void) const;
         int usedSynthDesc(void) const;
 
-        NotePool(void);
+        NotePool(Allocator &memory, int polyphony=POLYPHONY);
+        ~NotePool(void);
+        NotePool(const NotePool&) = delete;
+
+        int polyphony(void) const {return max_notes;}
+        //Change the number of notes, the pool must be empty
+        //@return false if the memory is exhausted, the pool is unchanged then
+        bool resize(int polyphony);
 
         //Operations
         void insertNote(note_t note, uint8_t sendto, SynthDescriptor desc,
@@ -134,6 +168,10 @@ class NotePool
 
         void releaseLatched();
 
+        //False if no descriptor is for the note, so an event for it has
+        //nothing to do (killed notes count until the next cleanup)
+        bool hasNote(note_t note) const {return key_first[note] >= 0;}
+
         bool full(void) const;
         bool synthFull(int sdesc_count) const;
 
@@ -161,6 +199,14 @@ class NotePool
         void cleanup(void);
 
         void dump(void);
+
+    private:
+        //Append ndesc[i] to the list of its key
+        void linkKey(int i);
+        void indexKeys(void);
+
+        Allocator &memory;
+        int        max_notes;
 };
 
 }
@@ -428,7 +428,16 @@ void AnalogFilter::filterout(float *smp)
 {
     STACKALLOC(float, freqbuf, freqbufsize);
 
-    if ( freq_smoothing.apply( freqbuf, freqbufsize, freq ) )
+    const bool moving = freq_smoothing.apply(freqbuf, freqbufsize, freq);
+    stagesout(smp, moving ? freqbuf : NULL);
+
+    for(int i = 0; i < buffersize; ++i)
+        smp[i] *= outgain;
+}
+
+void AnalogFilter::stagesout(float *smp, const float *freqbuf)
+{
+    if(freqbuf)
     {
         /* in transition, need to do fine grained interpolation */
         for(int i = 0; i < stages + 1; ++i)
@@ -444,9 +453,63 @@ void AnalogFilter::filterout(float *smp)
         for(int i = 0; i < stages + 1; ++i)
             singlefilterout(smp, history[i], freq, buffersize);
     }
+}
 
-    for(int i = 0; i < buffersize; ++i)
-        smp[i] *= outgain;
+void AnalogFilter::filterout(AnalogFilter &l, AnalogFilter &r,
+                             float *smpl, float *smpr)
+{
+    STACKALLOC(float, freqbufl, l.freqbufsize);
+    STACKALLOC(float, freqbufr, r.freqbufsize);
+
+    const bool movingl = l.freq_smoothing.apply(freqbufl, l.freqbufsize, l.freq);
+    const bool movingr = r.freq_smoothing.apply(freqbufr, r.freqbufsize, r.freq);
+
+    if(l.recompute) {
+        l.computefiltercoefs(l.freq, l.q);
+        l.recompute = false;
+    }
+    if(r.recompute) {
+        r.computefiltercoefs(r.freq, r.q);
+        r.recompute = false;
+    }
+
+    if(movingl || movingr || l.order != 2 || r.order != 2
+       || l.stages != r.stages || l.buffersize != r.buffersize) {
+        l.stagesout(smpl, movingl ? freqbufl : NULL);
+        r.stagesout(smpr, movingr ? freqbufr : NULL);
+    }
+    else {
+        /* both channels in the same loop, each with the operations of
+         * singlefilterout, so two independent recursions fill the pipeline */
+        const float coeffl[5] = {l.coeff.c[0], l.coeff.c[1], l.coeff.c[2],
+                                 l.coeff.d[1], l.coeff.d[2]};
+        const float coeffr[5] = {r.coeff.c[0], r.coeff.c[1], r.coeff.c[2],
+                                 r.coeff.d[1], r.coeff.d[2]};
+        for(int k = 0; k < l.stages + 1; ++k) {
+            fstage &hl = l.history[k], &hr = r.history[k];
+            float workl[4] = {hl.x1, hl.x2, hl.y1, hl.y2};
+            float workr[4] = {hr.x1, hr.x2, hr.y1, hr.y2};
+            for(int i = 0; i < l.buffersize; i += 2) {
+                AnalogBiquadFilterA(coeffl, smpl[i + 0], workl);
+                AnalogBiquadFilterA(coeffr, smpr[i + 0], workr);
+                AnalogBiquadFilterB(coeffl, smpl[i + 1], workl);
+                AnalogBiquadFilterB(coeffr, smpr[i + 1], workr);
+            }
+            hl.x1 = workl[0];
+            hl.x2 = workl[1];
+            hl.y1 = workl[2];
+            hl.y2 = workl[3];
+            hr.x1 = workr[0];
+            hr.x2 = workr[1];
+            hr.y1 = workr[2];
+            hr.y2 = workr[3];
+        }
+    }
+
+    for(int i = 0; i < l.buffersize; ++i)
+        smpl[i] *= l.outgain;
+    for(int i = 0; i < r.buffersize; ++i)
+        smpr[i] *= r.outgain;
 }
 
 float AnalogFilter::H(float freq)
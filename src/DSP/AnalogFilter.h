@@ -32,6 +32,12 @@ class AnalogFilter:public Filter
                      unsigned char Fstages, unsigned int srate, int bufsize);
         ~AnalogFilter();
         void filterout(float *smp);
+        /**Filter the left and right channel with two filters of the same type
+         * and stages (usually one per channel), interleaving their samples
+         * when no frequency is in transition. The outputs are the same as
+         * those of l.filterout(smpl) and r.filterout(smpr).*/
+        static void filterout(AnalogFilter &l, AnalogFilter &r,
+                              float *smpl, float *smpr);
         void setfreq(float frequency);
         void setfreq_and_q(float frequency, float q_);
         void setq(float q_);
@@ -63,6 +69,8 @@ class AnalogFilter:public Filter
 
         //Apply IIR filter to Samples, with coefficients, and past history
     void singlefilterout(float *smp, fstage &hist, float f, unsigned int bufsize);// const Coeff &coeff);
+        //All stages (without outgain), freqbuf is NULL unless in transition
+    void stagesout(float *smp, const float *freqbuf);
         //Update coeff and order
     void computefiltercoefs(float freq, float q);
 
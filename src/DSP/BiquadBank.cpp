@@ -0,0 +1,219 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BiquadBank.cpp - Vectorized Parallel Biquad Cascades
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "BiquadBank.h"
+#include "../globals.h"
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BIQUAD_BANK_X86 1
+#endif
+
+namespace zyn {
+
+//Sections of a cascade, as AnalogFilter runs stages + 1 of them
+#define BANK_MAX_SECTIONS (MAX_FILTER_STAGES + 1)
+
+/* One cascade at a time, for compilers without vector extensions */
+static void runScalar(float *bank, int ngroups, int nsections, bool ramp,
+                      const float *in, float *out, int buffersize)
+{
+    const int stride = BiquadBank::HEADER + nsections * BiquadBank::VALUES;
+    for(int g = 0; g < ngroups; ++g) {
+        float *grp = bank + g * stride;
+        for(int i = 0; i < buffersize; ++i) {
+            float x = in[i];
+            for(int s = 0; s < nsections; ++s) {
+                float *f = grp + BiquadBank::HEADER + s * BiquadBank::VALUES;
+                const float y = f[BiquadBank::C0] * x + f[BiquadBank::S1];
+                f[BiquadBank::S1] = f[BiquadBank::C1] * x
+                                  + f[BiquadBank::D1] * y + f[BiquadBank::S2];
+                f[BiquadBank::S2] = f[BiquadBank::C2] * x
+                                  + f[BiquadBank::D2] * y;
+                if(ramp)
+                    for(int v = BiquadBank::C0; v <= BiquadBank::D2; ++v)
+                        f[v] += f[v + BiquadBank::DC0];
+                x = y;
+            }
+            out[i] += x * grp[BiquadBank::GAIN];
+            if(ramp)
+                grp[BiquadBank::GAIN] += grp[BiquadBank::DGAIN];
+        }
+    }
+}
+
+static const BiquadBank bankScalar = {runScalar, 1, "scalar"};
+
+#ifdef __GNUC__
+
+//Samples accumulated before the sums of the lanes are added to the output
+#define BANK_BLOCK 64
+
+#define LOADV(v, p)  __builtin_memcpy(&(v), (p), sizeof(v))
+#define STOREV(p, v) __builtin_memcpy((p), &(v), sizeof(v))
+
+//Vector of W floats (a dependent vector_size is not supported by GCC)
+template<int W> struct BiquadVec;
+template<> struct BiquadVec<4>  { typedef float type __attribute__((vector_size(16))); };
+template<> struct BiquadVec<8>  { typedef float type __attribute__((vector_size(32))); };
+template<> struct BiquadVec<16> { typedef float type __attribute__((vector_size(64))); };
+
+/* The section count and the ramp are template parameters, so the whole
+ * cascade of a group stays in registers and a steady bank does not pay
+ * for the interpolation. */
+template<int W, int S, bool R>
+static inline __attribute__((always_inline))
+void runBank(float *bank, int ngroups, const float *in, float *out,
+             int buffersize)
+{
+    typedef typename BiquadVec<W>::type vf;
+    enum {V = BiquadBank::VALUES, H = BiquadBank::HEADER};
+    const int stride = (H + S * V) * W;
+
+    for(int i0 = 0; i0 < buffersize; i0 += BANK_BLOCK) {
+        const int n = buffersize - i0 < BANK_BLOCK ? buffersize - i0 : BANK_BLOCK;
+        vf acc[BANK_BLOCK];
+        for(int i = 0; i < n; ++i)
+            acc[i] = (vf){};
+
+        for(int g = 0; g < ngroups; ++g) {
+            float *grp = bank + g * stride;
+            vf gain, dgain, f[S][V];
+            LOADV(gain,  grp + BiquadBank::GAIN * W);
+            LOADV(dgain, grp + BiquadBank::DGAIN * W);
+            for(int s = 0; s < S; ++s)
+                for(int v = 0; v < V; ++v)
+                    LOADV(f[s][v], grp + (H + s * V + v) * W);
+
+            for(int i = 0; i < n; ++i) {
+                vf x = (vf){} + in[i0 + i];
+                for(int s = 0; s < S; ++s) {
+                    const vf y = f[s][BiquadBank::C0] * x + f[s][BiquadBank::S1];
+                    f[s][BiquadBank::S1] = f[s][BiquadBank::C1] * x
+                                         + f[s][BiquadBank::D1] * y
+                                         + f[s][BiquadBank::S2];
+                    f[s][BiquadBank::S2] = f[s][BiquadBank::C2] * x
+                                         + f[s][BiquadBank::D2] * y;
+                    if(R)
+                        for(int v = BiquadBank::C0; v <= BiquadBank::D2; ++v)
+                            f[s][v] += f[s][v + BiquadBank::DC0];
+                    x = y;
+                }
+                acc[i] += x * gain;
+                if(R)
+                    gain += dgain;
+            }
+
+            if(R)
+                STOREV(grp + BiquadBank::GAIN * W, gain);
+            for(int s = 0; s < S; ++s)
+                for(int v = 0; v < V; ++v)
+                    if(R || v >= BiquadBank::S1)
+                        STOREV(grp + (H + s * V + v) * W, f[s][v]);
+        }
+
+        for(int i = 0; i < n; ++i)
+            for(int l = 0; l < W; ++l)
+                out[i0 + i] += acc[i][l];
+    }
+}
+
+template<int W, bool R>
+static inline __attribute__((always_inline))
+void runBankSections(float *bank, int ngroups, int nsections,
+                     const float *in, float *out, int buffersize)
+{
+    static_assert(BANK_MAX_SECTIONS == 6, "one case per section count");
+    switch(nsections) {
+        case 1: runBank<W, 1, R>(bank, ngroups, in, out, buffersize); break;
+        case 2: runBank<W, 2, R>(bank, ngroups, in, out, buffersize); break;
+        case 3: runBank<W, 3, R>(bank, ngroups, in, out, buffersize); break;
+        case 4: runBank<W, 4, R>(bank, ngroups, in, out, buffersize); break;
+        case 5: runBank<W, 5, R>(bank, ngroups, in, out, buffersize); break;
+        case 6: runBank<W, 6, R>(bank, ngroups, in, out, buffersize); break;
+    }
+}
+
+template<int W>
+static inline __attribute__((always_inline))
+void runBankRamp(float *bank, int ngroups, int nsections, bool ramp,
+                 const float *in, float *out, int buffersize)
+{
+    if(ramp)
+        runBankSections<W, true>(bank, ngroups, nsections, in, out, buffersize);
+    else
+        runBankSections<W, false>(bank, ngroups, nsections, in, out, buffersize);
+}
+
+//4 lanes with the baseline instruction set (SSE2 on x86_64, NEON on AArch64)
+static void runGeneric(float *bank, int ngroups, int nsections, bool ramp,
+                       const float *in, float *out, int buffersize)
+{
+    runBankRamp<4>(bank, ngroups, nsections, ramp, in, out, buffersize);
+}
+
+static const BiquadBank bankGeneric = {runGeneric, 4, "generic"};
+
+#ifdef BIQUAD_BANK_X86
+__attribute__((target("avx2")))
+static void runAVX2(float *bank, int ngroups, int nsections, bool ramp,
+                    const float *in, float *out, int buffersize)
+{
+    runBankRamp<8>(bank, ngroups, nsections, ramp, in, out, buffersize);
+}
+
+__attribute__((target("avx512f")))
+static void runAVX512(float *bank, int ngroups, int nsections, bool ramp,
+                      const float *in, float *out, int buffersize)
+{
+    runBankRamp<16>(bank, ngroups, nsections, ramp, in, out, buffersize);
+}
+
+static const BiquadBank bankAVX2   = {runAVX2,   8,  "avx2"};
+static const BiquadBank bankAVX512 = {runAVX512, 16, "avx512"};
+#endif
+
+#endif
+
+const BiquadBank *BiquadBank::find(const char *name)
+{
+    if(!strcmp(name, "scalar"))
+        return &bankScalar;
+#ifdef __GNUC__
+    if(!strcmp(name, "generic"))
+        return &bankGeneric;
+#endif
+#ifdef BIQUAD_BANK_X86
+    __builtin_cpu_init();
+    if(!strcmp(name, "avx2") && __builtin_cpu_supports("avx2"))
+        return &bankAVX2;
+    if(!strcmp(name, "avx512") && __builtin_cpu_supports("avx512f"))
+        return &bankAVX512;
+#endif
+    return nullptr;
+}
+
+static const BiquadBank &pickBank(void)
+{
+    static const char *order[] = {"avx512", "avx2", "generic"};
+    for(const char *name:order)
+        if(const BiquadBank *bank = BiquadBank::find(name))
+            return *bank;
+    return bankScalar;
+}
+
+const BiquadBank &BiquadBank::best(void)
+{
+    static const BiquadBank &bank = pickBank();
+    return bank;
+}
+
+}
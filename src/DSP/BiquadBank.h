@@ -0,0 +1,72 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BiquadBank.h - Vectorized Parallel Biquad Cascades
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+
+namespace zyn {
+
+/**
+ * Runs independent biquad cascades side by side, one per vector lane.
+ *
+ * The formants of FormantFilter all filter the same input, so they are
+ * packed into groups of `lanes` (4 for SSE2/NEON, 8 for AVX2, 16 for
+ * AVX-512) and one instruction advances the same section of a whole group.
+ * The sections are in transposed direct form II with the coefficients of
+ * AnalogFilter (y = c0 x + c1 x1 + c2 x2 + d1 y1 + d2 y2), so each keeps
+ * two values of state. The bank is a plain float array:
+ *
+ *     group g: gain, dgain [lanes each], then per section:
+ *              c0, c1, c2, d1, d2, dc0, dc1, dc2, dd1, dd2, s1, s2 [lanes each]
+ *
+ * When run with ramp, the gains and coefficients advance by their delta
+ * every sample, which interpolates them towards new values over a buffer.
+ * Stable biquad denominators form a convex set, so a linear ramp between
+ * two stable filters stays stable.
+ * Unused lanes of the last group must be zeroed, so they stay silent.
+ */
+struct BiquadBank
+{
+    enum {GAIN, DGAIN, HEADER};
+    enum {C0, C1, C2, D1, D2, DC0, DC1, DC2, DD1, DD2, S1, S2, VALUES};
+
+    /**Filter in through every cascade, add the cascade outputs multiplied
+     * by their gain to out and update the bank (state and, with ramp, the
+     * gains and coefficients)*/
+    void (*run)(float *bank, int ngroups, int nsections, bool ramp,
+                const float *in, float *out, int buffersize);
+
+    int lanes;
+    const char *name;
+
+    int groups(int ncascades) const {
+        return (ncascades + lanes - 1) / lanes;
+    }
+    //! Size of the bank in floats
+    int size(int ncascades, int nsections) const {
+        return groups(ncascades) * (HEADER + nsections * VALUES) * lanes;
+    }
+    //! Offset of header value v (GAIN, DGAIN) of cascade n
+    int header(int nsections, int n, int v) const {
+        return (n / lanes) * (HEADER + nsections * VALUES) * lanes
+               + v * lanes + n % lanes;
+    }
+    //! Offset of value v (C0 ... S2) of section s of cascade n
+    int value(int nsections, int n, int s, int v) const {
+        return header(nsections, n, GAIN) + (HEADER + s * VALUES + v) * lanes;
+    }
+
+    //! Widest bank supported by this CPU ("scalar" without vector support)
+    static const BiquadBank &best(void);
+    //! Bank "scalar", "generic", "avx2" or "avx512" or NULL if unsupported
+    static const BiquadBank *find(const char *name);
+};
+
+}
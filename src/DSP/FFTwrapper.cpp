@@ -14,44 +14,47 @@
 #include <cmath>
 #include <cassert>
 #include <cstring>
-#include <pthread.h>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
 #include "FFTwrapper.h"
 
 namespace zyn {
 
-static pthread_mutex_t *mutex = NULL;
+//The fftw planner is not thread-safe, everything touching it holds this
+static std::mutex plan_mutex;
+
+struct FFTplans {
+    fftwf_plan fwd, inv;
+};
+//Plans of every fftsize used so far
+static std::map<int, FFTplans> plans;
+static unsigned plan_flags = FFTW_ESTIMATE;
 
 FFTwrapper::FFTwrapper(int fftsize_) : m_fftsize(fftsize_)
 {
-    //first one will spawn the mutex (yeah this may be a race itself)
-    if(!mutex) {
-        mutex = new pthread_mutex_t;
-        pthread_mutex_init(mutex, NULL);
+    std::lock_guard<std::mutex> lock(plan_mutex);
+    auto itr = plans.find(m_fftsize);
+    if(itr == plans.end()) {
+        //The arrays are only needed for planning, the plans are executed on
+        //the buffers of the callers. Like those, they are aligned by new[]
+        fftwf_real    *time = new fftwf_real[m_fftsize];
+        fftwf_complex *fft  = new fftwf_complex[m_fftsize + 1];
+        FFTplans p;
+        p.fwd = fftwf_plan_dft_r2c_1d(m_fftsize, time, fft, plan_flags);
+        p.inv = fftwf_plan_dft_c2r_1d(m_fftsize, fft, time, plan_flags);
+        delete [] time;
+        delete [] fft;
+        itr = plans.emplace(m_fftsize, p).first;
     }
-
-    time      = new fftwf_real[m_fftsize];
-    fft       = new fftwf_complex[m_fftsize + 1];
-    pthread_mutex_lock(mutex);
-    planfftw = fftwf_plan_dft_r2c_1d(m_fftsize,
-                                    time,
-                                    fft,
-                                    FFTW_ESTIMATE);
-    planfftw_inv = fftwf_plan_dft_c2r_1d(m_fftsize,
-                                        fft,
-                                        time,
-                                        FFTW_ESTIMATE);
-    pthread_mutex_unlock(mutex);
+    planfftw     = itr->second.fwd;
+    planfftw_inv = itr->second.inv;
 }
 
 FFTwrapper::~FFTwrapper()
 {
-    pthread_mutex_lock(mutex);
-    fftwf_destroy_plan(planfftw);
-    fftwf_destroy_plan(planfftw_inv);
-    pthread_mutex_unlock(mutex);
-
-    delete [] time;
-    delete [] fft;
+    //The plans stay in the registry for the next wrapper of this size
 }
 
 void FFTwrapper::smps2freqs(const FFTsampleBuffer smps, FFTfreqBuffer freqs, FFTsampleBuffer scratch) const
@@ -99,12 +102,98 @@ void FFTwrapper::freqs2smps_noconst_input(FFTfreqBuffer freqs, FFTsampleBuffer s
     fftwf_execute_dft_c2r(planfftw_inv, freqs_complex, smps.data);
 }
 
+/*
+ * Buffer pool
+ *
+ * Each buffer is preceded by a header which stores its size, so it can be
+ * put back into the free list of its size. Released buffers are kept until
+ * max_pooled bytes are reached, which covers the buffers of the OscilGens of
+ * a loaded instrument being freed and allocated again.
+ */
+#define FFT_BUFFER_HEADER 64 //keeps the data aligned like fftwf_malloc()
+static const std::size_t max_pooled = 16 << 20;
+
+static std::mutex buffer_mutex;
+static std::map<std::size_t, std::vector<void*>> free_buffers;
+static std::size_t pooled = 0;
+
+void *FFT_allocBuffer(std::size_t bytes)
+{
+    void *buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex);
+        auto itr = free_buffers.find(bytes);
+        if(itr != free_buffers.end() && !itr->second.empty()) {
+            buffer = itr->second.back();
+            itr->second.pop_back();
+            pooled -= bytes;
+        }
+    }
+    if(!buffer) {
+        char *mem = (char*)fftwf_malloc(FFT_BUFFER_HEADER + bytes);
+        if(!mem)
+            throw std::bad_alloc();
+        *(std::size_t*)mem = bytes;
+        buffer = mem + FFT_BUFFER_HEADER;
+    }
+    //new fft_t[] used to value-initialize the freqs, keep them cleared
+    memset(buffer, 0, bytes);
+    return buffer;
+}
+
+void FFT_freeBuffer(void *buffer)
+{
+    if(!buffer)
+        return;
+    char *mem = (char*)buffer - FFT_BUFFER_HEADER;
+    const std::size_t bytes = *(std::size_t*)mem;
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex);
+        if(pooled + bytes <= max_pooled) {
+            free_buffers[bytes].push_back(buffer);
+            pooled += bytes;
+            return;
+        }
+    }
+    fftwf_free(mem);
+}
+
 void FFT_cleanup()
 {
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex);
+        for(auto &list:free_buffers)
+            for(void *buffer:list.second)
+                fftwf_free((char*)buffer - FFT_BUFFER_HEADER);
+        free_buffers.clear();
+        pooled = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(plan_mutex);
+    for(auto &p:plans) {
+        fftwf_destroy_plan(p.second.fwd);
+        fftwf_destroy_plan(p.second.inv);
+    }
+    plans.clear();
     fftwf_cleanup();
-    pthread_mutex_destroy(mutex);
-    delete mutex;
-    mutex = NULL;
+}
+
+void FFT_measurePlans(bool measure)
+{
+    std::lock_guard<std::mutex> lock(plan_mutex);
+    plan_flags = measure ? FFTW_MEASURE : FFTW_ESTIMATE;
+}
+
+bool FFT_loadWisdom(const char *filename)
+{
+    std::lock_guard<std::mutex> lock(plan_mutex);
+    return fftwf_import_wisdom_from_filename(filename);
+}
+
+bool FFT_saveWisdom(const char *filename)
+{
+    std::lock_guard<std::mutex> lock(plan_mutex);
+    return fftwf_export_wisdom_to_filename(filename);
 }
 
 }
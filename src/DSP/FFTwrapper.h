@@ -19,6 +19,12 @@
 
 namespace zyn {
 
+/**Buffers for FFTs, aligned for SIMD and recycled by size
+ * Everything returned by allocFreqBuf()/allocSampleBuf() without a pointer
+ * has to be released with FFT_freeBuffer() instead of delete[]*/
+void *FFT_allocBuffer(std::size_t bytes);
+void FFT_freeBuffer(void *buffer);
+
 //! Struct to make sure FFT sizes fit. *Not* an RAII class
 struct FFTfreqBuffer
 {
@@ -37,7 +43,7 @@ struct FFTfreqBuffer
 private:
     FFTfreqBuffer(int fftsize, fft_t* ptr = nullptr) : // called by FFTwrapper
         fftsize(fftsize),
-        data(ptr ? ptr : new fft_t[allocSize()])
+        data(ptr ? ptr : (fft_t*)FFT_allocBuffer(allocSize() * sizeof(fft_t)))
     {}
 };
 
@@ -57,13 +63,15 @@ struct FFTsampleBuffer
 private:
     FFTsampleBuffer(int fftsize, float* ptr = nullptr) : // called by FFTwrapper
         fftsize(fftsize),
-        data(ptr ? ptr : new float[allocSize()])
+        data(ptr ? ptr : (float*)FFT_allocBuffer(allocSize() * sizeof(float)))
     {}
 };
 
 /**
     A wrapper for the FFTW library (Fast Fourier Transforms)
     All methods (except CTOR/DTOR) are static/const. This class is thread-safe.
+    The plans are shared by all wrappers of one size and live until
+    FFT_cleanup(), so creating a wrapper of a known size is cheap.
 */
 class FFTwrapper
 {
@@ -94,9 +102,7 @@ class FFTwrapper
 
     private:
         const int     m_fftsize;
-        fftwf_real    *time; // only used when creating plan
-        fftwf_complex *fft;  // only used when creating plan
-        fftwf_plan    planfftw, planfftw_inv;
+        fftwf_plan    planfftw, planfftw_inv; // owned by the plan registry
 };
 
 /*
@@ -118,8 +124,17 @@ FFTpolar(const _Tp& __rho, const _Tp& __theta = _Tp(0))
         return std::complex<_Tp>(__x, __y);
 }
 
+//! Destroy the shared plans and the pooled buffers
 void FFT_cleanup();
 
+//! Plan with FFTW_MEASURE instead of FFTW_ESTIMATE from now on.
+//! Measuring is slow, so it is only worth it with saved wisdom.
+void FFT_measurePlans(bool measure);
+//! Load FFTW wisdom, returns false if there was none to load
+bool FFT_loadWisdom(const char *filename);
+//! Save the wisdom of all the plans made so far
+bool FFT_saveWisdom(const char *filename);
+
 }
 
 #endif
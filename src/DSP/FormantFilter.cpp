@@ -13,21 +13,26 @@
 
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include "../Misc/Util.h"
 #include "../Misc/Allocator.h"
 #include "FormantFilter.h"
 #include "AnalogFilter.h"
+#include "BiquadBank.h"
 #include "../Params/FilterParams.h"
 
 namespace zyn {
 
 FormantFilter::FormantFilter(const FilterParams *pars, Allocator *alloc, unsigned int srate, int bufsize)
-    :Filter(srate, bufsize), memory(*alloc)
+    :Filter(srate, bufsize), kernels(BiquadBank::best()), memory(*alloc)
 {
     numformants = pars->Pnumformants;
-    for(int i = 0; i < numformants; ++i)
-        formant[i] = memory.alloc<AnalogFilter>(4 /*BPF*/, 1000.0f, 10.0f, pars->Pstages, srate, bufsize);
-    cleanup();
+    sections    = (pars->Pstages < MAX_FILTER_STAGES ? pars->Pstages
+                   : MAX_FILTER_STAGES) + 1;
+    bank = memory.valloc<float>(kernels.size(numformants, sections));
+    //unused lanes stay zero and silent
+    memset(bank, 0, kernels.size(numformants, sections) * sizeof(float));
+    ramping = false;
 
     for(int j = 0; j < FF_MAX_VOWELS; ++j)
         for(int i = 0; i < numformants; ++i) {
@@ -39,12 +44,6 @@ FormantFilter::FormantFilter(const FilterParams *pars, Allocator *alloc, unsigne
                 pars->Pvowels[j].formants[i].q);
         }
 
-    for(int i = 0; i < FF_MAX_FORMANTS; ++i)
-    {
-        formant_amp_smoothing[i].sample_rate(srate);
-        formant_amp_smoothing[i].reset(1.0f);
-    }
-
     for(int i = 0; i < numformants; ++i) {
         currentformants[i].freq = 1000.0f;
         currentformants[i].amp  = 1.0f;
@@ -71,18 +70,58 @@ FormantFilter::FormantFilter(const FilterParams *pars, Allocator *alloc, unsigne
     Qfactor = pars->getq();
     oldQfactor = Qfactor;
     firsttime  = true;
+
+    for(int i = 0; i < numformants; ++i)
+        setformant(i, false);
 }
 
 FormantFilter::~FormantFilter()
 {
-    for(int i = 0; i < numformants; ++i)
-        memory.dealloc(formant[i]);
+    memory.devalloc(bank);
 }
 
 void FormantFilter::cleanup()
 {
     for(int i = 0; i < numformants; ++i)
-        formant[i]->cleanup();
+        for(int s = 0; s < sections; ++s) {
+            bank[kernels.value(sections, i, s, BiquadBank::S1)] = 0.0f;
+            bank[kernels.value(sections, i, s, BiquadBank::S2)] = 0.0f;
+        }
+}
+
+void FormantFilter::setformant(int i, bool ramp)
+{
+    int order = 0; //always 2 for the band pass filter
+    const AnalogFilter::Coeff coeff =
+        AnalogFilter::computeCoeff(4 /*BPF*/, currentformants[i].freq,
+                                   currentformants[i].q * Qfactor,
+                                   sections - 1, 1.0f, samplerate_f, order);
+    target[i].value[0] = coeff.c[0];
+    target[i].value[1] = coeff.c[1];
+    target[i].value[2] = coeff.c[2];
+    target[i].value[3] = coeff.d[1];
+    target[i].value[4] = coeff.d[2];
+    target[i].amp      = currentformants[i].amp;
+    loadformant(i, ramp);
+}
+
+void FormantFilter::loadformant(int i, bool ramp)
+{
+    const float step = ramp ? 1.0f / buffersize_f : 0.0f;
+    for(int s = 0; s < sections; ++s)
+        for(int v = 0; v < 5; ++v) {
+            float &cur = bank[kernels.value(sections, i, s, BiquadBank::C0 + v)];
+            bank[kernels.value(sections, i, s, BiquadBank::DC0 + v)] =
+                (target[i].value[v] - cur) * step;
+            if(!ramp)
+                cur = target[i].value[v];
+        }
+    float &gain = bank[kernels.header(sections, i, BiquadBank::GAIN)];
+    bank[kernels.header(sections, i, BiquadBank::DGAIN)] =
+        (target[i].amp - gain) * step;
+    if(!ramp)
+        gain = target[i].amp;
+    ramping |= ramp;
 }
 
 inline float log_2(float x)
@@ -140,8 +179,7 @@ void FormantFilter::setpos(float frequency)
                 * (1.0f - pos) + formantpar[p2][i].amp * pos;
             currentformants[i].q =
                 formantpar[p1][i].q * (1.0f - pos) + formantpar[p2][i].q * pos;
-            formant[i]->setfreq_and_q(currentformants[i].freq,
-                                      currentformants[i].q * Qfactor);
+            setformant(i, false);
         }
         firsttime = false;
     }
@@ -165,8 +203,7 @@ void FormantFilter::setpos(float frequency)
                                       * pos) * formantslowness;
 
 
-            formant[i]->setfreq_and_q(currentformants[i].freq,
-                                      currentformants[i].q * Qfactor);
+            setformant(i, true);
         }
 
     oldQfactor = Qfactor;
@@ -181,7 +218,7 @@ void FormantFilter::setq(float q_)
 {
     Qfactor = q_;
     for(int i = 0; i < numformants; ++i)
-        formant[i]->setq(Qfactor * currentformants[i].q);
+        setformant(i, !firsttime);
 }
 
 void FormantFilter::setgain(float /*dBgain*/)
@@ -198,30 +235,18 @@ void FormantFilter::filterout(float *smp)
 {
     STACKALLOC(float, inbuffer, buffersize);
 
-    memcpy(inbuffer, smp, bufferbytes);
+    for(int i = 0; i < buffersize; ++i)
+        inbuffer[i] = smp[i] * outgain;
     memset(smp, 0, bufferbytes);
 
-    STACKALLOC(float, formantbuf, buffersize);
-
-    for(int j = 0; j < numformants; ++j) {
+    kernels.run(bank, kernels.groups(numformants), sections, ramping,
+                inbuffer, smp, buffersize);
 
-        STACKALLOC(float, tmpbuf, buffersize);
-
-        for(int i = 0; i < buffersize; ++i)
-            tmpbuf[i] = inbuffer[i] * outgain;
-
-        formant[j]->filterout(tmpbuf);
-
-        if ( formant_amp_smoothing[j].apply( formantbuf, buffersize, currentformants[j].amp ) )
-        {
-            for(int i = 0; i < buffersize; ++i)
-                smp[i] += tmpbuf[i] * formantbuf[i];
-        }
-        else
-        {
-            for(int i = 0; i < buffersize; ++i)
-                smp[i] += tmpbuf[i] * currentformants[j].amp;
-        }
+    if(ramping) {
+        //land exactly on the targets instead of the sums of the deltas
+        for(int i = 0; i < numformants; ++i)
+            loadformant(i, false);
+        ramping = false;
     }
 }
 
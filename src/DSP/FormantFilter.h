@@ -16,7 +16,6 @@
 
 #include "../globals.h"
 #include "Filter.h"
-#include "Value_Smoothing_Filter.h"
 
 namespace zyn {
 
@@ -35,9 +34,21 @@ class FormantFilter:public Filter
 
     private:
         void setpos(float input);
-
-
-        class AnalogFilter * formant[FF_MAX_FORMANTS];
+        //Coefficients and gain of formant i for the current formants, with
+        //ramp they are reached over the next buffer
+        void setformant(int i, bool ramp);
+        //Set the bank of formant i to its target (or ramp towards it)
+        void loadformant(int i, bool ramp);
+
+        /* The formants are the cascades of a BiquadBank (all band pass
+         * filters of the same input), their output gain is the amplitude */
+        const struct BiquadBank &kernels;
+        float *bank;
+        int    sections; //stages + 1, as in AnalogFilter
+        bool   ramping;  //the bank has deltas towards the targets below
+        struct {
+            float value[5], amp; //c0, c1, c2, d1, d2 of every section
+        } target[FF_MAX_FORMANTS];
 
         struct {
             float freq, amp, q; //frequency,amplitude,Q
@@ -54,8 +65,6 @@ class FormantFilter:public Filter
         float Qfactor, formantslowness, oldQfactor;
         float vowelclearness, sequencestretch;
         Allocator &memory;
-
-        Value_Smoothing_Filter formant_amp_smoothing[FF_MAX_FORMANTS];
 };
 
 }
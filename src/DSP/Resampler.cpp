@@ -0,0 +1,177 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  Resampler.cpp - Streaming Windowed Sinc Sample Rate Converter
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "Resampler.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(__x86_64__)
+#define RESAMPLER_SSE 1
+#include <xmmintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define RESAMPLER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace zyn {
+
+//Sub sample positions of the tabulated filter
+#define RESAMPLER_PHASES 512
+//Zero crossings of the sinc on each side (at the full bandwidth)
+#define RESAMPLER_ZEROS 16
+//Kaiser window shape, about 90 dB stopband attenuation
+#define RESAMPLER_BETA 9.0
+
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for(int k = 1; k < 50 && term > sum * 1e-12; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum  += term;
+    }
+    return sum;
+}
+
+//Cutoff relative to the Nyquist frequency of the input
+static double cutoff(unsigned srcrate, unsigned dstrate)
+{
+    return 0.95 * std::min(1.0, (double)dstrate / srcrate);
+}
+
+//n is a multiple of 4
+static inline float dot(const float *x, const float *k, int n)
+{
+#if RESAMPLER_SSE
+    __m128 acc = _mm_setzero_ps();
+    for(int i = 0; i < n; i += 4)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(k + i)));
+    float part[4];
+    _mm_storeu_ps(part, acc);
+    return (part[0] + part[1]) + (part[2] + part[3]);
+#elif RESAMPLER_NEON
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for(int i = 0; i < n; i += 4)
+        acc = vmlaq_f32(acc, vld1q_f32(x + i), vld1q_f32(k + i));
+    return vaddvq_f32(acc);
+#else
+    float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for(int i = 0; i < n; i += 4)
+        for(int j = 0; j < 4; ++j)
+            acc[j] += x[i + j] * k[i + j];
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+#endif
+}
+
+Resampler::Resampler(unsigned srcrate_, unsigned dstrate_, int maxwrite)
+    :srcrate(srcrate_), dstrate(dstrate_),
+    step((double)srcrate_ / dstrate_),
+    half((int)ceil(RESAMPLER_ZEROS / cutoff(srcrate_, dstrate_))),
+    taps((2 * half + 3) & ~3)
+{
+    const double fc = cutoff(srcrate, dstrate);
+    const double i0 = besselI0(RESAMPLER_BETA);
+
+    table = new float[(RESAMPLER_PHASES + 1) * taps];
+    for(int p = 0; p <= RESAMPLER_PHASES; ++p) {
+        float *row = table + p * taps;
+        double sum = 0.0;
+        for(int i = 0; i < taps; ++i) {
+            //distance of the input sample from the output position
+            const double x = i - half + 1 - (double)p / RESAMPLER_PHASES;
+            const double w = x / half;
+            double h = 0.0;
+            if(i < 2 * half && fabs(w) <= 1.0) {
+                const double s = fc * x == 0.0 ? 1.0
+                                 : sin(PI * fc * x) / (PI * fc * x);
+                h = fc * s * besselI0(RESAMPLER_BETA * sqrt(1.0 - w * w)) / i0;
+            }
+            row[i] = h;
+            sum   += h;
+        }
+        //unity gain at DC for every phase
+        for(int i = 0; i < taps; ++i)
+            row[i] /= sum;
+    }
+    kernel = new float[taps];
+
+    size  = maxwrite + taps + 8;
+    bufl  = new float[size]();
+    bufr  = new float[size]();
+    //the first output is at the first input sample, with silence before
+    count = half - 1;
+    pos   = half - 1;
+    frac  = 0.0;
+}
+
+Resampler::~Resampler()
+{
+    delete [] table;
+    delete [] kernel;
+    delete [] bufl;
+    delete [] bufr;
+}
+
+int Resampler::available(void) const
+{
+    //the last tap of an output must be buffered
+    const int last = count - half - pos;
+    if(last <= 0)
+        return 0;
+    return std::max(0, (int)ceil((last - frac) / step));
+}
+
+void Resampler::write(const float *l, const float *r, int n)
+{
+    //drop the samples which no output needs anymore
+    const int first = pos - half + 1;
+    if(first > 0) {
+        memmove(bufl, bufl + first, (count - first) * sizeof(float));
+        memmove(bufr, bufr + first, (count - first) * sizeof(float));
+        count -= first;
+        pos   -= first;
+    }
+
+    //the taps may read a few samples beyond count, which are multiplied
+    //with 0 and must stay finite
+    assert(count + n + 3 < size);
+    n = std::min(n, size - 4 - count);
+    memcpy(bufl + count, l, n * sizeof(float));
+    memcpy(bufr + count, r, n * sizeof(float));
+    count += n;
+}
+
+void Resampler::read(float *outl, float *outr, int n)
+{
+    assert(n <= available());
+    for(int k = 0; k < n; ++k) {
+        const float  phase = frac * RESAMPLER_PHASES;
+        const int    p     = std::min((int)phase, RESAMPLER_PHASES - 1);
+        const float  a     = phase - p;
+        const float *t0    = table + p * taps;
+        const float *t1    = t0 + taps;
+        for(int i = 0; i < taps; ++i)
+            kernel[i] = t0[i] + a * (t1[i] - t0[i]);
+
+        const int start = pos - half + 1;
+        outl[k] = dot(bufl + start, kernel, taps);
+        outr[k] = dot(bufr + start, kernel, taps);
+
+        frac += step;
+        const int skip = (int)frac;
+        pos  += skip;
+        frac -= skip;
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  Resampler.h - Streaming Windowed Sinc Sample Rate Converter
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include "../globals.h"
+
+namespace zyn {
+
+/**
+ * Converts a stereo stream between two arbitrary sample rates.
+ *
+ * The Kaiser windowed sinc is tabulated at RESAMPLER_PHASES positions
+ * between two input samples (polyphase) and interpolated linearly between
+ * the two nearest phases. Its cutoff is at the lower Nyquist frequency, so
+ * the filter gets longer when going down in rate.
+ * Input is pushed with write() and converted lazily by read(), neither
+ * allocates memory.
+ */
+class Resampler
+{
+    public:
+        /**@param maxwrite largest number of samples passed to write()*/
+        Resampler(unsigned srcrate, unsigned dstrate, int maxwrite) NONREALTIME;
+        ~Resampler() NONREALTIME;
+        Resampler(const Resampler&) = delete;
+
+        //! Output samples which the buffered input is enough for
+        int available(void) const REALTIME;
+        //! Append input, n must not exceed maxwrite
+        void write(const float *l, const float *r, int n) REALTIME;
+        //! Make n output samples, n must not exceed available()
+        void read(float *outl, float *outr, int n) REALTIME;
+
+        const unsigned srcrate, dstrate;
+
+    private:
+        const double step;  //input samples per output sample
+        const int    half;  //taps on each side of the output position
+        const int    taps;
+        float       *table; //(RESAMPLER_PHASES + 1) rows of taps
+        float       *kernel;
+
+        float  *bufl, *bufr;
+        int     size;       //capacity of bufl/bufr
+        int     count;      //samples in bufl/bufr
+        int     pos;        //input sample at or before the next output
+        double  frac;       //position of the next output after pos
+};
+
+}
@@ -144,8 +144,7 @@ void EQ::out(const Stereo<float *> &smp)
     for(int i = 0; i < MAX_EQ_BANDS; ++i) {
         if(filter[i].Ptype == 0)
             continue;
-        filter[i].l->filterout(efxoutl);
-        filter[i].r->filterout(efxoutr);
+        AnalogFilter::filterout(*filter[i].l, *filter[i].r, efxoutl, efxoutr);
     }
 }
 
@@ -15,6 +15,7 @@
 #include <rtosc/port-sugar.h>
 #include <iostream>
 #include <cassert>
+#include <cstring>
 
 #include "EffectMgr.h"
 #include "Effect.h"
@@ -528,12 +529,13 @@ void EffectMgr::out(float *smpsl, float *smpsr)
             }
         return;
     }
-    for(int i = 0; i < synth.buffersize; ++i) {
-        smpsl[i]  += synth.denormalkillbuf[i];
-        smpsr[i]  += synth.denormalkillbuf[i];
-        efxoutl[i] = 0.0f;
-        efxoutr[i] = 0.0f;
-    }
+    if(synth.denormalnoise)
+        for(int i = 0; i < synth.buffersize; ++i) {
+            smpsl[i]  += synth.denormalkillbuf[i];
+            smpsr[i]  += synth.denormalkillbuf[i];
+        }
+    memset(efxoutl, 0, synth.bufferbytes);
+    memset(efxoutr, 0, synth.bufferbytes);
     efx->out(smpsl, smpsr);
 
     float volume = efx->volume;
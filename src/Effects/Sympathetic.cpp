@@ -130,11 +130,13 @@ void Sympathetic::cleanup(void)
 //Apply the filters
 void Sympathetic::applyfilters(float *efxoutl, float *efxoutr)
 {
-    if(Plpf!=127) lpfl->filterout(efxoutl);
-    if(Phpf!=0) hpfl->filterout(efxoutl);
     if(Pstereo != 0) { //stereo
-        if(Plpf!=127) lpfr->filterout(efxoutr);
-        if(Phpf!=0) hpfr->filterout(efxoutr);
+        if(Plpf!=127) AnalogFilter::filterout(*lpfl, *lpfr, efxoutl, efxoutr);
+        if(Phpf!=0) AnalogFilter::filterout(*hpfl, *hpfr, efxoutl, efxoutr);
+    }
+    else {
+        if(Plpf!=127) lpfl->filterout(efxoutl);
+        if(Phpf!=0) hpfl->filterout(efxoutl);
     }
 }
 
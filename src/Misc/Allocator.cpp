@@ -14,6 +14,7 @@
 #include <cassert>
 #include <utility>
 #include <cstdio>
+#include <atomic>
 #include "../../tlsf/tlsf.h"
 #include "Allocator.h"
 #include "Util.h"
@@ -45,6 +46,22 @@ struct AllocatorImpl
     //nice values
     next_t *pools = 0;
     unsigned long long totalAlloced = 0;
+
+    //tlsf is not thread safe, but notes of different parts may be
+    //(de)allocated concurrently by the render pool's worker threads
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+};
+
+//Spinlock around the tlsf state; uncontended in the serial render path
+struct AllocLock
+{
+    AllocLock(AllocatorImpl *impl_) :impl(impl_)
+    {
+        while(impl->busy.test_and_set(std::memory_order_acquire))
+            ;
+    }
+    ~AllocLock() { impl->busy.clear(std::memory_order_release); }
+    AllocatorImpl *impl;
 };
 
 Allocator::Allocator(void) : transaction_active()
@@ -73,6 +90,7 @@ Allocator::~Allocator(void)
 
 void *AllocatorClass::alloc_mem(size_t mem_size)
 {
+    AllocLock lock(impl);
     impl->totalAlloced += mem_size;
     void *mem = tlsf_malloc(impl->tlsf, mem_size);
     //printf("Allocator.malloc(%p, %d) = %p\n", impl, mem_size, mem);
@@ -83,6 +101,7 @@ void *AllocatorClass::alloc_mem(size_t mem_size)
 void AllocatorClass::dealloc_mem(void *memory)
 {
     //printf("dealloc_mem(%d)\n", tlsf_block_size(memory));
+    AllocLock lock(impl);
     tlsf_free(impl->tlsf, memory);
     //free(memory);
 }
@@ -91,6 +110,7 @@ bool AllocatorClass::lowMemory(unsigned n, size_t chunk_size) const
 {
     //This should stay on the stack
     STACKALLOC(void*, buf, n);
+    AllocLock lock(impl);
     for(unsigned i=0; i<n; ++i)
         buf[i] = tlsf_malloc(impl->tlsf, chunk_size);
     bool outOfMem = false;
@@ -106,6 +126,7 @@ bool AllocatorClass::lowMemory(unsigned n, size_t chunk_size) const
 
 void AllocatorClass::addMemory(void *v, size_t mem_size)
 {
+    AllocLock lock(impl);
     next_t *n = impl->pools;
     while(n->next) n = n->next;
     n->next = (next_t*)v;
@@ -227,10 +227,12 @@ int Bank::loadfromslot(unsigned int ninstrument, Part *part)
 int Bank::loadbank(string bankdirname)
 {
     normalizedirsuffix(bankdirname);
-    DIR *dir = opendir(bankdirname.c_str());
+    BankDb::bvec entries;
     clearbank();
 
-    if(dir == NULL)
+    //the entries are kept up to date by the database, so the directory
+    //is not read again
+    if(!db->getBank(bankdirname, entries))
         return -1;
 
     //set msb when possible
@@ -243,49 +245,13 @@ int Bank::loadbank(string bankdirname)
 
     bankfiletitle = dirname;
 
-    struct dirent *fn;
-
-    while((fn = readdir(dir))) {
-        const char *filename = fn->d_name;
-
-        //check for extension
-        if(strstr(filename, INSTRUMENT_EXTENSION) == NULL)
-            continue;
-
-        //verify if the name is like this NNNN-name (where N is a digit)
-        int no = 0;
-        unsigned int startname = 0;
-
-        for(unsigned int i = 0; i < 4; ++i) {
-            if(strlen(filename) <= i)
-                break;
-
-            if((filename[i] >= '0') && (filename[i] <= '9')) {
-                no = no * 10 + (filename[i] - '0');
-                startname++;
-            }
-        }
-
-        if((startname + 1) < strlen(filename))
-            startname++;  //to take out the "-"
-
-        string name = filename;
-
-        //remove the file extension
-        for(int i = name.size() - 1; i >= 2; i--)
-            if(name[i] == '.') {
-                name = name.substr(0, i);
-                break;
-            }
-
-        if(no != 0) //the instrument position in the bank is found
-            addtobank(no - 1, filename, name.substr(startname));
+    for(auto &entry:entries) {
+        if(entry.id != 0) //the instrument position in the bank is found
+            addtobank(entry.id - 1, entry.file, entry.name);
         else
-            addtobank(-1, filename, name);
+            addtobank(-1, entry.file, entry.name);
     }
 
-    closedir(dir);
-
     if(!dirname.empty())
         config->cfg.currentBankDir = dirname;
 
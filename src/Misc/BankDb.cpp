@@ -2,9 +2,16 @@
 #include "XMLwrapper.h"
 #include "Util.h"
 #include "../globals.h"
+#include <algorithm>
 #include <cstring>
+#include <iterator>
+#include <set>
 #include <dirent.h>
 #include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 namespace zyn {
 
@@ -59,7 +66,20 @@ bool BankEntry::match(string s) const
 
 bool BankEntry::operator<(const BankEntry &b) const
 {
-    return (this->bank+this->file) < (b.bank+b.file);
+    if(this->bank == b.bank)
+        return this->file < b.file;
+
+    //(bank+file) < (b.bank+b.file) without building the strings
+    auto at = [](const BankEntry &e, size_t i) {
+        return (unsigned char)(i < e.bank.size() ? e.bank[i]
+                                                 : e.file[i - e.bank.size()]);
+    };
+    const size_t n = this->bank.size() + this->file.size();
+    const size_t m = b.bank.size() + b.file.size();
+    for(size_t i = 0; i < n && i < m; ++i)
+        if(at(*this, i) != at(b, i))
+            return at(*this, i) < at(b, i);
+    return n < m;
 }
 
 static svec split(string s)
@@ -92,19 +112,133 @@ static svec split(string s)
 //    return ss;
 //}
 
-bvec BankDb::search(std::string ss) const
+svec BankEntry::tags(void) const
 {
-    bvec vec;
-    const svec sterm = split(ss);
-    for(auto field:fields) {
-        bool match = true;
-        for(auto s:sterm)
-            match &= field.match(s);
-        if(match)
-            vec.push_back(field);
+    svec res;
+    if(add)
+        res.push_back("add");
+    if(pad)
+        res.push_back("pad");
+    if(sub)
+        res.push_back("sub");
+    return res;
+}
+
+static string lower(string s)
+{
+    for(char &c:s)
+        c = tolower((unsigned char)c);
+    return s;
+}
+
+//Words of the fields which match() searches
+static svec keywords(const BankEntry &e)
+{
+    svec vec;
+    for(const string *field:{&e.file, &e.name, &e.bank, &e.type,
+                             &e.comments, &e.author})
+        for(auto word:split(*field))
+            vec.push_back(lower(word));
+    return vec;
+}
+
+static void addid(std::vector<uint32_t> &ids, uint32_t id)
+{
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if(it == ids.end() || *it != id)
+        ids.insert(it, id);
+}
+
+static void removeid(std::vector<uint32_t> &ids, uint32_t id)
+{
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if(it != ids.end() && *it == id)
+        ids.erase(it);
+}
+
+//Modification time of a directory in ns, -1 if it does not exist
+static long long dirtime(const string &dir)
+{
+    struct stat st;
+    if(stat(dir.c_str(), &st))
+        return -1;
+#if defined(WIN32)
+    return st.st_mtime * 1000000000LL;
+#elif defined(__APPLE__)
+    return st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    return st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+}
+
+BankDb::BankDir::BankDir(void)
+    :time(-1), watch(-1)
+{}
+
+BankDb::BankDb(void)
+    :notify(-1), dirty(false), cacheLoaded(false)
+{
+#ifdef __linux__
+    notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+BankDb::~BankDb(void)
+{
+#ifdef __linux__
+    if(notify != -1)
+        close(notify);
+#endif
+}
+
+bvec BankDb::search(std::string ss)
+{
+    update();
+
+    std::vector<uint32_t> found;
+    bool first = true;
+    for(auto s:split(ss)) {
+        std::vector<uint32_t> ids;
+        if(s == "#pad" || s == "#sub" || s == "#add") {
+            auto t = tagged.find(s.substr(1));
+            if(t != tagged.end())
+                ids = t->second;
+        } else {
+            //the entries of all words containing the keyword
+            const string term = lower(s);
+            for(auto &w:words)
+                if(w.first.find(term) != string::npos)
+                    ids.insert(ids.end(), w.second.begin(), w.second.end());
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        }
+
+        if(first)
+            found.swap(ids);
+        else {
+            std::vector<uint32_t> both;
+            std::set_intersection(found.begin(), found.end(),
+                                  ids.begin(), ids.end(),
+                                  std::back_inserter(both));
+            found.swap(both);
+        }
+        first = false;
+        if(found.empty())
+            break;
     }
 
-    std::sort(vec.begin(), vec.end());
+    if(first)
+        for(auto &p:paths)
+            found.push_back(p.second);
+
+    std::sort(found.begin(), found.end(), [this](uint32_t a, uint32_t b) {
+            return fields[a] < fields[b];
+            });
+
+    bvec vec;
+    vec.reserve(found.size());
+    for(auto id:found)
+        vec.push_back(fields[id]);
 
     return vec;
 }
@@ -122,26 +256,44 @@ void BankDb::addBankDir(std::string bnk)
 void BankDb::clear(void)
 {
     banks.clear();
-    fields.clear();
 }
 
-static std::string getCacheName(void)
+svec BankDb::tags(void) const
+{
+    svec res;
+    for(auto &t:tagged)
+        res.push_back(t.first);
+    return res;
+}
+
+//The cache is a binary image (see XMLimage), older versions wrote XML
+static std::string getCacheName(bool legacy = false)
 {
     char name[512] = {};
     snprintf(name, sizeof(name), "%s%s", getenv("HOME"),
-            "/.zynaddsubfx-bank-cache.xml");
+            legacy ? "/.zynaddsubfx-bank-cache.xml"
+                   : "/.zynaddsubfx-bank-cache.bin");
     return name;
 }
 
-static bvec loadCache(void)
+void BankDb::loadCache(void)
 {
-    bvec cache;
+    if(cacheLoaded)
+        return;
+    cacheLoaded = true;
+
     XMLwrapper xml;
-    xml.loadXMLfile(getCacheName());
+    if(xml.loadXMLfile(getCacheName()) < 0)
+        xml.loadXMLfile(getCacheName(true));
     if(xml.enterbranch("bank-cache")) {
         auto nodes = xml.getBranch();
 
         for(auto node:nodes) {
+            if(node.name == "bank-dir") {
+                if(node.has("dir") && node.has("time"))
+                    cacheTimes[node["dir"]] = atoll(node["time"].c_str());
+                continue;
+            }
             BankEntry be;
 #define bind(x,y) if(node.has(#x)) {be.x = y(node[#x].c_str());}
             bind(file, string);
@@ -149,24 +301,40 @@ static bvec loadCache(void)
             bind(name, string);
             bind(comments, string);
             bind(author, string);
-            bind(type, atoi);
+            bind(type, string);
             bind(id, atoi);
             bind(add, atoi);
             bind(pad, atoi);
             bind(sub, atoi);
-            bind(time, atoi);
+            bind(time, atoll);
 #undef bind
-            cache.push_back(be);
+            cache[be.bank + be.file] = be;
         }
     }
-    return cache;
 }
 
-static void saveCache(bvec vec)
+void BankDb::saveCache(void)
 {
+    //The watched directories are up to date with the events read after
+    //taking their time, later changes give them another time
+    for(auto &d:dirs)
+        if(d.second.watch != -1)
+            d.second.time = dirtime(d.first);
+    update();
+
     XMLwrapper xml;
     xml.beginbranch("bank-cache");
-    for(auto value:vec) {
+    for(auto &d:dirs) {
+        if(d.second.time == -1)
+            continue;
+        XmlNode binding("bank-dir");
+        binding["dir"]  = d.first;
+        binding["time"] = to_s(d.second.time);
+        xml.add(binding);
+    }
+    for(auto &value:fields) {
+        if(value.file.empty())
+            continue;
         XmlNode binding("instrument-entry");
 #define bind(x) binding[#x] = to_s(value.x);
         bind(file);
@@ -184,44 +352,297 @@ static void saveCache(bvec vec)
         xml.add(binding);
     }
     xml.endbranch();
-    xml.saveXMLfile(getCacheName(), 0);
+    //mapped at the next start instead of being parsed, other instances
+    //keep the file they have mapped until it is replaced
+    xml.saveBinaryfile(getCacheName());
+    dirty = false;
 }
 
 void BankDb::scanBanks(void)
 {
-    fields.clear();
-    bvec cache = loadCache();
-    bmap cc;
-    for(auto c:cache)
-        cc[c.bank + c.file] = c;
+    loadCache();
+    update();
+
+    //forget the directories which are no banks anymore
+    svec gone;
+    for(auto &d:dirs)
+        if(std::find(banks.begin(), banks.end(), d.first) == banks.end())
+            gone.push_back(d.first);
+    for(auto &bank:gone)
+        dropDir(bank);
 
-    bvec ncache;
     for(auto bank:banks)
-    {
-        DIR *dir = opendir(bank.c_str());
+        scanDir(bank, false);
+
+    //the entries of the cache which are still of use have been taken
+    cache.clear();
+    cacheTimes.clear();
 
+    if(dirty)
+        saveCache();
+}
+
+bool BankDb::getBank(std::string bank, bvec &entries)
+{
+    loadCache();
+    update();
+
+    entries.clear();
+    if(std::find(banks.begin(), banks.end(), bank) == banks.end()) {
+        //no bank: read it without adding it to the index or watching it
+        DIR *dir = opendir(bank.c_str());
         if(!dir)
-            continue;
+            return false;
 
+        struct dirent *fn;
+        while((fn = readdir(dir)))
+            if(strstr(fn->d_name, INSTRUMENT_EXTENSION))
+                entries.push_back(processXiz(fn->d_name, bank, cache));
+        closedir(dir);
 
+        std::sort(entries.begin(), entries.end());
+        return true;
+    }
+
+    if(!scanDir(bank, false))
+        return false;
+
+    for(auto id:dirs[bank].entries)
+        entries.push_back(fields[id]);
+    std::sort(entries.begin(), entries.end());
+    return true;
+}
+
+/*
+ * Bring the entries of a bank directory up to date, reading the directory
+ * only if it has been modified since (or with reread).
+ * Returns false if the directory cannot be read
+ */
+bool BankDb::scanDir(const string &bank, bool reread)
+{
+    const bool known = dirs.count(bank);
+    BankDir &d = dirs[bank];
+    if(known && d.watch != -1 && !reread)
+        return true; //kept up to date by update()
+
+#ifdef __linux__
+    //watch before reading, so no change gets lost
+    if(notify != -1 && d.watch == -1) {
+        d.watch = inotify_add_watch(notify, bank.c_str(),
+                IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+        if(d.watch != -1) {
+            svec &w = watches[d.watch];
+            if(std::find(w.begin(), w.end(), bank) == w.end())
+                w.push_back(bank);
+        }
+    }
+#endif
+    const long long time = dirtime(bank);
+    long long last = d.time;
+    if(!known) {
+        auto t = cacheTimes.find(bank);
+        last = t == cacheTimes.end() ? -1 : t->second;
+    }
+
+    //the known entries, from the last scan or from the cache
+    bmap old;
+    for(auto id:d.entries)
+        old[bank + fields[id].file] = fields[id];
+    for(auto c = cache.lower_bound(bank);
+        c != cache.end() && !c->first.compare(0, bank.size(), bank);)
+        if(c->second.bank == bank) {
+            old.insert(*c);
+            c = cache.erase(c);
+        } else
+            ++c;
+
+    svec files;
+    bool readable = time != -1;
+    if(readable && time == last && !reread) {
+        //only files rewritten in place can have changed
+        for(auto &o:old)
+            files.push_back(o.second.file);
+    } else if(DIR *dir = opendir(bank.c_str())) {
         struct dirent *fn;
 
         while((fn = readdir(dir))) {
             const char *filename = fn->d_name;
 
             //check for extension
-            if(!strstr(filename, INSTRUMENT_EXTENSION))
-                continue;
-
-            auto xiz = processXiz(filename, bank, cc);
-            fields.push_back(xiz);
-            ncache.push_back(xiz);
+            if(strstr(filename, INSTRUMENT_EXTENSION))
+                files.push_back(filename);
         }
 
         closedir(dir);
+    } else
+        readable = false;
+
+    //drop the entries of files which are gone
+    std::sort(files.begin(), files.end());
+    svec stale;
+    for(auto id:d.entries)
+        if(!std::binary_search(files.begin(), files.end(), fields[id].file))
+            stale.push_back(bank + fields[id].file);
+    for(auto &path:stale)
+        erase(path);
+
+    for(auto &file:files) {
+        auto xiz = processXiz(file, bank, old);
+        auto p   = paths.find(bank + file);
+        if(p == paths.end() || fields[p->second].time != xiz.time)
+            insert(xiz);
+    }
+
+    dirs[bank].time = readable ? time : -1;
+    return readable;
+}
+
+//Read one instrument file again, or drop its entry if it is gone
+void BankDb::refresh(const string &bank, const string &file)
+{
+    struct stat st;
+    bmap none;
+    erase(bank + file);
+    if(!stat((bank + file).c_str(), &st))
+        insert(processXiz(file, bank, none));
+}
+
+void BankDb::insert(const BankEntry &entry)
+{
+    const string path = entry.bank + entry.file;
+    erase(path);
+
+    uint32_t id;
+    if(unused.empty()) {
+        id = fields.size();
+        fields.push_back(entry);
+    } else {
+        id = unused.back();
+        unused.pop_back();
+        fields[id] = entry;
+    }
+
+    paths[path] = id;
+    addid(dirs[entry.bank].entries, id);
+    for(auto &word:keywords(entry))
+        addid(words[word], id);
+    for(auto &tag:entry.tags())
+        addid(tagged[tag], id);
+    dirty = true;
+}
 
+void BankDb::erase(const string &path)
+{
+    auto p = paths.find(path);
+    if(p == paths.end())
+        return;
+
+    const uint32_t id = p->second;
+    const BankEntry &entry = fields[id];
+    for(auto &word:keywords(entry)) {
+        auto w = words.find(word);
+        if(w == words.end())
+            continue;
+        removeid(w->second, id);
+        if(w->second.empty())
+            words.erase(w);
+    }
+    for(auto &tag:entry.tags()) {
+        auto t = tagged.find(tag);
+        removeid(t->second, id);
+        if(t->second.empty())
+            tagged.erase(t);
     }
-    saveCache(ncache);
+    auto d = dirs.find(entry.bank);
+    if(d != dirs.end())
+        removeid(d->second.entries, id);
+
+    fields[id] = BankEntry();
+    unused.push_back(id);
+    paths.erase(p);
+    dirty = true;
+}
+
+void BankDb::dropDir(const string &bank)
+{
+    auto d = dirs.find(bank);
+    if(d == dirs.end())
+        return;
+
+    while(!d->second.entries.empty())
+        erase(bank + fields[d->second.entries.back()].file);
+
+#ifdef __linux__
+    auto w = watches.find(d->second.watch);
+    if(w != watches.end()) {
+        svec &v = w->second;
+        v.erase(std::remove(v.begin(), v.end(), bank), v.end());
+        if(v.empty()) {
+            inotify_rm_watch(notify, w->first);
+            watches.erase(w);
+        }
+    }
+#endif
+    dirs.erase(d);
+    dirty = true;
+}
+
+void BankDb::update(void)
+{
+#ifdef __linux__
+    if(notify == -1)
+        return;
+
+    std::set<string> rescan;
+    std::set<std::pair<string, string>> changed;
+
+    alignas(struct inotify_event) char buf[4096];
+    ssize_t len;
+    while((len = read(notify, buf, sizeof(buf))) > 0) {
+        const struct inotify_event *ev;
+        for(char *p = buf; p < buf + len; p += sizeof(*ev) + ev->len) {
+            ev = (const struct inotify_event *)p;
+
+            //events were lost, read every watched directory again
+            if(ev->mask & IN_Q_OVERFLOW) {
+                for(auto &d:dirs)
+                    if(d.second.watch != -1)
+                        rescan.insert(d.first);
+                continue;
+            }
+
+            auto w = watches.find(ev->wd);
+            if(w == watches.end())
+                continue;
+
+            //the directory is gone, a new one may take its path
+            if(ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                for(auto &bank:w->second) {
+                    dirs[bank].watch = -1;
+                    rescan.insert(bank);
+                }
+                if(!(ev->mask & IN_IGNORED))
+                    inotify_rm_watch(notify, ev->wd);
+                watches.erase(w);
+                continue;
+            }
+
+            if(!ev->len || (ev->mask & IN_ISDIR)
+               || !strstr(ev->name, INSTRUMENT_EXTENSION))
+                continue;
+            for(auto &bank:w->second)
+                changed.insert({bank, ev->name});
+        }
+    }
+
+    for(auto &c:changed)
+        if(!rescan.count(c.first) && dirs.count(c.first))
+            refresh(c.first, c.second);
+    for(auto &bank:rescan)
+        if(dirs.count(bank))
+            scanDir(bank, true);
+#endif
 }
 
 BankEntry BankDb::processXiz(std::string filename,
@@ -231,16 +652,16 @@ BankEntry BankDb::processXiz(std::string filename,
 
     //Grab a timestamp
     struct stat st;
-    int time = 0;
+    long long time = 0;
 
     //gah windows, just implement the darn standard APIs
 #ifndef WIN32
     int ret  = lstat(fname.c_str(), &st);
     if(ret != -1)
 # ifdef __APPLE__
-        time = st.st_mtimespec.tv_sec;
+        time = st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
 # else
-        time = st.st_mtim.tv_sec;
+        time = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
 # endif
 #else
     int ret = 0;
@@ -318,7 +739,7 @@ BankEntry BankDb::processXiz(std::string filename,
     //Try to obtain other metadata (expensive)
     XMLwrapper xml;
     ret = xml.loadXMLfile(fname);
-    if(ret && xml.enterbranch("INSTRUMENT")) {
+    if(ret == 0 && xml.enterbranch("INSTRUMENT")) {
         if(xml.enterbranch("INFO")) {
             char author[1024];
             char comments[1024];
@@ -333,7 +754,7 @@ BankEntry BankDb::processXiz(std::string filename,
         }
         if(xml.enterbranch("INSTRUMENT_KIT")) {
             for(int i = 0; i < NUM_KIT_ITEMS; ++i) {
-                if(xml.enterbranch("INSTRUMENT_KIT_ITEM", i) == 0) {
+                if(xml.enterbranch("INSTRUMENT_KIT_ITEM", i)) {
                     entry.add |= xml.getparbool("add_enabled", false);
                     entry.sub |= xml.getparbool("sub_enabled", false);
                     entry.pad |= xml.getparbool("pad_enabled", false);
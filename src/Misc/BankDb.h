@@ -1,7 +1,9 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 namespace zyn {
 
@@ -18,7 +20,7 @@ struct BankEntry
     bool        add;
     bool        pad;
     bool        sub;
-    int         time;//last update
+    long long   time;//last update, in ns
     typedef std::vector<std::string> svec;
     svec tags(void) const;
     bool match(std::string) const;
@@ -26,6 +28,21 @@ struct BankEntry
 };
 
 
+/**
+ * Index of the instruments of the banks.
+ *
+ * Searches use an inverted index: each whitespace separated word of the
+ * searched fields (in lower case) lists the entries containing it, so a
+ * keyword is looked up in the vocabulary instead of in every entry. As
+ * keywords have no whitespace, the words containing a keyword find the same
+ * entries as a substring search of the fields.
+ *
+ * scanBanks() stores the entries in a cache file with the modification time
+ * of their bank directory. A directory which has not changed is not read
+ * again, only its known files are checked for changes. On Linux the scanned
+ * directories are watched with inotify and update() applies the changes,
+ * so neither searching nor loading a bank reads a directory again.
+ */
 class BankDb
 {
     public:
@@ -33,15 +50,22 @@ class BankDb
         typedef std::vector<BankEntry>          bvec;
         typedef std::map<std::string,BankEntry> bmap;
 
+        BankDb(void);
+        ~BankDb(void);
+        BankDb(const BankDb&) = delete;
+        BankDb &operator=(const BankDb&) = delete;
+
         //search for banks
         //uses a space separated list of keywords and
         //finds something that matches ALL keywords
-        bvec search(std::string) const;
+        bvec search(std::string);
 
         //fully qualified paths only
         void addBankDir(std::string);
 
-        //clear all known entries and banks
+        //clear the list of banks
+        //the entries of banks which are not added again are dropped by
+        //the next scan
         void clear(void);
 
         //List of all tags
@@ -50,10 +74,50 @@ class BankDb
         //scan banks
         void scanBanks(void);
 
+        //entries of a bank directory
+        //directories which are no banks are read each time and are not
+        //searched
+        //returns false if the directory cannot be read
+        bool getBank(std::string, bvec&);
+
+        //apply the changes of the watched directories
+        void update(void);
+
     private:
+        typedef std::vector<uint32_t> ivec;
+
+        struct BankDir {
+            BankDir(void);
+            long long time;  //modification time when the entries were read
+            int       watch; //inotify watch or -1
+            ivec      entries;
+        };
+
         BankEntry processXiz(std::string, std::string, bmap&) const;
-        bvec fields;
+        bool scanDir(const std::string &bank, bool reread);
+        void refresh(const std::string &bank, const std::string &file);
+        void insert(const BankEntry &entry);
+        void erase(const std::string &path);
+        void dropDir(const std::string &bank);
+        void loadCache(void);
+        void saveCache(void);
+
+        bvec fields; //entries, free ones have no file
+        ivec unused; //free entries
         svec banks;
+
+        std::unordered_map<std::string, uint32_t> paths; //bank+file
+        std::unordered_map<std::string, ivec>     words; //sorted entries
+        std::map<std::string, ivec>               tagged;
+        std::map<std::string, BankDir>            dirs;
+        std::map<int, svec>                       watches;
+        int  notify; //inotify instance or -1
+        bool dirty;  //entries differ from the cache file
+
+        //cache file contents, until the directories are scanned
+        bool cacheLoaded;
+        bmap cache;
+        std::map<std::string, long long> cacheTimes;
 };
 
 }
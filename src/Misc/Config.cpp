@@ -52,6 +52,9 @@ static const rtosc::Ports ports = {
     rParamI(cfg.GzipCompression, "Level of Gzip Compression For Save Files"),
     rParamI(cfg.Interpolation, "Level of Interpolation, Linear/Cubic"),
     rToggle(cfg.SaveFullXml, "Include Disabled parts in save"),
+    rParamI(cfg.RenderThreads, "Number of threads rendering the parts"),
+    rParamI(cfg.PadCacheSize, "MiB of PADsynth samples cached on disk (0 = off)"),
+    rToggle(cfg.MeasureFFT, "Measure the fastest FFTs (slow the first time)"),
     {"cfg.presetsDirList", rDoc("list of preset search directories"), 0,
         [](const char *msg, rtosc::RtData &d)
         {
@@ -210,6 +213,9 @@ void Config::init()
     cfg.GzipCompression = 3;
 
     cfg.Interpolation = 0;
+    cfg.RenderThreads = 1;
+    cfg.PadCacheSize = 0; //the user opts in to using disk space
+    cfg.MeasureFFT = false;
     cfg.SaveFullXml = false;
     cfg.CheckPADsynth = true;
     cfg.IgnoreProgramChange = false;
@@ -344,6 +350,21 @@ void Config::readConfig(const char *filename)
                                            0,
                                            1);
 
+        cfg.RenderThreads = xmlcfg.getpar("render_threads",
+                                          cfg.RenderThreads,
+                                          1,
+                                          NUM_MIDI_PARTS);
+
+        cfg.PadCacheSize = xmlcfg.getpar("pad_cache_size",
+                                         cfg.PadCacheSize,
+                                         0,
+                                         1024 * 1024);
+
+        cfg.MeasureFFT = (bool) xmlcfg.getpar("measure_fft",
+                                              cfg.MeasureFFT,
+                                              0,
+                                              1);
+
         cfg.SaveFullXml  = (bool) xmlcfg.getpar("SaveFullXml",
                                                 cfg.SaveFullXml,
                                                 0,
@@ -460,6 +481,9 @@ void Config::saveConfig(const char *filename) const
         }
 
     xmlcfg->addpar("interpolation", cfg.Interpolation);
+    xmlcfg->addpar("render_threads", cfg.RenderThreads);
+    xmlcfg->addpar("pad_cache_size", cfg.PadCacheSize);
+    xmlcfg->addpar("measure_fft", cfg.MeasureFFT);
     xmlcfg->addpar("SaveFullXml", cfg.SaveFullXml);
 
     //linux stuff
@@ -484,4 +508,10 @@ void Config::getConfigFileName(char *name, int namesize) const
     snprintf(name, namesize, "%s%s", getenv("HOME"), "/.zynaddsubfxXML.cfg");
 }
 
+void Config::getFFTWisdomFileName(char *name, int namesize) const
+{
+    name[0] = 0;
+    snprintf(name, namesize, "%s%s", getenv("HOME"), "/.zynaddsubfx-fftw-wisdom");
+}
+
 }
@@ -48,6 +48,9 @@ class Config
             bool  BankUIAutoClose;
             int   GzipCompression;
             int   Interpolation;
+            int   RenderThreads; // threads used to render parts (1 = serial)
+            int   PadCacheSize; // MiB of PADsynth samples kept on disk (0 = off)
+            bool  MeasureFFT; // plan the FFTs with FFTW_MEASURE, kept as wisdom
             bool  SaveFullXml; // when saving to a file save entire tree including disabled parts (Zynmuse)
             std::string bankRootDirList[MAX_BANK_ROOT_DIRS], currentBankDir;
             std::string presetsDirList[MAX_BANK_ROOT_DIRS];
@@ -71,6 +74,7 @@ class Config
         void clearpresetsdirlist();
         void init();
         void save() const;
+        void getFFTWisdomFileName(char *name, int namesize) const;
 
         static const rtosc::Ports &ports;
     private:
@@ -0,0 +1,99 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  Denormals.h - Flushing Denormal Floats To Zero In The FPU
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <stdint.h>
+
+//1 if the FPU of the target can flush denormals to zero, so the synth does
+//not need to add noise to its buffers (see SYNTH_T::denormalnoise)
+#ifndef ZYN_FLUSH_DENORMALS
+#if defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+#define ZYN_FLUSH_DENORMALS 1
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP))
+#define ZYN_FLUSH_DENORMALS 1
+#else
+#define ZYN_FLUSH_DENORMALS 0
+#endif
+#endif
+
+#if ZYN_FLUSH_DENORMALS && (defined(__SSE__) || defined(__x86_64__) || defined(_M_X64))
+#include <xmmintrin.h>
+#endif
+
+namespace zyn {
+
+typedef uintptr_t fpmode_t;
+
+//Control register of the FPU (SSE: MXCSR, ARM: FPCR/FPSCR)
+static inline fpmode_t getFpMode(void)
+{
+#if !ZYN_FLUSH_DENORMALS
+    return 0;
+#elif defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+    return _mm_getcsr();
+#elif defined(__aarch64__)
+    uint64_t mode;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode));
+    return mode;
+#else
+    uint32_t mode;
+    __asm__ __volatile__("vmrs %0, fpscr" : "=r"(mode));
+    return mode;
+#endif
+}
+
+static inline void setFpMode(fpmode_t mode)
+{
+#if !ZYN_FLUSH_DENORMALS
+    (void)mode;
+#elif defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+    _mm_setcsr((unsigned)mode);
+#elif defined(__aarch64__)
+    __asm__ __volatile__("msr fpcr, %0" : : "r"((uint64_t)mode));
+#else
+    __asm__ __volatile__("vmsr fpscr, %0" : : "r"((uint32_t)mode));
+#endif
+}
+
+//FTZ and DAZ on x86, FZ on ARM
+static inline fpmode_t flushMode(fpmode_t mode)
+{
+#if !ZYN_FLUSH_DENORMALS
+    return mode;
+#elif defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+    return mode | 0x8040;
+#else
+    return mode | (1 << 24);
+#endif
+}
+
+//Flush denormals to zero on this thread from now on (for worker threads)
+static inline void flushDenormals(void)
+{
+    setFpMode(flushMode(getFpMode()));
+}
+
+/**
+ * Flushes denormals to zero while in scope and restores the mode of the
+ * calling thread afterwards, for entry points which run on threads of the
+ * host (audio callbacks, plugin hosts)
+ */
+class DenormalGuard
+{
+    public:
+        DenormalGuard(void) :saved(getFpMode()) { setFpMode(flushMode(saved)); }
+        ~DenormalGuard(void) { setFpMode(saved); }
+        DenormalGuard(const DenormalGuard&) = delete;
+    private:
+        const fpmode_t saved;
+};
+
+}
@@ -21,9 +21,13 @@
 #include "../Misc/Util.h"
 #include "../Misc/Sync.h"
 #include "../Params/LFOParams.h"
+#include "../Params/PADnoteParameters.h"
 #include "../Effects/EffectMgr.h"
 #include "../DSP/FFTwrapper.h"
+#include "../DSP/Resampler.h"
 #include "../Misc/Allocator.h"
+#include "../Misc/RenderPool.h"
+#include "../Misc/Denormals.h"
 #include "../Containers/ScratchString.h"
 #include "../Nio/Nio.h"
 #include "PresetExtractor.h"
@@ -478,6 +482,12 @@ static const Ports master_ports = {
            }}},
     rParamF(Volume, rShort("volume"), rDefault(-6.67 (-0x1.aaaaacp+2)), rLinear(-40.0f,13.3333f),
              rUnit(dB), "Master Volume"),
+    rParamF(silenceThreshold, rShort("silence"), rDefault(-120.0), rLinear(-200.0f,-40.0f),
+             rUnit(dB), "Level below which idle parts and released notes are "
+             "not rendered anymore (-200 disables it)"),
+    rParamF(silenceHold, rShort("hold"), rDefault(2.0), rLinear(0.0f,10.0f),
+             rUnit(S), "Time a part without notes must stay below the silence "
+             "level before it is skipped, so effect tails are kept"),
     {"Psysefxvol#" STRINGIFY(NUM_SYS_EFX) "/::i", 0, &sysefxPort,
         [](const char *msg, rtosc::RtData &d) {
             SNIP;
@@ -805,10 +815,19 @@ Master::Master(const SYNTH_T &synth_, Config* config)
     smps = 0;
     bufl = new float[synth.buffersize];
     bufr = new float[synth.buffersize];
+    resampler = NULL;
+    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
+        partresampler[npart] = NULL;
+        separateOut[npart]   = false;
+    }
 
     last_xmz[0] = 0;
     fft = new FFTwrapper(synth.oscilsize);
 
+    renderPool = NULL;
+    if(config->cfg.RenderThreads > 1)
+        renderPool = new RenderPool(config->cfg.RenderThreads);
+
     shutup = 0;
     for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
         vuoutpeakpartl[npart] = 1e-9;
@@ -863,8 +882,12 @@ bool Master::applyOscEvent(const char *msg, float *outl, float *outr,
          * WARNING: Do not use anything from "this" below, use "this_master"
          */
 
-        if(!offline)
+        if(!offline) {
+            memcpy(new_master->separateOut, this_master->separateOut,
+                   sizeof(separateOut));
             new_master->AudioOut(outl, outr);
+            this_master->successor = new_master;
+        }
         if(nio)
             Nio::masterSwap(new_master);
         if (this_master->hasMasterCb()) {
@@ -944,6 +967,8 @@ void Master::defaults()
     union {float f; uint32_t i;} convert;
     convert.i = 0xC0D55556;
     Volume = convert.f;
+    silenceThreshold = -120.0f;
+    silenceHold      = 2.0f;
     setPkeyshift(64);
 
     for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
@@ -1005,6 +1030,11 @@ void Master::noteOff(char chan, note_t note)
     activeNotes[note] = 0;
 }
 
+void Master::setEventOffset(int offset)
+{
+    time.eventOffset = limit(offset, 0, synth.buffersize - 1);
+}
+
 /*
  * Pressure Messages (velocity=0 for NoteOff)
  */
@@ -1264,11 +1294,18 @@ bool Master::runOSC(float *outl, float *outr, bool offline,
     else { return true; /* = no new master */ }
 }
 
+static void computePartJob(void *master, int npart)
+{
+    ((Master*)master)->part[npart]->ComputePartSmps();
+}
+
 /*
  * Master audio out (the final sound)
  */
 bool Master::AudioOut(float *outl, float *outr)
 {
+    //The synth relies on this instead of adding noise to its buffers
+    DenormalGuard denormals;
 
     //Danger Limits
     if(memory->lowMemory(2,1024*1024))
@@ -1280,7 +1317,8 @@ bool Master::AudioOut(float *outl, float *outr)
         pendingMemory = true;
     }
 
-    //work through events
+    //work through events (the ones from OSC start with the buffer)
+    time.eventOffset = 0;
     if(!runOSC(outl, outr, false))
         return false;
 
@@ -1300,23 +1338,55 @@ bool Master::AudioOut(float *outl, float *outr)
     //Compute part samples and store them part[npart]->partoutl,partoutr
     //Note: We do this regardless if the part is enabled or not, to allow
     //the part to graciously shut down when disabled.
-    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart)
-        part[npart]->ComputePartSmps();
+    //Parts (and their part effects) are independent of each other, so they
+    //can be rendered in parallel. Watch points report through a single
+    //ThreadLink, so they force the serial path while active.
+    //With a single enabled part the pool is handed to it to spread its
+    //notes instead (the pool is not reentrant, so never both at once).
+    int enabledParts = 0;
+    const float silence = silenceThreshold <= -200.0f ? 0.0f
+                          : dB2rap(silenceThreshold);
+    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
+        enabledParts += part[npart]->Penabled;
+        part[npart]->silenceThreshold = silence;
+        part[npart]->silenceHold = silenceHold * synth.samplerate_f
+                                   / synth.buffersize_f;
+    }
+    if(renderPool && watcher.empty() && enabledParts > 1)
+        renderPool->run(computePartJob, this, NUM_MIDI_PARTS);
+    else {
+        RenderPool *pool = watcher.empty() ? renderPool : NULL;
+        for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart)
+            part[npart]->ComputePartSmps(pool);
+    }
+
+    //Every note has crossfaded from the PAD samples replaced by the events
+    //of this buffer, free them
+    if(bToU)
+        for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart)
+            for(auto &k : part[npart]->kit)
+                if(k.padpars && k.padpars->prevpending)
+                    k.padpars->releaseprevsamples(*bToU);
 
     //Insertion effects
     for(int nefx = 0; nefx < NUM_INS_EFX; ++nefx)
         if(Pinsparts[nefx] >= 0) {
             int efxpart = Pinsparts[nefx];
-            if(part[efxpart]->Penabled)
+            if(part[efxpart]->Penabled && !part[efxpart]->idle)
                 insefx[nefx]->out(part[efxpart]->partoutl, // drywet: compensate by raising Part->gain
                                   part[efxpart]->partoutr);
         }
 
+    //Idle parts are left out of the mixing below
+    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart)
+        if(part[npart]->Penabled)
+            part[npart]->trackSilence();
+
     STACKALLOC(float, gainbuf, synth.buffersize);
 
     //Apply the part volumes and pannings (after insertion effects)
     for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
-        if(!part[npart]->Penabled)
+        if(!part[npart]->Penabled || part[npart]->idle)
             continue;
 
         Stereo<float> newvol(part[npart]->gain);
@@ -1375,8 +1445,8 @@ bool Master::AudioOut(float *outl, float *outr)
             if(Psysefxvol[nefx][npart] == 0)
                 continue;
 
-            //skip if the part is disabled
-            if(part[npart]->Penabled == 0)
+            //skip if the part is disabled or idle
+            if(part[npart]->Penabled == 0 || part[npart]->idle)
                 continue;
 
             //the output volume of each part to system effect
@@ -1407,9 +1477,9 @@ bool Master::AudioOut(float *outl, float *outr)
         }
     }
 
-    //Mix all parts
+    //Mix all parts (but the ones only heard on their own output)
     for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart)
-        if(part[npart]->Penabled)   //only mix active parts
+        if(part[npart]->Penabled && !part[npart]->idle && !separateOut[npart])
             for(int i = 0; i < synth.buffersize; ++i) { //the volume did not changed
                 outl[i] += part[npart]->partoutl[i];
                 outr[i] += part[npart]->partoutr[i];
@@ -1474,9 +1544,6 @@ bool Master::AudioOut(float *outl, float *outr)
     return true;
 }
 
-//TODO review the respective code from yoshimi for this
-//If memory serves correctly, libsamplerate was used
-//
 // beatType is not being used yet.
 // but beatsPerBar/beatType could be used to
 // match numerator/denominator along with bpm to plugin host
@@ -1489,11 +1556,12 @@ void Master::GetAudioOutSamples(size_t nsamples,
                                 int beat,
                                 float tick,
                                 float beatsPerBar,
-                                float /*beatType*/,
+                                float beatType,
                                 float bpm,
                                 float PPQ,
                                 bool playing,
-                                size_t frames)
+                                size_t frames,
+                                float **partout)
 {
 
     if(bpm) {
@@ -1512,9 +1580,77 @@ void Master::GetAudioOutSamples(size_t nsamples,
 
     off_t out_off = 0;
 
-    //Fail when resampling rather than doing a poor job
     if(synth.samplerate != samplerate) {
-        printf("darn it: %d vs %d\n", synth.samplerate, samplerate);
+        //The converter can't be set up here without allocating
+        if(!resampler || resampler->dstrate != samplerate) {
+            printf("darn it: %d vs %d\n", synth.samplerate, samplerate);
+            memset(outl, 0, sizeof(float) * nsamples);
+            memset(outr, 0, sizeof(float) * nsamples);
+            if(partout)
+                for(int i = 0; i < 2 * NUM_MIDI_PARTS; ++i)
+                    memset(partout[i], 0, sizeof(float) * nsamples);
+            return;
+        }
+
+        while(nsamples) {
+            const size_t n = std::min(nsamples, (size_t)resampler->available());
+            if(n) {
+                resampler->read(outl + out_off, outr + out_off, n);
+                if(partout)
+                    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
+                        float *l = partout[2 * npart] + out_off,
+                              *r = partout[2 * npart + 1] + out_off;
+                        if(partresampler[npart])
+                            partresampler[npart]->read(l, r, n);
+                        else {
+                            memset(l, 0, sizeof(float) * n);
+                            memset(r, 0, sizeof(float) * n);
+                        }
+                    }
+                out_off  += n;
+                nsamples -= n;
+                continue;
+            }
+
+            //A new master renders the buffer if it takes over
+            const bool same = AudioOut(bufl, bufr);
+            Master *src = same ? this : successor;
+            resampler->write(bufl, bufr, synth.buffersize);
+            if(src) {
+                STACKALLOC(float, silence, synth.buffersize);
+                memset(silence, 0, synth.bufferbytes);
+                for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
+                    if(!partresampler[npart])
+                        continue;
+                    const Part *p = src->part[npart];
+                    if(p->Penabled)
+                        partresampler[npart]->write(p->partoutl,
+                                                    p->partoutr,
+                                                    synth.buffersize);
+                    else
+                        partresampler[npart]->write(silence, silence,
+                                                    synth.buffersize);
+                }
+            }
+            if(!same) {
+                //The new master continues with the state of the converters
+                Master *next = successor;
+                successor = nullptr;
+                if(!next)
+                    return;
+                std::swap(next->resampler, resampler);
+                std::swap(next->partresampler, partresampler);
+                float *rest[2 * NUM_MIDI_PARTS];
+                for(int i = 0; partout && i < 2 * NUM_MIDI_PARTS; ++i)
+                    rest[i] = partout[i] + out_off;
+                next->GetAudioOutSamples(nsamples, samplerate,
+                                         outl + out_off, outr + out_off,
+                                         bar, beat, tick, beatsPerBar,
+                                         beatType, bpm, PPQ, playing,
+                                         frames, partout ? rest : NULL);
+                return;
+            }
+        }
         return;
     }
 
@@ -1523,11 +1659,32 @@ void Master::GetAudioOutSamples(size_t nsamples,
         if(nsamples >= smps) {
             memcpy(outl + out_off, bufl + off, sizeof(float) * smps);
             memcpy(outr + out_off, bufr + off, sizeof(float) * smps);
+            if(partout)
+                partOutSamples(partout, out_off, off, smps);
             nsamples -= smps;
 
             //generate samples
-            if (! AudioOut(bufl, bufr))
+            if (! AudioOut(bufl, bufr)) {
+                //A new master has rendered this buffer, it does the rest
+                Master *next = successor;
+                successor = nullptr;
+                if(!next)
+                    return;
+                memcpy(next->bufl, bufl, synth.bufferbytes);
+                memcpy(next->bufr, bufr, synth.bufferbytes);
+                next->off  = 0;
+                next->smps = synth.buffersize;
+                out_off   += smps;
+                float *rest[2 * NUM_MIDI_PARTS];
+                for(int i = 0; partout && i < 2 * NUM_MIDI_PARTS; ++i)
+                    rest[i] = partout[i] + out_off;
+                next->GetAudioOutSamples(nsamples, samplerate,
+                                         outl + out_off, outr + out_off,
+                                         bar, beat, tick, beatsPerBar,
+                                         beatType, bpm, PPQ, playing,
+                                         frames, partout ? rest : NULL);
                 return;
+            }
 
             off  = 0;
             out_off  += smps;
@@ -1536,15 +1693,57 @@ void Master::GetAudioOutSamples(size_t nsamples,
         else {   //use some samples
             memcpy(outl + out_off, bufl + off, sizeof(float) * nsamples);
             memcpy(outr + out_off, bufr + off, sizeof(float) * nsamples);
+            if(partout)
+                partOutSamples(partout, out_off, off, nsamples);
             smps    -= nsamples;
             off     += nsamples;
             nsamples = 0;
         }
     }
+
+    //Events until the next call are heard one buffer after they came in
+    setEventOffset(synth.buffersize - (int)smps);
+}
+
+void Master::partOutSamples(float **partout, off_t to, off_t from,
+                            size_t nsamples)
+{
+    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
+        float *l = partout[2 * npart] + to, *r = partout[2 * npart + 1] + to;
+        if(part[npart]->Penabled) {
+            memcpy(l, part[npart]->partoutl + from, sizeof(float) * nsamples);
+            memcpy(r, part[npart]->partoutr + from, sizeof(float) * nsamples);
+        } else {
+            memset(l, 0, sizeof(float) * nsamples);
+            memset(r, 0, sizeof(float) * nsamples);
+        }
+    }
+}
+
+void Master::setOutputRate(unsigned samplerate, bool partbuses)
+{
+    delete resampler;
+    resampler = NULL;
+    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
+        delete partresampler[npart];
+        partresampler[npart] = NULL;
+    }
+    if(samplerate == synth.samplerate)
+        return;
+
+    resampler = new Resampler(synth.samplerate, samplerate, synth.buffersize);
+    if(partbuses)
+        for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart)
+            partresampler[npart] = new Resampler(synth.samplerate, samplerate,
+                                                 synth.buffersize);
 }
 
 Master::~Master()
 {
+    delete renderPool;
+    delete resampler;
+    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart)
+        delete partresampler[npart];
     delete []bufl;
     delete []bufr;
 
@@ -1641,6 +1840,8 @@ void Master::initialize_rt(void)
 void Master::add2XML(XMLwrapper& xml)
 {
     xml.addparreal("volume", Volume);
+    xml.addparreal("silence_threshold", silenceThreshold);
+    xml.addparreal("silence_hold", silenceHold);
     xml.addpar("key_shift", Pkeyshift);
     xml.addparbool("nrpn_receive", ctl.NRPN.receive);
 
@@ -1767,6 +1968,9 @@ void Master::getfromXML(XMLwrapper& xml)
     } else {
         Volume  = volume127ToFloat(xml.getpar127("volume", 0));
     }
+    silenceThreshold = xml.getparreal("silence_threshold", silenceThreshold,
+                                      -200.0f, -40.0f);
+    silenceHold = xml.getparreal("silence_hold", silenceHold, 0.0f, 10.0f);
     setPkeyshift(xml.getpar127("key_shift", Pkeyshift));
     ctl.NRPN.receive = xml.getparbool("nrpn_receive", ctl.NRPN.receive);
 
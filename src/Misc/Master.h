@@ -112,6 +112,12 @@ class Master
         void setController(char chan, int type, note_t note, float value);
         //void NRPN...
 
+        /**Sample of the next AudioOut() buffer at which the following note-on
+         * events happen. AudioOut() resets it to 0 and GetAudioOutSamples()
+         * sets it to the sample where its caller stopped, so its notes have a
+         * constant latency of one buffer instead of starting with a buffer.*/
+        void setEventOffset(int offset) REALTIME;
+
 
         void ShutUp();
         int shutup;
@@ -133,7 +139,10 @@ class Master
         /**Audio Output*/
         bool AudioOut(float *outl, float *outr) REALTIME;
         /**Audio Output (for callback mode).
-         * This allows the program to be controlled by an external program*/
+         * This allows the program to be controlled by an external program.
+         * If partout is given, each part is written to its own stereo pair
+         * partout[2*n], partout[2*n+1] (after the insertion effects and the
+         * part volume, silent if the part is disabled).*/
         void GetAudioOutSamples(size_t nsamples,
                                 unsigned samplerate,
                                 float *outl,
@@ -146,7 +155,15 @@ class Master
                                 float bpm=0.0f,
                                 float PPQ=0.0f,
                                 bool playing=false,
-                                size_t frames=0) REALTIME;
+                                size_t frames=0,
+                                float **partout=NULL) REALTIME;
+        /**Sample rate which GetAudioOutSamples() is called with.
+         * If it differs from synth.samplerate, the output is converted, so
+         * the engine doesn't have to be rebuilt for a new rate.
+         * Set partbuses to convert the part outputs too.
+         * It must not run concurrently with GetAudioOutSamples().*/
+        void setOutputRate(unsigned samplerate,
+                           bool partbuses=false) NONREALTIME;
 
 
         void partonoff(int npart, int what);
@@ -185,6 +202,10 @@ class Master
         //part that's apply the insertion effect; -1 to disable
         short int Pinsparts[NUM_INS_EFX];
 
+        //parts left out of the main mix since their own output is used
+        //(see GetAudioOutSamples()), the system effects still get them
+        bool separateOut[NUM_MIDI_PARTS];
+
 
         //peaks for VU-meter
         void vuresetpeaks();
@@ -209,6 +230,11 @@ class Master
 
         static const rtosc::Ports &ports;
         float  Volume;
+        //Parts without notes are skipped once they are below silenceThreshold
+        //(dB, -200 disables) for silenceHold seconds, released notes after
+        //a short time below it
+        float  silenceThreshold;
+        float  silenceHold;
 
         //Statistics on output levels
         vuData vu;
@@ -263,10 +289,18 @@ class Master
         float *bufr;
         off_t  off;
         size_t smps;
+        //Converts bufl/bufr to the output rate (NULL if they match)
+        class Resampler *resampler;
+        class Resampler *partresampler[NUM_MIDI_PARTS];
+        void partOutSamples(float **partout, off_t to, off_t from,
+                            size_t nsamples) REALTIME;
 
         //Callback When Master changes
         void(*mastercb)(void*,Master*);
         void* mastercb_ptr;
+        //Master which took over during AudioOut(), it continues the
+        //GetAudioOutSamples() call that was running
+        Master *successor = nullptr;
         std::atomic<bool> masterSwitchUpcoming = { false };
 
         //! apply an OSC event with a DataObj parameter
@@ -283,6 +317,9 @@ class Master
         Value_Smoothing_Filter smoothing_part_l[NUM_MIDI_PARTS];
         Value_Smoothing_Filter smoothing_part_r[NUM_MIDI_PARTS];
 
+        //Worker threads rendering the parts concurrently (NULL if serial)
+        class RenderPool *renderPool;
+
         bool constPowerMixing = true;
 };
 
@@ -38,6 +38,8 @@
 #include "CallbackRepeater.h"
 #include "Master.h"
 #include "MsgParsing.h"
+#include "PadGenPool.h"
+#include "PadSampleCache.h"
 #include "Part.h"
 #include "PresetExtractor.h"
 #include "../Containers/MultiPseudoStack.h"
@@ -160,7 +162,9 @@ void deallocate(const char *str, void *v)
     else if(!strcmp(str, "Master"))
         delete (Master*)v;
     else if(!strcmp(str, "fft_t"))
-        delete[] (fft_t*)v;
+        FFT_freeBuffer(v);
+    else if(!strcmp(str, "OscilBands"))
+        delete (OscilBands*)v;
     else if(!strcmp(str, "KbmInfo"))
         delete (KbmInfo*)v;
     else if(!strcmp(str, "SclInfo"))
@@ -198,43 +202,34 @@ void deallocate(const char *str, void *v)
  *                    PadSynth Setup                                         *
  *****************************************************************************/
 
-// This lets MiddleWare compute non-realtime PAD synth data and send it to the backend
-void preparePadSynth(string path, PADnoteParameters *p, rtosc::RtData &d)
-{
-    //printf("preparing padsynth parameters\n");
-    assert(!path.empty());
-    path += "sample";
-
-#ifdef WIN32
-    unsigned num = p->sampleGenerator([&path,&d]
-                       (unsigned N, PADnoteParameters::Sample &&s)
-                       {
-                           //printf("sending info to '%s'\n",
-                           //       (path+to_s(N)).c_str());
-                           d.chain((path+to_s(N)).c_str(), "ifb",
-                                   s.size, s.basefreq, sizeof(float*), &s.smp);
-                       }, []{return false;}, 1);
-#else
-    std::mutex rtdata_mutex;
-    unsigned num = p->sampleGenerator([&rtdata_mutex, &path,&d]
-                       (unsigned N, PADnoteParameters::Sample&& s)
-                       {
-                           //printf("sending info to '%s'\n",
-                           //       (path+to_s(N)).c_str());
-                           rtdata_mutex.lock();
-                           // send non-realtime computed data to PADnoteParameters
-                           d.chain((path+to_s(N)).c_str(), "ifb",
-                                   s.size, s.basefreq, sizeof(float*), &s.smp);
-                           rtdata_mutex.unlock();
-                       }, []{return false;});
-#endif
-
-    //clear out unused samples
-    for(unsigned i = num; i < PAD_MAX_SAMPLES; ++i) {
-        d.chain((path+to_s(i)).c_str(), "ifb",
-                0, 440.0f, sizeof(float*), NULL);
+// One request to compute the samples of a PADnoteParameters instance.
+// It runs on the PadGenPool with a private copy of the parameters, as the
+// user may keep editing (or even free) the original ones meanwhile.
+// MiddleWare hands the samples to the backend, see deliverPads().
+// A preview computes the same samples with the smallest sample size.
+struct PadPrepare
+{
+    PadPrepare(const SYNTH_T &synth, PADnoteParameters &p, bool preview)
+        :fft(synth.oscilsize), pars(synth, &fft), preview(preview),
+         cancelled(false), done(false), nsamples(0)
+    {
+        pars.paste(p);
+        if(preview)
+            pars.Pquality.samplesize = 0;
     }
-}
+
+    FFTwrapper        fft;
+    PADnoteParameters pars;
+    const bool        preview;
+    //set by MiddleWare once the samples are obsolete
+    std::atomic<bool> cancelled;
+
+    //guarded by mutex
+    std::mutex mutex;
+    std::vector<std::pair<int, PADnoteParameters::Sample>> ready;
+    bool done;
+    int  nsamples;
+};
 
 /******************************************************************************
  *                      MIDI Serialization                                    *
@@ -408,34 +403,28 @@ struct NonRtObjStore
     void handlePad(const char *msg, rtosc::RtData &d) {
         string obj_rl(d.message, msg);
         void *pad = get(obj_rl);
-        if(!strcmp(msg, "prepare")) {
-            preparePadSynth(obj_rl, (PADnoteParameters*)pad, d);
-            d.matches++;
-            d.reply((obj_rl+"needPrepare").c_str(), "F");
-        } else {
-            if(pad)
-            {
-                strcpy(d.loc, obj_rl.c_str());
-                d.obj = pad;
-                PADnoteParameters::non_realtime_ports.dispatch(msg, d);
-                if(d.matches && rtosc_narguments(msg)) {
-                    if(!strcmp(msg, "oscilgen/prepare"))
-                        ; //ignore
-                    else {
-                        d.reply((obj_rl+"needPrepare").c_str(), "T");
-                    }
+        if(pad)
+        {
+            strcpy(d.loc, obj_rl.c_str());
+            d.obj = pad;
+            PADnoteParameters::non_realtime_ports.dispatch(msg, d);
+            if(d.matches && rtosc_narguments(msg)) {
+                if(!strcmp(msg, "oscilgen/prepare"))
+                    ; //ignore
+                else {
+                    d.reply((obj_rl+"needPrepare").c_str(), "T");
                 }
             }
-            else {
-                // print warning, except in rtosc::walk_ports
-                if(!strstr(d.message, "/pointer"))
-                {
-                    fprintf(stderr, "Warning: trying to access pad synth object "
-                                    "\"%s\", which does not exist\n",
-                            obj_rl.c_str());
-                }
-                d.obj = nullptr; // tell walk_ports that there's nothing to recurse here...
+        }
+        else {
+            // print warning, except in rtosc::walk_ports
+            if(!strstr(d.message, "/pointer"))
+            {
+                fprintf(stderr, "Warning: trying to access pad synth object "
+                                "\"%s\", which does not exist\n",
+                        obj_rl.c_str());
             }
+            d.obj = nullptr; // tell walk_ports that there's nothing to recurse here...
         }
     }
 };
@@ -510,6 +499,11 @@ namespace Nio
                     d.reply(d.loc, Nio::getAudioCompressor() ? "T" : "F");
                 else
                     Nio::setAudioCompressor(rtosc_argument(msg,0).T);}},
+        //events, dropped events, max latency in us (since the last query)
+        {"midi-stats:", 0, 0, [](const char *, rtosc::RtData &d) {
+                unsigned events, overflows, latency;
+                Nio::getMidiStats(events, overflows, latency);
+                d.reply(d.loc, "iii", events, overflows, latency);}},
     };
 }
 
@@ -633,6 +627,7 @@ public:
         p->applyparameters(isLateLoad);
 #endif
 
+        cancelPads("/part"+to_s(npart)+"/");
         obj_store.extractPart(p, npart);
         kits.extractPart(p, npart);
 
@@ -657,6 +652,7 @@ public:
         p->partno  = npart % NUM_MIDI_CHANNELS;
         p->Prcvchn = npart % NUM_MIDI_CHANNELS;
         p->applyparameters();
+        cancelPads("/part"+to_s(npart)+"/");
         obj_store.extractPart(p, npart);
         kits.extractPart(p, npart);
 
@@ -694,6 +690,25 @@ public:
             m->applyparameters();
         }
 
+        installMaster(m);
+        return 0;
+    }
+
+    //Same for the data of Master::getalldata()
+    void loadMasterData(const char *data)
+    {
+        Master *m = new Master(synth, config);
+        m->uToB = uToB;
+        m->bToU = bToU;
+        m->putalldata(data);
+        m->applyparameters();
+        m->initialize_rt();
+
+        installMaster(m);
+    }
+
+    void installMaster(Master *m)
+    {
         //Update resource locator table
         updateResources(m);
 
@@ -703,7 +718,6 @@ public:
         //Give it to the backend and wait for the old part to return for
         //deallocation
         parent->transmitMsg("/load-master", "b", sizeof(Master*), &m);
-        return 0;
     }
 
     // Save all possible parameters
@@ -882,6 +896,7 @@ public:
 
     void updateResources(Master *m)
     {
+        cancelPads("");
         obj_store.clear();
         obj_store.extractMaster(m);
         for(int i=0; i<NUM_MIDI_PARTS; ++i)
@@ -913,6 +928,8 @@ public:
             multi_thread_source.free(m);
         }
 
+        deliverPads();
+
         autoSave.tick();
 
         heartBeat(master);
@@ -930,6 +947,13 @@ public:
     void kitEnable(const char *msg);
     void kitEnable(int part, int kit, int type);
 
+    // Compute the PADsynth samples of the object at path in the background
+    void preparePad(const std::string &path, rtosc::RtData &d);
+    // Send the samples which are done to the backend
+    void deliverPads(void);
+    // Drop all requests for objects below the prefix
+    void cancelPads(const std::string &prefix);
+
     // Handle an event with special cases
     void handleMsg(const char *msg, bool msg_comes_from_realtime = false);
 
@@ -978,6 +1002,10 @@ public:
     //Synth Engine Parameters
     ParamStore kits;
 
+    //Workers computing PADsynth samples, with the requests in flight
+    std::shared_ptr<PadGenPool> padGenPool;
+    std::list<std::pair<std::string, std::shared_ptr<PadPrepare>>> padPrepare;
+
     //Callback When Waiting on async events
     void(*idle)(void*);
     void* idle_ptr;
@@ -1521,7 +1549,11 @@ static rtosc::Ports nonRtParamPorts = {
     {"part#" STRINGIFY(NUM_MIDI_PARTS)
         "/kit#" STRINGIFY(NUM_KIT_ITEMS) "/padpars/", 0, &PADnoteParameters::non_realtime_ports,
         rBegin
-        impl.obj_store.handlePad(chomp(chomp(chomp(msg))), d);
+        const char *sub = chomp(chomp(chomp(msg)));
+        if(!strcmp(sub, "prepare"))
+            impl.preparePad(string(d.message, sub), d);
+        else
+            impl.obj_store.handlePad(sub, d);
         rEnd},
 };
 
@@ -1646,6 +1678,13 @@ static rtosc::Ports middwareSnoopPortsWithoutNonRtParams = {
         const char *file = rtosc_argument(msg, 0).s;
         impl.loadKbm(file, d);
         rEnd},
+    {"pad_cache_stats:", rDoc("Hits, misses, stores and evictions of the "
+                              "PADsynth sample cache"), 0,
+        rBegin;
+        const PadSampleCache::Stats s = PadSampleCache::stats();
+        d.reply(d.loc, "iiii", (int)s.hits, (int)s.misses,
+                (int)s.stores, (int)s.evictions);
+        rEnd},
     {"save_xmz:s:st:stT:stF", 0, 0, save_cb<false>},
     {"save_osc:s:st:stT:stF", 0, 0, save_cb<true>},
     {"save_xiz:is", 0, 0,
@@ -1949,6 +1988,16 @@ MiddleWareImpl::MiddleWareImpl(MiddleWare *mw, SYNTH_T synth_,
                 int res = master->saveXML(save_file.c_str());
                 (void)res;});})
 {
+    PadSampleCache::configure(PadSampleCache::defaultDir(),
+                              (uint64_t)config->cfg.PadCacheSize << 20);
+    padGenPool = PadGenPool::acquire();
+
+    //The plans of the last runs are loaded before any FFT is planned
+    char wisdom[MAX_STRING_SIZE];
+    config->getFFTWisdomFileName(wisdom, MAX_STRING_SIZE);
+    FFT_measurePlans(config->cfg.MeasureFFT);
+    FFT_loadWisdom(wisdom);
+
     bToU = new rtosc::ThreadLink(4096*2*16,1024/16);
     uToB = new rtosc::ThreadLink(4096*2*16,1024/16);
     midi_mapper.base_ports = &Master::ports;
@@ -2015,8 +2064,22 @@ void MiddleWareImpl::discardAllbToUButHandleFree()
 
 MiddleWareImpl::~MiddleWareImpl(void)
 {
+    //Requests in flight still refer to our synth settings
+    cancelPads("");
+    while(!padPrepare.empty()) {
+        deliverPads();
+        os_usleep(1000);
+    }
+
     discardAllbToUButHandleFree();
 
+    //Measured plans are too slow to be made again on every start
+    if(config->cfg.MeasureFFT) {
+        char wisdom[MAX_STRING_SIZE];
+        config->getFFTWisdomFileName(wisdom, MAX_STRING_SIZE);
+        FFT_saveWisdom(wisdom);
+    }
+
     if(server)
         lo_server_free(server);
 
@@ -2336,6 +2399,94 @@ void MiddleWareImpl::kitEnable(int part, int kit, int type)
         uToB->write(url.c_str(), "b", sizeof(void*), &ptr);
 }
 
+void MiddleWareImpl::preparePad(const std::string &path, rtosc::RtData &d)
+{
+    d.matches++;
+    PADnoteParameters *p = (PADnoteParameters*)obj_store.get(path);
+    if(!p)
+        return;
+
+    //The samples of older requests (e.g. while a knob is turned) are obsolete
+    cancelPads(path);
+
+    //A small preview can be heard long before the full quality samples
+    //are done, it is queued first and replaced by them
+    const bool preview[2] = {true, false};
+    for(bool pv:preview) {
+        if(pv && p->Pquality.samplesize == 0)
+            continue;
+        auto job = std::make_shared<PadPrepare>(synth, *p, pv);
+        padPrepare.emplace_back(path, job);
+        padGenPool->submit([job](PadGenPool::Scratch&) {
+                const int num = job->pars.sampleGenerator(
+                    [&job](int N, PADnoteParameters::Sample &&s) {
+                        std::lock_guard<std::mutex> lock(job->mutex);
+                        job->ready.emplace_back(N, s);
+                    },
+                    [&job]{return job->cancelled.load();},
+                    0, !job->preview); //previews are not worth caching
+                std::lock_guard<std::mutex> lock(job->mutex);
+                job->nsamples = num;
+                job->done     = true;
+            });
+    }
+}
+
+void MiddleWareImpl::deliverPads(void)
+{
+    for(auto itr = padPrepare.begin(); itr != padPrepare.end();) {
+        PadPrepare &job = *itr->second;
+        std::vector<std::pair<int, PADnoteParameters::Sample>> ready;
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            ready.swap(job.ready);
+            done = job.done;
+        }
+
+        //The full quality samples must never be replaced by the preview
+        if(!job.preview && !ready.empty())
+            for(auto &p:padPrepare)
+                if(p.second->preview && p.first == itr->first)
+                    p.second->cancelled = true;
+
+        const string path = itr->first + "sample";
+        for(auto &r:ready) {
+            PADnoteParameters::Sample &s = r.second;
+            if(job.cancelled)
+                delete[] s.smp;
+            else // send non-realtime computed data to PADnoteParameters
+                write((path+to_s(r.first)).c_str(), "ifb",
+                      s.size, s.basefreq, sizeof(float*), &s.smp);
+        }
+
+        if(!done) {
+            ++itr;
+            continue;
+        }
+        if(!job.cancelled && !job.preview) {
+            //clear out unused samples
+            for(int i = job.nsamples; i < PAD_MAX_SAMPLES; ++i) {
+                float *smp = NULL;
+                write((path+to_s(i)).c_str(), "ifb",
+                      0, 440.0f, sizeof(float*), &smp);
+            }
+            char buf[1024];
+            rtosc_message(buf, sizeof(buf), (itr->first+"needPrepare").c_str(),
+                          "F");
+            broadcastToRemote(buf);
+        }
+        itr = padPrepare.erase(itr);
+    }
+}
+
+void MiddleWareImpl::cancelPads(const std::string &prefix)
+{
+    for(auto &p:padPrepare)
+        if(!p.first.compare(0, prefix.size(), prefix))
+            p.second->cancelled = true;
+}
+
 
 /*
  * Handle all messages traveling to the realtime side.
@@ -2696,6 +2847,11 @@ PresetsStore& MiddleWare::getPresetsStore()
     return impl->presetsstore;
 }
 
+void MiddleWare::loadMasterData(const char *data)
+{
+    impl->loadMasterData(data);
+}
+
 void MiddleWare::switchMaster(Master* new_master)
 {
     // this function is kept similar to loadMaster
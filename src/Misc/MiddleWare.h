@@ -97,6 +97,11 @@ class MiddleWare
         const PresetsStore& getPresetsStore() const;
         PresetsStore& getPresetsStore();
 
+        //!Load the data of Master::getalldata() into a new master, which
+        //!replaces the current one once the backend reaches its next buffer
+        //!(so the audio keeps running while it is prepared)
+        void loadMasterData(const char *data);
+
         //!Make @p new_master the current master
         //!@warning use with care, and only in frozen state
         void switchMaster(Master* new_master);
@@ -0,0 +1,260 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  OfflineRender.cpp - Render MIDI Files Faster Than Realtime
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "OfflineRender.h"
+#include "Master.h"
+#include "MiddleWare.h"
+#include "WavFile.h"
+#include "Util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace zyn {
+
+//Output below this level counts as silence when looking for the tail's end
+#define OFFLINE_SILENCE 1e-5f
+
+namespace {
+struct RawEvent {
+    uint64_t      tick;
+    unsigned char head, num, value;
+    uint32_t      tempo; //microseconds per quarter note, for tempo events
+};
+}
+
+static uint32_t be32(const unsigned char *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static uint16_t be16(const unsigned char *p)
+{
+    return p[0] << 8 | p[1];
+}
+
+static bool varlen(const unsigned char *&p, const unsigned char *end,
+                   uint32_t &v)
+{
+    v = 0;
+    for(int i = 0; i < 4 && p < end; ++i) {
+        const unsigned char c = *p++;
+        v = v << 7 | (c & 0x7f);
+        if(!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static bool parseTrack(const unsigned char *t, const unsigned char *end,
+                       std::vector<RawEvent> &raw)
+{
+    uint64_t      tick   = 0;
+    unsigned char status = 0;
+    while(t < end) {
+        uint32_t delta, len;
+        if(!varlen(t, end, delta) || t >= end)
+            return false;
+        tick += delta;
+
+        unsigned char head = *t;
+        if(head & 0x80)
+            ++t;
+        else if(status)
+            head = status; //running status
+        else
+            return false;
+
+        if(head == 0xff) { //meta event
+            if(t >= end)
+                return false;
+            const unsigned char type = *t++;
+            if(!varlen(t, end, len) || len > (size_t)(end - t))
+                return false;
+            if(type == 0x51 && len == 3)
+                raw.push_back({tick, 0xff, 0, 0,
+                               (uint32_t)t[0] << 16 | t[1] << 8 | t[2]});
+            if(type == 0x2f) //end of track
+                return true;
+            t     += len;
+            status = 0;
+            continue;
+        }
+        if(head == 0xf0 || head == 0xf7) { //SysEx
+            if(!varlen(t, end, len) || len > (size_t)(end - t))
+                return false;
+            t     += len;
+            status = 0;
+            continue;
+        }
+        if(head > 0xf0)
+            return false;
+
+        status = head;
+        const int n = ((head & 0xe0) == 0xc0) ? 1 : 2; //program/pressure
+        if(end - t < n)
+            return false;
+        raw.push_back({tick, head, t[0], (unsigned char)(n == 2 ? t[1] : 0), 0});
+        t += n;
+    }
+    return true;
+}
+
+int MidiFile::parse(const unsigned char *data, size_t len)
+{
+    events.clear();
+    if(len < 14 || memcmp(data, "MThd", 4))
+        return -1;
+    const uint32_t hlen = be32(data + 4);
+    if(hlen < 6 || hlen > len - 8)
+        return -1;
+    const uint16_t division = be16(data + 12);
+    if(!division)
+        return -1;
+
+    //Collect the events of all tracks, unknown chunks are skipped
+    std::vector<RawEvent> raw;
+    const unsigned char *p = data + 8 + hlen, *end = data + len;
+    while(end - p >= 8) {
+        const uint32_t clen = be32(p + 4);
+        if(clen > (size_t)(end - p - 8))
+            return -1;
+        if(!memcmp(p, "MTrk", 4) && !parseTrack(p + 8, p + 8 + clen, raw))
+            return -1;
+        p += 8 + clen;
+    }
+
+    //Merge them, the tempo changes of the first track come first
+    std::stable_sort(raw.begin(), raw.end(),
+            [](const RawEvent &a, const RawEvent &b) {return a.tick < b.tick;});
+
+    double spt; //seconds per tick
+    const bool smpte = division & 0x8000;
+    if(smpte)
+        spt = 1.0 / (-(int8_t)(division >> 8) * (division & 0xff));
+    else
+        spt = 0.5 / division; //120 bpm until the first tempo event
+
+    double   time = 0.0;
+    uint64_t tick = 0;
+    for(const RawEvent &ev:raw) {
+        time += (ev.tick - tick) * spt;
+        tick  = ev.tick;
+        if(ev.head != 0xff)
+            events.push_back({time, ev.head, ev.num, ev.value});
+        else if(!smpte)
+            spt = ev.tempo * 1e-6 / division;
+    }
+    return 0;
+}
+
+int MidiFile::load(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if(!file)
+        return -1;
+    std::vector<unsigned char> data;
+    unsigned char buf[4096];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), file)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(file);
+    return parse(data.data(), data.size());
+}
+
+double MidiFile::length(void) const
+{
+    return events.empty() ? 0.0 : events.back().time;
+}
+
+OfflineRender::OfflineRender(Master &master, MiddleWare *middleware)
+    :maxtail(30.0f), master(master), middleware(middleware)
+{}
+
+void OfflineRender::dispatch(const MidiFile::Event &ev)
+{
+    const char chan = ev.head & 0x0f;
+    switch(ev.head & 0xf0) {
+        case 0x80:
+            master.noteOff(chan, ev.num);
+            break;
+        case 0x90:
+            master.noteOn(chan, ev.num, ev.value);
+            break;
+        case 0xa0:
+            master.polyphonicAftertouch(chan, ev.num, ev.value);
+            break;
+        case 0xb0:
+            if(ev.num != C_bankselectmsb && ev.num != C_bankselectlsb)
+                master.setController(chan, ev.num, ev.value);
+            break;
+        case 0xe0:
+            master.setController(chan, C_pitchwheel,
+                                 ev.num + ev.value * 128 - 8192);
+            break;
+    }
+}
+
+size_t OfflineRender::render(const MidiFile &midi, const sink_t &sink)
+{
+    const SYNTH_T &synth = master.synth;
+    const int      bs    = synth.buffersize;
+    std::vector<float> outl(bs), outr(bs);
+
+    const size_t tailend = (size_t)((midi.length() + maxtail) * synth.samplerate);
+    size_t pos = 0, quiet = 0, next = 0;
+    while(true) {
+        for(; next < midi.events.size(); ++next) {
+            const size_t at = (size_t)(midi.events[next].time * synth.samplerate + 0.5);
+            if(at >= pos + bs)
+                break;
+            master.setEventOffset(at - pos);
+            dispatch(midi.events[next]);
+        }
+
+        master.AudioOut(outl.data(), outr.data());
+        if(middleware)
+            middleware->tick();
+        sink(outl.data(), outr.data(), bs);
+        pos += bs;
+
+        if(next < midi.events.size())
+            continue;
+        float peak = 0.0f;
+        for(int i = 0; i < bs; ++i)
+            peak = std::max(peak, std::max(fabsf(outl[i]), fabsf(outr[i])));
+        quiet = peak < OFFLINE_SILENCE ? quiet + bs : 0;
+        if(quiet >= synth.samplerate || pos >= tailend)
+            break;
+    }
+    return pos;
+}
+
+long OfflineRender::render(const MidiFile &midi, const char *wavfile)
+{
+    WavFile file(wavfile, master.synth.samplerate, 2);
+    if(!file.good())
+        return -1;
+
+    std::vector<short> buf;
+    return render(midi, [&](const float *outl, const float *outr, int nsamples) {
+            buf.resize(2 * nsamples);
+            for(int i = 0; i < nsamples; ++i) {
+                buf[2 * i]     = limit((int)(outl[i] * 32767.0f), -32768, 32767);
+                buf[2 * i + 1] = limit((int)(outr[i] * 32767.0f), -32768, 32767);
+            }
+            file.writeStereoSamples(nsamples, buf.data());
+        });
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  OfflineRender.h - Render MIDI Files Faster Than Realtime
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "../globals.h"
+
+namespace zyn {
+
+class Master;
+class MiddleWare;
+
+/**
+ * Channel events of a Standard MIDI File (format 0 or 1)
+ *
+ * The tracks are merged and the tempo map is applied, so every event knows
+ * its time in seconds. SysEx and meta events other than tempo are dropped.
+ */
+class MidiFile
+{
+    public:
+        struct Event {
+            double        time; //seconds from the start of the file
+            unsigned char head; //status byte incl. channel
+            unsigned char num, value;
+        };
+
+        //! @return 0 on success, -1 if the file can't be read or parsed
+        int load(const char *filename) NONREALTIME;
+        //! @return 0 on success, -1 if the data is no Standard MIDI File
+        int parse(const unsigned char *data, size_t len) NONREALTIME;
+
+        //! Time of the last event
+        double length(void) const;
+
+        std::vector<Event> events; //ordered by time
+};
+
+/**
+ * Drives Master::AudioOut() as fast as the CPU allows
+ *
+ * - Notes start at their exact sample (see Master::setEventOffset()), other
+ *   events are applied at the start of the buffer they fall into
+ * - After the last event the release tail is rendered until the output has
+ *   been silent for a second (or for at most maxtail seconds)
+ * - Parts are spread over the render threads of the Master (see -T)
+ * - Program and bank changes need the bank loading of the live
+ *   MiddleWare and are ignored
+ */
+class OfflineRender
+{
+    public:
+        typedef std::function<void(const float *outl, const float *outr,
+                                   int nsamples)> sink_t;
+
+        //! @param middleware is ticked between buffers, if given
+        OfflineRender(Master &master, MiddleWare *middleware = nullptr);
+
+        //! Render the events, returns the number of samples passed to sink
+        size_t render(const MidiFile &midi, const sink_t &sink) NONREALTIME;
+        //! Render the events into a 16 bit stereo WAV file
+        //! @return the number of samples, -1 if the file can't be written
+        long render(const MidiFile &midi, const char *wavfile) NONREALTIME;
+
+        float maxtail; //seconds rendered at most after the last event
+
+    private:
+        void dispatch(const MidiFile::Event &ev);
+
+        Master     &master;
+        MiddleWare *middleware;
+};
+
+}
@@ -0,0 +1,163 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  PadGenPool.cpp - Worker Threads For PADsynth Sample Generation
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "PadGenPool.h"
+#include "Denormals.h"
+#include <algorithm>
+
+namespace zyn {
+
+//Pool and scratch memory of the current thread, if it is a worker
+static thread_local PadGenPool          *worker_pool    = nullptr;
+static thread_local PadGenPool::Scratch *worker_scratch = nullptr;
+
+static std::mutex                pool_mutex;
+static std::weak_ptr<PadGenPool> process_pool;
+
+FFTwrapper *PadGenPool::Scratch::fft(int fftsize)
+{
+    std::unique_ptr<FFTwrapper> &fft = ffts[fftsize];
+    if(!fft)
+        fft.reset(new FFTwrapper(fftsize));
+    return fft.get();
+}
+
+FFTfreqBuffer PadGenPool::Scratch::freqs(int fftsize)
+{
+    //see FFTfreqBuffer::allocSize()
+    if(freqbuf.size() < (size_t)fftsize + 1)
+        freqbuf.resize(fftsize + 1);
+    return fft(fftsize)->allocFreqBuf(freqbuf.data());
+}
+
+float *PadGenPool::Scratch::buffer(int size)
+{
+    if(floatbuf.size() < (size_t)size)
+        floatbuf.resize(size);
+    return floatbuf.data();
+}
+
+PadGenPool::PadGenPool(int nthreads)
+    :quit(false)
+{
+    for(int i = 0; i < nthreads; ++i)
+        workers.emplace_back(&PadGenPool::worker, this);
+}
+
+PadGenPool::~PadGenPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for(auto &t:workers)
+        t.join();
+}
+
+void PadGenPool::execute(Job &job, std::unique_lock<std::mutex> &lock,
+                         Scratch &scratch)
+{
+    const int task = job.next++;
+    if(job.next == job.ntasks)
+        jobs.erase(std::find(jobs.begin(), jobs.end(), &job));
+    lock.unlock();
+    job.fn(task, scratch);
+    lock.lock();
+    if(--job.unfinished)
+        return;
+    if(job.detached)
+        delete &job;
+    else
+        finished.notify_all();
+}
+
+void PadGenPool::worker(void)
+{
+    flushDenormals();
+    Scratch scratch;
+    worker_pool    = this;
+    worker_scratch = &scratch;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true) {
+        if(!jobs.empty())
+            execute(*jobs.front(), lock, scratch);
+        else if(quit)
+            break;
+        else
+            wake.wait(lock);
+    }
+}
+
+void PadGenPool::run(int ntasks, const task_fn &fn)
+{
+    if(ntasks <= 0)
+        return;
+    if(workers.empty()) {
+        Scratch scratch;
+        for(int i = 0; i < ntasks; ++i)
+            fn(i, scratch);
+        return;
+    }
+
+    Job job{fn, ntasks, 0, ntasks, false};
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs.push_back(&job);
+    wake.notify_all();
+
+    //A worker waiting for the others could starve the pool, so it helps
+    if(worker_pool == this)
+        while(job.next < job.ntasks)
+            execute(job, lock, *worker_scratch);
+    finished.wait(lock, [&job]{return job.unfinished == 0;});
+}
+
+void PadGenPool::submit(job_fn fn)
+{
+    if(workers.empty()) {
+        Scratch scratch;
+        fn(scratch);
+        return;
+    }
+
+    Job *job = new Job{[fn](int, Scratch &s){fn(s);}, 1, 0, 1, true};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+    wake.notify_one();
+}
+
+std::shared_ptr<PadGenPool> PadGenPool::acquire(void)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    std::shared_ptr<PadGenPool> pool = process_pool.lock();
+    if(!pool) {
+#ifdef WIN32
+        //C++11 threads are broken with mingw cross compilation
+        const int nthreads = 0;
+#else
+        const int nthreads = std::max(1u, std::thread::hardware_concurrency());
+#endif
+        pool = std::make_shared<PadGenPool>(nthreads);
+        process_pool = pool;
+    }
+    return pool;
+}
+
+std::shared_ptr<PadGenPool> PadGenPool::current(void)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return process_pool.lock();
+}
+
+}
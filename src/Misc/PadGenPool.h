@@ -0,0 +1,104 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  PadGenPool.h - Worker Threads For PADsynth Sample Generation
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../globals.h"
+#include "../DSP/FFTwrapper.h"
+
+namespace zyn {
+
+/**
+ * Long lived worker threads which compute the samples of PADnoteParameters.
+ *
+ * - One pool is shared by all MiddleWare instances of the process, so
+ *   several instruments never run more generator threads than cores
+ * - A job is split into tasks (one per sample) which idle workers claim one
+ *   at a time, oldest job first; a worker which is done with its own job
+ *   takes over the remaining tasks of the other jobs
+ * - Every worker keeps its FFTs and buffers between tasks, so the FFT plans
+ *   of a sample size are only created once per worker
+ * - Cancelling is up to the tasks: sampleGenerator() checks its do_abort
+ *   callback before each sample
+ */
+class PadGenPool
+{
+    public:
+        //! Memory of one worker, kept for all the tasks it runs
+        class Scratch
+        {
+            public:
+                Scratch(void) = default;
+                Scratch(const Scratch&) = delete;
+
+                //! FFT of the given size, planned on first use
+                FFTwrapper *fft(int fftsize);
+                //! Frequency buffer for fft(fftsize)
+                FFTfreqBuffer freqs(int fftsize);
+                //! Float buffer of at least size values
+                float *buffer(int size);
+
+            private:
+                std::map<int, std::unique_ptr<FFTwrapper>> ffts;
+                std::vector<fft_t> freqbuf;
+                std::vector<float> floatbuf;
+        };
+
+        typedef std::function<void(int task, Scratch &scratch)> task_fn;
+        typedef std::function<void(Scratch &scratch)> job_fn;
+
+        //! @param nthreads number of workers, 0 runs everything on the caller
+        PadGenPool(int nthreads) NONREALTIME;
+        ~PadGenPool() NONREALTIME;
+        PadGenPool(const PadGenPool&) = delete;
+
+        //! Run fn for every task in [0, ntasks) and return when all are done
+        //! A worker which calls run() works on the tasks itself
+        void run(int ntasks, const task_fn &fn) NONREALTIME;
+        //! Run fn once on a worker, returns at once
+        void submit(job_fn fn) NONREALTIME;
+
+        int threads(void) const { return (int)workers.size(); }
+
+        //! The pool of the process, created on first use
+        static std::shared_ptr<PadGenPool> acquire(void) NONREALTIME;
+        //! The pool of the process, if anyone holds one
+        static std::shared_ptr<PadGenPool> current(void);
+
+    private:
+        struct Job {
+            task_fn fn;
+            int     ntasks;
+            int     next;
+            int     unfinished;
+            bool    detached; //owned by the pool, deleted when done
+        };
+
+        void worker(void);
+        void execute(Job &job, std::unique_lock<std::mutex> &lock,
+                     Scratch &scratch);
+
+        std::mutex              mutex;
+        std::condition_variable wake;     //new tasks were queued
+        std::condition_variable finished; //a job of run() was finished
+        std::deque<Job*>        jobs;     //jobs with unclaimed tasks
+        std::vector<std::thread> workers;
+        bool quit;
+};
+
+}
@@ -0,0 +1,366 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  PadSampleCache.cpp - On Disk Cache Of Generated PADsynth Samples
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "PadSampleCache.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <vector>
+#ifndef WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace zyn {
+
+#define PAD_CACHE_VERSION 1
+#define PAD_CACHE_SUFFIX  ".padsmp"
+#define PAD_CACHE_TMP     ".tmp"
+//Seconds after which a temporary file is left over from an aborted writer
+#define PAD_CACHE_STALE   600
+//Sample tables start page aligned, so they can be mapped directly
+#define PAD_CACHE_ALIGN   4096
+
+struct PadCacheHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t nsamples;
+    uint32_t samplesize;
+    uint32_t keysize;
+    float    basefreq[PAD_MAX_SAMPLES];
+};
+
+static const char pad_cache_magic[8] = {'Z', 'Y', 'N', 'P', 'A', 'D', 'C', 0};
+
+static std::mutex  cache_mutex;
+static std::string cache_dir;
+static uint64_t    cache_max = 0;
+
+static std::atomic<uint64_t> stat_hits(0), stat_misses(0);
+static std::atomic<uint64_t> stat_stores(0), stat_evictions(0);
+
+//the tables repeat their first samples for the interpolation
+static const int extra_samples = PADnoteParameters::extra_samples;
+
+static size_t dataOffset(size_t keysize)
+{
+    return (sizeof(PadCacheHeader) + keysize + PAD_CACHE_ALIGN - 1)
+           / PAD_CACHE_ALIGN * PAD_CACHE_ALIGN;
+}
+
+static size_t entrySize(size_t keysize, int nsamples, int samplesize)
+{
+    return dataOffset(keysize)
+           + (size_t)nsamples * (samplesize + extra_samples) * sizeof(float);
+}
+
+//FNV-1a, only used to name the files, the full key is compared on load
+static std::string entryPath(const std::string &key)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(unsigned char c:key)
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache_dir + "/" + name + PAD_CACHE_SUFFIX;
+}
+
+bool PadSampleCache::enabled(void)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache_max != 0 && !cache_dir.empty();
+}
+
+PadSampleCache::Stats PadSampleCache::stats(void)
+{
+    return Stats{stat_hits, stat_misses, stat_stores, stat_evictions};
+}
+
+std::string PadSampleCache::defaultDir(void)
+{
+    const char *xdg  = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if(xdg && *xdg)
+        return std::string(xdg) + "/zynaddsubfx/padsynth";
+    if(home && *home)
+        return std::string(home) + "/.cache/zynaddsubfx/padsynth";
+    return "";
+}
+
+#ifdef WIN32
+
+//No mmap(), so the cache always stays disabled
+void PadSampleCache::configure(const std::string &, uint64_t)
+{
+}
+
+int PadSampleCache::load(const std::string &, int, int,
+                         PADnoteParameters::callback)
+{
+    return 0;
+}
+
+PadSampleCache::Writer::Writer(const std::string &, int, int)
+    :fd(-1), nsamples(0), samplesize(0), added(0), failed(true)
+{
+}
+
+PadSampleCache::Writer::~Writer()
+{
+}
+
+void PadSampleCache::Writer::add(int, const PADnoteParameters::Sample &)
+{
+}
+
+void PadSampleCache::Writer::commit(void)
+{
+}
+
+void PadSampleCache::evict(void)
+{
+}
+
+#else
+
+//mkdir -p
+static bool makeDirs(const std::string &dir)
+{
+    for(size_t pos = dir.find('/', 1); ; pos = dir.find('/', pos + 1)) {
+        mkdir(dir.substr(0, pos).c_str(), 0755);
+        if(pos == std::string::npos)
+            break;
+    }
+    struct stat st;
+    return !stat(dir.c_str(), &st) && S_ISDIR(st.st_mode);
+}
+
+void PadSampleCache::configure(const std::string &dir, uint64_t maxbytes)
+{
+    const bool usable = maxbytes && !dir.empty() && makeDirs(dir);
+    if(maxbytes && !usable)
+        fprintf(stderr, "PADsynth sample cache disabled, can't create '%s'\n",
+                dir.c_str());
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache_dir = usable ? dir : "";
+        cache_max = usable ? maxbytes : 0;
+    }
+    if(usable)
+        evict();
+}
+
+int PadSampleCache::load(const std::string &key, int nsamples, int samplesize,
+                         PADnoteParameters::callback cb)
+{
+    if(!enabled())
+        return 0;
+
+    const std::string path = entryPath(key);
+    const size_t      size = entrySize(key.size(), nsamples, samplesize);
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        stat_misses++;
+        return 0;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if(!fstat(fd, &st) && (size_t)st.st_size == size)
+        map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        stat_misses++;
+        return 0;
+    }
+
+    const PadCacheHeader &h = *(const PadCacheHeader*)map;
+    const char *stored_key = (const char*)map + sizeof(PadCacheHeader);
+    if(memcmp(h.magic, pad_cache_magic, sizeof(h.magic))
+       || h.version != PAD_CACHE_VERSION
+       || h.nsamples != (uint32_t)nsamples
+       || h.samplesize != (uint32_t)samplesize
+       || h.keysize != key.size()
+       || memcmp(stored_key, key.data(), key.size())) {
+        munmap(map, size);
+        stat_misses++;
+        return 0;
+    }
+
+    madvise(map, size, MADV_SEQUENTIAL);
+    const float *tables = (const float*)((const char*)map + dataOffset(key.size()));
+    const int    len    = samplesize + extra_samples;
+    //The samples are handed out as heap copies: their owners free them
+    //with delete[] and the audio thread must not fault in mapped pages
+    for(int n = 0; n < nsamples; ++n) {
+        PADnoteParameters::Sample smp;
+        smp.size     = samplesize;
+        smp.basefreq = h.basefreq[n];
+        smp.smp      = new float[len];
+        memcpy(smp.smp, tables + (size_t)n * len, len * sizeof(float));
+        cb(n, std::move(smp));
+    }
+    munmap(map, size);
+
+    //mark as recently used for the eviction
+    utimes(path.c_str(), NULL);
+    stat_hits++;
+    return nsamples;
+}
+
+static bool writeAll(int fd, const void *data, size_t size, size_t offset)
+{
+    const char *p = (const char*)data;
+    while(size) {
+        const ssize_t n = pwrite(fd, p, size, offset);
+        if(n <= 0)
+            return false;
+        p      += n;
+        size   -= n;
+        offset += n;
+    }
+    return true;
+}
+
+PadSampleCache::Writer::Writer(const std::string &key_, int nsamples_,
+                               int samplesize_)
+    :key(key_), fd(-1), nsamples(nsamples_), samplesize(samplesize_),
+     added(0), failed(true)
+{
+    if(key.empty() || !enabled())
+        return;
+    static std::atomic<int> counter(0);
+    path    = entryPath(key);
+    tmppath = path + "." + os_pid_as_padded_string() + "-"
+              + to_s(counter++) + PAD_CACHE_TMP;
+    fd = open(tmppath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        return;
+    failed = ftruncate(fd, entrySize(key.size(), nsamples, samplesize)) != 0;
+    memset(basefreq, 0, sizeof(basefreq));
+}
+
+PadSampleCache::Writer::~Writer()
+{
+    if(fd >= 0) {
+        close(fd);
+        unlink(tmppath.c_str());
+    }
+}
+
+void PadSampleCache::Writer::add(int n, const PADnoteParameters::Sample &smp)
+{
+    if(failed || n < 0 || n >= nsamples || smp.size != samplesize)
+        return;
+    const size_t len = samplesize + extra_samples;
+    basefreq[n] = smp.basefreq;
+    if(writeAll(fd, smp.smp, len * sizeof(float),
+                dataOffset(key.size()) + n * len * sizeof(float)))
+        added++;
+    else
+        failed = true;
+}
+
+void PadSampleCache::Writer::commit(void)
+{
+    if(fd < 0)
+        return;
+
+    PadCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, pad_cache_magic, sizeof(h.magic));
+    h.version    = PAD_CACHE_VERSION;
+    h.nsamples   = nsamples;
+    h.samplesize = samplesize;
+    h.keysize    = key.size();
+    memcpy(h.basefreq, basefreq, sizeof(basefreq));
+
+    //Only complete entries are published, an aborted run leaves nothing
+    bool ok = !failed && added == nsamples
+              && writeAll(fd, &h, sizeof(h), 0)
+              && writeAll(fd, key.data(), key.size(), sizeof(h));
+    ok &= close(fd) == 0;
+    fd = -1;
+    if(ok && !rename(tmppath.c_str(), path.c_str())) {
+        stat_stores++;
+        evict();
+    } else
+        unlink(tmppath.c_str());
+}
+
+void PadSampleCache::evict(void)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if(!cache_max)
+        return;
+    DIR *dir = opendir(cache_dir.c_str());
+    if(!dir)
+        return;
+
+    struct Entry {
+        time_t      used;
+        uint64_t    size;
+        std::string path;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    const time_t now = time(NULL);
+    auto ends = [](const char *name, const char *suffix) {
+        const size_t len = strlen(name), n = strlen(suffix);
+        return len > n && !strcmp(name + len - n, suffix);
+    };
+    while(struct dirent *ent = readdir(dir)) {
+        const bool tmp = ends(ent->d_name, PAD_CACHE_TMP);
+        if(!tmp && !ends(ent->d_name, PAD_CACHE_SUFFIX))
+            continue;
+        std::string path = cache_dir + "/" + ent->d_name;
+        struct stat st;
+        if(stat(path.c_str(), &st))
+            continue;
+        //files of crashed or aborted writers would stay forever, the ones
+        //still being written only count towards the size
+        if(tmp) {
+            if(now - st.st_mtime > PAD_CACHE_STALE && !unlink(path.c_str()))
+                continue;
+            total += st.st_size;
+            continue;
+        }
+        entries.push_back(Entry{st.st_mtime, (uint64_t)st.st_size, path});
+        total += st.st_size;
+    }
+    closedir(dir);
+
+    if(total <= cache_max)
+        return;
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) {return a.used < b.used;});
+    for(const Entry &e:entries) {
+        if(total <= cache_max)
+            break;
+        if(!unlink(e.path.c_str())) {
+            total -= e.size;
+            stat_evictions++;
+        }
+    }
+}
+
+#endif
+
+}
@@ -0,0 +1,78 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  PadSampleCache.h - On Disk Cache Of Generated PADsynth Samples
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "../globals.h"
+#include "../Params/PADnoteParameters.h"
+
+namespace zyn {
+
+/**
+ * Content addressed cache of the sample tables of PADnoteParameters.
+ *
+ * The key of an entry is everything the samples are computed from (see
+ * PADnoteParameters::sampleFingerprint()). Each entry is one file named
+ * after the hash of the key. It holds the full key, to rule out hash
+ * collisions, and the raw float tables, which are mapped into memory when
+ * the entry is loaded.
+ * The least recently used files are removed once the cache is larger than
+ * its limit. The cache stays disabled until configure() is called with a
+ * non zero size.
+ */
+class PadSampleCache
+{
+    public:
+        struct Stats {
+            uint64_t hits, misses, stores, evictions;
+        };
+
+        //! Set the cache directory and size limit (0 disables the cache)
+        static void configure(const std::string &dir, uint64_t maxbytes) NONREALTIME;
+        //! $XDG_CACHE_HOME/zynaddsubfx/padsynth or ~/.cache/zynaddsubfx/padsynth
+        static std::string defaultDir(void) NONREALTIME;
+        static bool enabled(void);
+        static Stats stats(void);
+
+        /**Pass the cached samples of a key to cb
+         * @return number of samples or 0 if the key is not cached*/
+        static int load(const std::string &key, int nsamples, int samplesize,
+                        PADnoteParameters::callback cb) NONREALTIME;
+
+        /**Stores the samples of one sampleGenerator() run.
+         * add() may be called by several threads at once, the entry is
+         * only published by commit() once every sample was added.*/
+        class Writer
+        {
+            public:
+                Writer(const std::string &key, int nsamples, int samplesize) NONREALTIME;
+                ~Writer() NONREALTIME;
+                Writer(const Writer&) = delete;
+
+                void add(int n, const PADnoteParameters::Sample &smp) NONREALTIME;
+                void commit(void) NONREALTIME;
+
+            private:
+                std::string key, path, tmppath;
+                int fd;
+                int nsamples, samplesize;
+                float basefreq[PAD_MAX_SAMPLES];
+                std::atomic<int> added;
+                std::atomic<bool> failed;
+        };
+
+    private:
+        static void evict(void) NONREALTIME;
+};
+
+}
@@ -16,6 +16,7 @@
 #include "Util.h"
 #include "XMLwrapper.h"
 #include "Allocator.h"
+#include "RenderPool.h"
 #include "../Effects/EffectMgr.h"
 #include "../Params/ADnoteParameters.h"
 #include "../Params/SUBnoteParameters.h"
@@ -23,11 +24,13 @@
 #include "../Synth/Portamento.h"
 #include "../Synth/Resonance.h"
 #include "../Synth/SynthNote.h"
+#include "../Synth/WatchPoint.h"
 #include "../Synth/ADnote.h"
 #include "../Synth/SUBnote.h"
 #include "../Synth/PADnote.h"
 #include "../Containers/ScratchString.h"
 #include "../DSP/FFTwrapper.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
@@ -79,11 +82,16 @@ static const Ports partPorts = {
 #undef rChangeCb
 #define rChangeCb obj->setkeylimit(obj->Pkeylimit);
     rParamI(Pkeylimit, rShort("limit"), rProp(parameter),
-            rMap(min,0), rMap(max, POLYPHONY), rDefault(15), "Key limit per part"),
+            rMap(min,0), rMap(max, MAX_POLYPHONY), rDefault(15), "Key limit per part"),
 #undef rChangeCb
 #define rChangeCb obj->setvoicelimit(obj->Pvoicelimit);
     rParamI(Pvoicelimit, rShort("vlimit"), rProp(parameter),
-            rMap(min,0), rMap(max, POLYPHONY), rDefault(0), "Voice limit per part"),
+            rMap(min,0), rMap(max, MAX_POLYPHONY), rDefault(0), "Voice limit per part"),
+#undef rChangeCb
+#define rChangeCb obj->setpolyphony(obj->Ppolyphony);
+    rParamI(Ppolyphony, rShort("poly"), rProp(parameter),
+            rMap(min,1), rMap(max, MAX_POLYPHONY), rDefault(POLYPHONY),
+            "Notes the part can hold at once, changing it kills all notes"),
 #undef rChangeCb
 #define rChangeCb
     rParamZyn(Pminkey, rShort("min"), rDefault(0), "Min Used Key"),
@@ -296,6 +304,7 @@ Part::Part(Allocator &alloc, const SYNTH_T &synth_, const AbsTime &time_, Sync*
     partoutl(new float[synth_.buffersize]),
     partoutr(new float[synth_.buffersize]),
     ctl(synth_, &time_),
+    notePool(alloc),
     microtonal(microtonal_),
     fft(fft_),
     wm(wm_),
@@ -339,6 +348,15 @@ Part::Part(Allocator &alloc, const SYNTH_T &synth_, const AbsTime &time_, Sync*
 
     killallnotes = false;
     silent = false;
+    silenceThreshold = 0.0f;
+    silenceHold      = 0;
+    idle             = false;
+    silentBuffers    = 0;
+    prng_stream = prng();
+    noteList   = NULL;
+    noteBuf    = NULL;
+    noteCount  = 0;
+    noteGroups = 0;
     oldfreq_log2 = -1.0f;
     oldportamento = NULL;
     legatoportamento = NULL;
@@ -421,6 +439,7 @@ void Part::defaultsinstrument()
 
     Pkitmode  = 0;
     Pdrummode = 0;
+    setpolyphony(POLYPHONY);
 
     for(int n = 0; n < NUM_KIT_ITEMS; ++n) {
         //kit[n].Penabled    = false;
@@ -534,6 +553,8 @@ bool Part::NoteOnInternal(note_t note,
                   unsigned char velocity,
                   float note_log2_freq)
 {
+    PrngScope rnd(prng_stream);
+
     //Verify Basic Mode and sanity
     const bool isRunningNote   = notePool.existsRunningNote();
     const bool doingLegato     = isRunningNote && isLegatoMode() &&
@@ -708,7 +729,7 @@ void Part::NoteOff(note_t note) //release the key
     if(!monomemEmpty())
         monomemPop(note);
 
-    for(auto &desc:notePool.activeDesc()) {
+    for(auto &desc:notePool.keyDesc(note)) {
         if(desc.note != note || !desc.playing())
             continue;
         // if latch is on we ignore noteoff, but set the state to latched
@@ -775,8 +796,8 @@ void Part::PolyphonicAftertouch(note_t note,
         monomem[note].velocity = velocity;       // Store this note's velocity.
 
     const float vel = getVelocity(velocity, Pvelsns, Pveloffs);
-    for(auto &d:notePool.activeDesc()) {
-        if(d.note == note && d.playing())
+    for(auto &d:notePool.keyDesc(note)) {
+        if(d.playing())
             for(auto &s:notePool.activeNotes(d))
                 s.note->setVelocity(vel);
     }
@@ -979,12 +1000,12 @@ void Part::verifyKeyMode(void)
 /*
  * Set Part's key limit
  */
-void Part::setkeylimit(unsigned char Pkeylimit_)
+void Part::setkeylimit(unsigned short Pkeylimit_)
 {
-    Pkeylimit = Pkeylimit_;
+    Pkeylimit = limit<int>(Pkeylimit_, 0, MAX_POLYPHONY);
     int keylimit = Pkeylimit;
     if(keylimit == 0)
-        keylimit = POLYPHONY - 5;
+        keylimit = std::max(1, notePool.polyphony() - 5);
 
     if(notePool.getRunningNotes() >= keylimit)
         notePool.enforceKeyLimit(keylimit);
@@ -1014,13 +1035,31 @@ void Part::limit_voices(int new_note)
 /*
  * Set Part's voice limit
  */
-void Part::setvoicelimit(unsigned char Pvoicelimit_)
+void Part::setvoicelimit(unsigned short Pvoicelimit_)
 {
-    Pvoicelimit = Pvoicelimit_;
+    Pvoicelimit = limit<int>(Pvoicelimit_, 0, MAX_POLYPHONY);
 
     limit_voices(-1);
 }
 
+/*
+ * Set Part's polyphony
+ *
+ * The note storage comes from the realtime allocator, so this may be called
+ * from the audio thread; the old size is kept if the memory is exhausted
+ */
+void Part::setpolyphony(unsigned short Ppolyphony_)
+{
+    Ppolyphony = limit<int>(Ppolyphony_, 1, MAX_POLYPHONY);
+    if(Ppolyphony == notePool.polyphony())
+        return;
+
+    notePool.killAllNotes();
+    notePool.cleanup();
+    if(!notePool.resize(Ppolyphony))
+        Ppolyphony = notePool.polyphony();
+}
+
 /*
  * Prepare all notes to be turned off
  */
@@ -1029,10 +1068,137 @@ void Part::AllNotesOff()
     killallnotes = true;
 }
 
+void Part::renderNote(SynthNote &note, float *outl, float *outr)
+{
+    //A note which finished with a start delay is kept for one more buffer,
+    //which plays the end of its output
+    if(note.finished()) {
+        note.flushDelay(outl, outr);
+        return;
+    }
+    PrngScope rnd(note.render_prng_state);
+    note.noteout(outl, outr);
+    note.delayOutput(outl, outr);
+}
+
+static float peak(const float *outl, const float *outr, int n)
+{
+    float p = 0.0f;
+    for(int i = 0; i < n; ++i)
+        p = std::max(p, std::max(fabsf(outl[i]), fabsf(outr[i])));
+    return p;
+}
+
+//Released notes are finished once this long below the silence threshold
+#define NOTE_SILENCE_TIME 0.05f
+
+/*
+ * The rest of the release of such a note is inaudible, so it is finished
+ * early instead of running its envelopes down
+ */
+bool Part::noteFadedOut(const NotePool::NoteDescriptor &d, SynthNote &note,
+                        const float *outl, const float *outr)
+{
+    if(!d.released() || peak(outl, outr, synth.buffersize) >= silenceThreshold) {
+        note.silentBuffers = 0;
+        return false;
+    }
+    const int hold = NOTE_SILENCE_TIME * synth.samplerate_f / synth.buffersize_f;
+    return ++note.silentBuffers > hold;
+}
+
+void Part::trackSilence(void)
+{
+    if(notePool.usedNoteDesc() != 0
+            || peak(partoutl, partoutr, synth.buffersize) >= silenceThreshold) {
+        silentBuffers = 0;
+        idle = false;
+        return;
+    }
+    if(idle || ++silentBuffers < silenceHold)
+        return;
+    //whatever is left is below the threshold
+    memset(partoutl, 0, synth.bufferbytes);
+    memset(partoutr, 0, synth.bufferbytes);
+    idle = true;
+}
+
+void Part::computeNoteGroup(void *part_, int group)
+{
+    Part &part = *(Part*)part_;
+    const int bs    = part.synth.buffersize;
+    const int first = part.noteCount * group / part.noteGroups;
+    const int last  = part.noteCount * (group + 1) / part.noteGroups;
+    for(int n = first; n < last; ++n)
+        part.renderNote(*part.noteList[n], part.noteBuf + 2 * n * bs,
+                        part.noteBuf + (2 * n + 1) * bs);
+}
+
+/*
+ * Render the notes of this part on the threads of the pool.
+ * Every note gets its own output slot and the slots are summed up afterwards
+ * in the same order as the serial loop does, so the result is bit identical.
+ * Returns false (with nothing rendered) when it is not worth it or there is
+ * no memory for the slots.
+ */
+bool Part::ComputeNotesParallel(RenderPool &pool)
+{
+    noteCount = 0;
+    for(auto &d:notePool.activeDesc())
+        noteCount += d.size;
+    if(noteCount < 2)
+        return false;
+
+    try {
+        noteList = memory.valloc<SynthNote*>(noteCount);
+    } catch(std::bad_alloc &) {
+        return false;
+    }
+    try {
+        noteBuf = memory.valloc<float>(2 * noteCount * synth.buffersize);
+    } catch(std::bad_alloc &) {
+        memory.devalloc(noteList);
+        return false;
+    }
+
+    int n = 0;
+    for(auto &d:notePool.activeDesc())
+        for(auto &s:notePool.activeNotes(d))
+            noteList[n++] = s.note;
+
+    //a few groups per thread even out notes of different cost
+    noteGroups = std::min(noteCount, pool.threads() * 4);
+    pool.run(computeNoteGroup, this, noteGroups);
+
+    n = 0;
+    for(auto &d:notePool.activeDesc()) {
+        d.age++;
+        for(auto &s:notePool.activeNotes(d)) {
+            const float *tmpoutl = noteBuf + 2 * n * synth.buffersize;
+            const float *tmpoutr = tmpoutl + synth.buffersize;
+            ++n;
+            for(int i = 0; i < synth.buffersize; ++i) { //add the note to part(mix)
+                partfxinputl[d.sendto][i] += tmpoutl[i];
+                partfxinputr[d.sendto][i] += tmpoutr[i];
+            }
+
+            if(s.note->outputFinished() || noteFadedOut(d, *s.note, tmpoutl, tmpoutr))
+                notePool.kill(s);
+        }
+        if (d.portamentoRealtime)
+            d.portamentoRealtime->portamento.update();
+    }
+
+    memory.devalloc(noteBuf);
+    memory.devalloc(noteList);
+    noteCount = 0;
+    return true;
+}
+
 /*
  * Compute Part samples and store them in the partoutl[] and partoutr[]
  */
-void Part::ComputePartSmps()
+void Part::ComputePartSmps(RenderPool *pool)
 {
     /* When we are in the process of being disabled (Penabled set to false),
      * AllNotesOff will be called, setting killallnotes, which causes all
@@ -1052,30 +1218,46 @@ void Part::ComputePartSmps()
     }
     silent = false;
 
+    //An idle part wakes up with its next note, its output is already zero
+    if(idle) {
+        if(notePool.usedNoteDesc() == 0 && !killallnotes)
+            return;
+        idle = false;
+        silentBuffers = 0;
+    }
+
+    PrngScope rnd(prng_stream);
+
     assert(partefx[0]);
     for(unsigned nefx = 0; nefx < NUM_PART_EFX + 1; ++nefx) {
         memset(partfxinputl[nefx], 0, synth.bufferbytes);
         memset(partfxinputr[nefx], 0, synth.bufferbytes);
     }
 
-    for(auto &d:notePool.activeDesc()) {
-        d.age++;
-        for(auto &s:notePool.activeNotes(d)) {
-            STACKALLOC(float, tmpoutr, synth.buffersize);
-            STACKALLOC(float, tmpoutl, synth.buffersize);
-            auto &note = *s.note;
-            note.noteout(&tmpoutl[0], &tmpoutr[0]);
+    //Watch points are not thread safe, so they keep the notes serial
+    const bool parallel = pool && pool->threads() > 1 && (!wm || wm->empty())
+                          && ComputeNotesParallel(*pool);
 
-            for(int i = 0; i < synth.buffersize; ++i) { //add the note to part(mix)
-                partfxinputl[d.sendto][i] += tmpoutl[i];
-                partfxinputr[d.sendto][i] += tmpoutr[i];
-            }
+    if(!parallel) {
+        for(auto &d:notePool.activeDesc()) {
+            d.age++;
+            for(auto &s:notePool.activeNotes(d)) {
+                STACKALLOC(float, tmpoutr, synth.buffersize);
+                STACKALLOC(float, tmpoutl, synth.buffersize);
+                auto &note = *s.note;
+                renderNote(note, &tmpoutl[0], &tmpoutr[0]);
+
+                for(int i = 0; i < synth.buffersize; ++i) { //add the note to part(mix)
+                    partfxinputl[d.sendto][i] += tmpoutl[i];
+                    partfxinputr[d.sendto][i] += tmpoutr[i];
+                }
 
-            if(note.finished())
-                notePool.kill(s);
+                if(note.outputFinished() || noteFadedOut(d, note, tmpoutl, tmpoutr))
+                    notePool.kill(s);
+            }
+            if (d.portamentoRealtime)
+                d.portamentoRealtime->portamento.update();
         }
-    if (d.portamentoRealtime)
-        d.portamentoRealtime->portamento.update();
     }
 
     //Apply part's effects and mix them
@@ -1198,6 +1380,7 @@ void Part::add2XMLinstrument(XMLwrapper& xml)
     xml.beginbranch("INSTRUMENT_KIT");
     xml.addpar("kit_mode", Pkitmode);
     xml.addparbool("drum_mode", Pdrummode);
+    xml.addpar("polyphony", Ppolyphony);
 
     for(int i = 0; i < NUM_KIT_ITEMS; ++i) {
         xml.beginbranch("INSTRUMENT_KIT_ITEM", i);
@@ -1325,9 +1508,12 @@ void Part::applyparameters(void)
 
 void Part::applyparameters(std::function<bool()> do_abort)
 {
-    for(int n = 0; n < NUM_KIT_ITEMS; ++n)
+    for(int n = 0; n < NUM_KIT_ITEMS; ++n) {
+        if(kit[n].Padenabled && kit[n].adpars)
+            kit[n].adpars->applyparameters();
         if(kit[n].Ppadenabled && kit[n].padpars)
             kit[n].padpars->applyparameters(do_abort);
+    }
 }
 
 void Part::initialize_rt(void)
@@ -1398,6 +1584,7 @@ void Part::getfromXMLinstrument(XMLwrapper& xml)
     if(xml.enterbranch("INSTRUMENT_KIT")) {
         Pkitmode  = xml.getpar127("kit_mode", Pkitmode);
         Pdrummode = xml.getparbool("drum_mode", Pdrummode);
+        setpolyphony(xml.getpar("polyphony", Ppolyphony, 1, MAX_POLYPHONY));
 
         setkititemstatus(0, 0);
         for(int i = 0; i < NUM_KIT_ITEMS; ++i) {
@@ -1500,9 +1687,8 @@ void Part::getfromXML(XMLwrapper& xml)
     Plegatomode = xml.getparbool("legato_mode", Plegatomode); //older versions
     if(!Plegatomode)
         Plegatomode = xml.getpar127("legato_mode", Plegatomode);
-    int keylimit_max = std::atoi(ports["Pkeylimit"]->meta()["max"]);
-    Pkeylimit = std::min(keylimit_max, xml.getpar127("key_limit", Pkeylimit));
-    Pvoicelimit = xml.getpar127("voice_limit", Pvoicelimit);
+    Pkeylimit   = xml.getpar("key_limit", Pkeylimit, 0, MAX_POLYPHONY);
+    Pvoicelimit = xml.getpar("voice_limit", Pvoicelimit, 0, MAX_POLYPHONY);
 
 
     if(xml.enterbranch("INSTRUMENT")) {
@@ -25,6 +25,7 @@
 namespace zyn {
 
 struct PortamentoParams;
+class RenderPool;
 /** Part implementation*/
 class Part
 {
@@ -74,8 +75,9 @@ class Part
         void ReleaseSustainedKeys() REALTIME; //this is called when the sustain pedal is released
         void ReleaseAllKeys() REALTIME; //this is called on AllNotesOff controller
 
-        /* The synthesizer part output */
-        void ComputePartSmps() REALTIME; //Part output
+        /* The synthesizer part output
+         * If a pool is given, the notes are spread over its threads */
+        void ComputePartSmps(RenderPool *pool = NULL) REALTIME; //Part output
 
 
         //saves the instrument settings to a XML file
@@ -122,8 +124,9 @@ class Part
         } kit[NUM_KIT_ITEMS];
 
         //Part parameters
-        void setkeylimit(unsigned char Pkeylimit);
-        void setvoicelimit(unsigned char Pvoicelimit);
+        void setkeylimit(unsigned short Pkeylimit);
+        void setvoicelimit(unsigned short Pvoicelimit);
+        void setpolyphony(unsigned short Ppolyphony);
         void setkititemstatus(unsigned kititem, bool Penabled_);
 
         unsigned char partno; /**<the part number in Master*/
@@ -149,8 +152,9 @@ class Part
         bool Ppolymode; //Part mode - 0=monophonic , 1=polyphonic
         bool Plegatomode; // 0=normal, 1=legato
         bool Platchmode; // 0=normal, 1=latch
-        unsigned char Pkeylimit; //how many keys are allowed to be played same time (0=off), the older will be released
-        unsigned char Pvoicelimit; //how many voices are allowed to be played same time (0=off), the older will be entombed
+        unsigned short Pkeylimit; //how many keys are allowed to be played same time (0=off), the older will be released
+        unsigned short Pvoicelimit; //how many voices are allowed to be played same time (0=off), the older will be entombed
+        unsigned short Ppolyphony; //how many notes the part can hold, saved with the instrument
 
         char *Pname; //name of the instrument
         struct { //instrument additional information
@@ -163,6 +167,16 @@ class Part
         float *partoutl; //Left channel output of the part
         float *partoutr; //Right channel output of the part
 
+        //Silence tracking, set up by the Master every buffer
+        float silenceThreshold; //peak below which the output is silent (0=off)
+        int   silenceHold;      //silent buffers before the part goes idle
+        //No notes and a silent output (after the insertion effects) for
+        //silenceHold buffers, the part is neither rendered nor mixed until
+        //it gets a note again
+        bool  idle;
+        //Called by the Master once the insertion effects ran
+        void trackSilence(void) REALTIME;
+
         float *partfxinputl[NUM_PART_EFX + 1], //Left and right signal that pass thru part effects;
         *partfxinputr[NUM_PART_EFX + 1];          //partfxinput l/r [NUM_PART_EFX] is for "no effect" buffer
 
@@ -196,8 +210,26 @@ class Part
         bool killallnotes;
         bool silent; // An output buffer with zeros has been generated
 
+        // Random stream used by this part's notes and effects (see PrngScope)
+        // so that the output does not depend on the rendering thread
+        uint32_t prng_stream;
+
         NotePool notePool;
 
+        //Render one note with its own random stream
+        void renderNote(SynthNote &note, float *outl, float *outr) REALTIME;
+        //If a released note stayed below the silence threshold long enough
+        bool noteFadedOut(const NotePool::NoteDescriptor &d, SynthNote &note,
+                          const float *outl, const float *outr) REALTIME;
+        int silentBuffers; //of the part output, see trackSilence()
+        //Render the active notes concurrently, mix them in NotePool order
+        bool ComputeNotesParallel(RenderPool &pool) REALTIME;
+        static void computeNoteGroup(void *part, int group);
+        SynthNote **noteList; //notes of the current buffer in NotePool order
+        float      *noteBuf;  //2 * buffersize samples of output per note
+        int         noteCount;
+        int         noteGroups;
+
         void limit_voices(int new_note);
 
         bool lastlegatomodevalid; // To keep track of previous legatomodevalid.
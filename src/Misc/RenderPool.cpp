@@ -0,0 +1,131 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  RenderPool.cpp - Realtime Worker Threads For Parallel Rendering
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "RenderPool.h"
+#include "Denormals.h"
+#include "Util.h"
+#include <cassert>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace zyn {
+
+//Number of polls before a waiting thread gives up its time slice
+#define RENDER_POOL_SPIN 4096
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+RenderPool::RenderPool(int nthreads)
+    :claim(0), generation(0), pending(0), quit(false),
+     job_fn(nullptr), job_ctx(nullptr)
+{
+    for(int i = 1; i < nthreads; ++i)
+        workers.emplace_back(&RenderPool::worker, this, i);
+}
+
+RenderPool::~RenderPool()
+{
+    quit.store(true);
+    generation.fetch_add(1, std::memory_order_release);
+    generation.notify_all();
+    for(auto &t:workers)
+        t.join();
+}
+
+void RenderPool::run(job_t fn, void *ctx, int njobs)
+{
+    if(workers.empty() || njobs <= 1) {
+        for(int i = 0; i < njobs; ++i)
+            fn(ctx, i);
+        return;
+    }
+    assert(njobs < 0x10000);
+
+    //Publish the new batch of jobs
+    job_fn  = fn;
+    job_ctx = ctx;
+    pending.store(njobs, std::memory_order_relaxed);
+    const uint32_t gen = generation.load(std::memory_order_relaxed) + 1;
+    claim.store(((uint64_t)gen << 32) | ((uint64_t)njobs << 16),
+                std::memory_order_release);
+    generation.store(gen, std::memory_order_release);
+    generation.notify_all();
+
+    //Take part in the work, then wait for jobs still running elsewhere
+    work(gen);
+    for(int spin = 0; pending.load(std::memory_order_acquire); ++spin) {
+        if(spin < RENDER_POOL_SPIN)
+            cpu_relax();
+        else
+            std::this_thread::yield();
+    }
+}
+
+void RenderPool::work(uint32_t gen)
+{
+    while(true) {
+        uint64_t c = claim.load(std::memory_order_acquire);
+        const unsigned count = (c >> 16) & 0xffff;
+        const unsigned next  = c & 0xffff;
+        //The batch was finished (or replaced) while we were not looking
+        if((uint32_t)(c >> 32) != gen || next >= count)
+            return;
+        if(!claim.compare_exchange_weak(c, c + 1, std::memory_order_acq_rel))
+            continue;
+        job_fn(job_ctx, next);
+        pending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void RenderPool::worker(int id)
+{
+    set_realtime();
+    flushDenormals();
+#ifdef __linux__
+    //Keep the first core free for the thread which drives the pool
+    const unsigned ncpu = std::thread::hardware_concurrency();
+    if(ncpu > 1) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(id % ncpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void)id;
+#endif
+
+    uint32_t seen = 0;
+    while(true) {
+        uint32_t gen;
+        int spin = 0;
+        while((gen = generation.load(std::memory_order_acquire)) == seen) {
+            if(++spin < RENDER_POOL_SPIN)
+                cpu_relax();
+            else
+                generation.wait(seen, std::memory_order_acquire);
+        }
+        if(quit.load())
+            return;
+        seen = gen;
+        work(gen);
+    }
+}
+
+}
@@ -0,0 +1,67 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  RenderPool.h - Realtime Worker Threads For Parallel Rendering
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "../globals.h"
+
+namespace zyn {
+
+/**
+ * Fixed set of worker threads which render independent jobs (e.g. parts)
+ * of one audio buffer concurrently.
+ *
+ * - The calling (audio) thread always takes part in the work, so a pool of
+ *   N threads spawns N-1 workers
+ * - Workers are spawned once, get realtime priority and are pinned to a core
+ * - Jobs are claimed through a single atomic word, run() never locks
+ * - Idle workers spin for a short while and then sleep on a futex
+ *   (std::atomic::wait) until the next buffer is dispatched
+ */
+class RenderPool
+{
+    public:
+        typedef void (*job_t)(void *ctx, int job);
+
+        //! @param nthreads total number of rendering threads incl. the caller
+        RenderPool(int nthreads) NONREALTIME;
+        ~RenderPool() NONREALTIME;
+        RenderPool(const RenderPool&) = delete;
+
+        //! Run fn(ctx, i) for i in [0, njobs) and return when all are done
+        //! Jobs may run in any order and on any thread of the pool
+        void run(job_t fn, void *ctx, int njobs) REALTIME;
+
+        //! Number of threads taking part in run(), including the caller
+        int threads(void) const { return (int)workers.size() + 1; }
+
+    private:
+        void worker(int id);
+        void work(uint32_t gen);
+
+        std::vector<std::thread> workers;
+
+        //[generation:32][job count:16][next job:16]
+        std::atomic<uint64_t> claim;
+        //generation used to wake up sleeping workers
+        std::atomic<uint32_t> generation;
+        //jobs of the current generation which are not done yet
+        std::atomic<int>      pending;
+        std::atomic<bool>     quit;
+
+        job_t job_fn;
+        void *job_ctx;
+};
+
+}
@@ -27,6 +27,7 @@ class AbsTime
             tick(0.0f),
             bpm(120.0f),
             ppq(1920.0f),
+            eventOffset(0),
             frames(0),
             samplingInterval(dt_),
             buffersize(buffersize_) {};
@@ -43,6 +44,8 @@ class AbsTime
         float bpm;
         float ppq;
         bool playing;
+        //Sample of the next frame at which the incoming note events happen
+        int eventOffset;
         float dt() const { return samplingInterval; }
         float framesPerSec() const { return 1.0f/samplingInterval;}
         int   samplesPerFrame() const {return buffersize;}
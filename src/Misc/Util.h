@@ -126,7 +126,8 @@ T array_max(const T *data, size_t len)
 //Random number generator
 
 typedef uint32_t prng_t;
-extern prng_t prng_state;
+//Each thread has its own generator state, see PrngScope
+extern thread_local prng_t prng_state;
 
 // Portable Pseudo-Random Number Generator
 inline prng_t prng_r(prng_t &p)
@@ -144,6 +145,32 @@ inline void sprng(prng_t p)
     prng_state = p;
 }
 
+/**
+ * Redirect prng()/RND of the calling thread to another random stream for
+ * the lifetime of this object.
+ * This keeps the random sequence seen by an object (e.g. a Part) independent
+ * of which thread renders it and of what other objects did before.
+ * Scopes must not be nested for the same stream.
+ */
+class PrngScope
+{
+    public:
+        PrngScope(prng_t &stream_)
+            :stream(stream_), saved(prng_state)
+        {
+            prng_state = stream;
+        }
+        ~PrngScope()
+        {
+            stream     = prng_state;
+            prng_state = saved;
+        }
+        PrngScope(const PrngScope&) = delete;
+    private:
+        prng_t &stream;
+        prng_t  saved;
+};
+
 /*
  * The random generator (0.0f..1.0f)
  */
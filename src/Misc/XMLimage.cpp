@@ -0,0 +1,376 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  XMLimage.cpp - Binary Images Of XML Parameter Trees
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "XMLimage.h"
+#include "XMLwrapper.h"
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zyn {
+
+#define XML_IMAGE_VERSION   1
+#define XML_IMAGE_BYTEORDER 0x01020304
+
+#if MXML_MAJOR_VERSION <= 3
+// Mimic typenames present in mxml4 for compatibility
+constexpr int MXML_TYPE_ELEMENT = MXML_ELEMENT;
+constexpr int MXML_TYPE_OPAQUE  = MXML_OPAQUE;
+constexpr int MXML_TYPE_TEXT    = MXML_TEXT;
+#endif
+
+struct XMLimageHeader {
+    char     magic[8];
+    uint32_t byteorder;
+    uint32_t version;
+    uint32_t nnodes, nattrs, strbytes;
+    uint32_t reserved;
+};
+
+static const char xml_image_magic[8] = {'Z', 'Y', 'N', 'X', 'B', 'I', 'N', 0};
+
+//Key of a child among its siblings, as the lookups of XMLwrapper use them
+static std::string childkey(const char *element, char attr, const char *value)
+{
+    std::string key(element);
+    if(attr) {
+        key += '\0';
+        key += attr;
+        key += value;
+    }
+    return key;
+}
+
+/* Builder of the arrays of an image */
+struct XMLimageBuilder {
+    std::vector<XMLimage::Node> nodes;
+    std::vector<XMLimage::Attr> attrs;
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> pool;
+
+    uint32_t str(const char *s) {
+        auto it = pool.find(s);
+        if(it != pool.end())
+            return it->second;
+        const uint32_t offset = strings.size();
+        strings.append(s, strlen(s) + 1);
+        pool.emplace(s, offset);
+        return offset;
+    }
+
+    void attr(uint32_t n, const char *name, const char *value) {
+        if(name == NULL)
+            return;
+        attrs.push_back({str(name), str(value ? value : "")});
+        nodes[n].nattrs++;
+    }
+
+    void add(mxml_node_t *elm, uint32_t parent, uint32_t dup) {
+        const uint32_t n = nodes.size();
+        nodes.push_back({str(mxmlGetElement(elm)), XMLimage::NONE,
+                         (uint32_t)attrs.size(), 0, parent, 0, dup});
+
+#if MXML_MAJOR_VERSION >= 3
+        const int count = mxmlElementGetAttrCount(elm);
+        for(int i = 0; i < count; ++i) {
+            const char *name  = NULL;
+            const char *value = mxmlElementGetAttrByIndex(elm, i, &name);
+            attr(n, name, value);
+        }
+#else
+        for(int i = 0; i < elm->value.element.num_attrs; ++i)
+            attr(n, elm->value.element.attrs[i].name,
+                 elm->value.element.attrs[i].value);
+#endif
+
+        //only the text of leaves, which is what XMLwrapper reads
+        mxml_node_t *first = mxmlGetFirstChild(elm);
+        bool leaf = true;
+        for(mxml_node_t *c = first; c; c = mxmlGetNextSibling(c))
+            leaf &= mxmlGetType(c) != MXML_TYPE_ELEMENT;
+        if(leaf && first && mxmlGetType(first) == MXML_TYPE_OPAQUE
+           && mxmlGetOpaque(first))
+            nodes[n].text = str(mxmlGetOpaque(first));
+        else if(leaf && first && mxmlGetType(first) == MXML_TYPE_TEXT
+                && mxmlGetText(first, NULL))
+            nodes[n].text = str(mxmlGetText(first, NULL));
+
+        std::unordered_set<std::string> seen;
+        for(mxml_node_t *c = first; c; c = mxmlGetNextSibling(c)) {
+            if(mxmlGetType(c) != MXML_TYPE_ELEMENT || !mxmlGetElement(c))
+                continue;
+            const char *element = mxmlGetElement(c);
+            const char *name    = mxmlElementGetAttr(c, "name");
+            const char *id      = mxmlElementGetAttr(c, "id");
+            uint32_t flags = 0;
+            if(!seen.insert(childkey(element, 0, NULL)).second)
+                flags |= XMLimage::DUP_ELEMENT;
+            if(name && !seen.insert(childkey(element, 'n', name)).second)
+                flags |= XMLimage::DUP_NAME;
+            if(id && !seen.insert(childkey(element, 'i', id)).second)
+                flags |= XMLimage::DUP_ID;
+            add(c, n, flags);
+        }
+        nodes[n].end = nodes.size();
+    }
+};
+
+std::string XMLimage::build(mxml_node_t *root)
+{
+    XMLimageBuilder b;
+    b.add(root, NONE, 0);
+
+    XMLimageHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, xml_image_magic, sizeof(h.magic));
+    h.byteorder = XML_IMAGE_BYTEORDER;
+    h.version   = XML_IMAGE_VERSION;
+    h.nnodes    = b.nodes.size();
+    h.nattrs    = b.attrs.size();
+    h.strbytes  = b.strings.size();
+
+    std::string image((const char*)&h, sizeof(h));
+    image.append((const char*)b.nodes.data(), b.nodes.size() * sizeof(Node));
+    image.append((const char*)b.attrs.data(), b.attrs.size() * sizeof(Attr));
+    image.append(b.strings);
+    return image;
+}
+
+XMLimage::XMLimage()
+    :data(NULL), size(0), mapped(false), nodes(NULL), attrs(NULL),
+     strings(NULL), nnodes(0)
+{}
+
+XMLimage::~XMLimage()
+{
+    close();
+}
+
+void XMLimage::close(void)
+{
+#ifndef WIN32
+    if(mapped)
+        munmap((void*)data, size);
+#endif
+    copy.clear();
+    data   = NULL;
+    size   = 0;
+    mapped = false;
+}
+
+bool XMLimage::load(const char *bytes, size_t size_)
+{
+    close();
+    //words, so the arrays are aligned
+    copy.resize((size_ + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    memcpy(copy.data(), bytes, size_);
+    data = (const char*)copy.data();
+    size = size_;
+    if(validate())
+        return true;
+    close();
+    return false;
+}
+
+bool XMLimage::open(const std::string &filename)
+{
+    close();
+#ifdef WIN32
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(file == NULL)
+        return false;
+    char magic[sizeof(xml_image_magic)];
+    std::vector<char> bytes;
+    if(fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+       && !memcmp(magic, xml_image_magic, sizeof(magic))
+       && !fseek(file, 0, SEEK_END)) {
+        bytes.resize(ftell(file));
+        rewind(file);
+        if(fread(bytes.data(), 1, bytes.size(), file) != bytes.size())
+            bytes.clear();
+    }
+    fclose(file);
+    return !bytes.empty() && load(bytes.data(), bytes.size());
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+    //most files are XML, which is found out without mapping them
+    char magic[sizeof(xml_image_magic)];
+    struct stat st;
+    void *map = MAP_FAILED;
+    if(read(fd, magic, sizeof(magic)) == sizeof(magic)
+       && !memcmp(magic, xml_image_magic, sizeof(magic))
+       && !fstat(fd, &st) && st.st_size > 0)
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(map == MAP_FAILED)
+        return false;
+
+    data   = (const char*)map;
+    size   = st.st_size;
+    mapped = true;
+    if(validate())
+        return true;
+    close();
+    return false;
+#endif
+}
+
+/* Checks every offset and the nesting of the nodes once, so the accessors
+ * can trust them */
+bool XMLimage::validate(void)
+{
+    if(size < sizeof(XMLimageHeader))
+        return false;
+    const XMLimageHeader &h = *(const XMLimageHeader*)data;
+    if(memcmp(h.magic, xml_image_magic, sizeof(h.magic))
+       || h.byteorder != XML_IMAGE_BYTEORDER
+       || h.version != XML_IMAGE_VERSION
+       || h.nnodes == 0 || h.strbytes == 0
+       || (uint64_t)sizeof(h) + (uint64_t)h.nnodes * sizeof(Node)
+          + (uint64_t)h.nattrs * sizeof(Attr) + h.strbytes != size)
+        return false;
+
+    nodes   = (const Node*)(data + sizeof(h));
+    attrs   = (const Attr*)(nodes + h.nnodes);
+    strings = (const char*)(attrs + h.nattrs);
+    nnodes  = h.nnodes;
+    if(strings[h.strbytes - 1] != 0)
+        return false;
+
+    for(uint32_t i = 0; i < h.nattrs; ++i)
+        if(attrs[i].name >= h.strbytes || attrs[i].value >= h.strbytes)
+            return false;
+    //the nodes are in document order, so the parent of each node is the
+    //innermost node still open and the siblings follow each other
+    std::vector<uint32_t> open;
+    for(uint32_t n = 0; n < nnodes; ++n) {
+        const Node &node = nodes[n];
+        while(!open.empty() && nodes[open.back()].end <= n)
+            open.pop_back();
+        if(n ? open.empty() || node.parent != open.back()
+             : node.parent != NONE)
+            return false;
+        const uint32_t limit = n ? nodes[node.parent].end : nnodes;
+        if(node.element >= h.strbytes
+           || (node.text != NONE && node.text >= h.strbytes)
+           || (uint64_t)node.attrs + node.nattrs > h.nattrs
+           || node.end <= n || node.end > limit
+           || (n == 0 && node.end != nnodes))
+            return false;
+        open.push_back(n);
+    }
+    return true;
+}
+
+const char *XMLimage::element(uint32_t n) const
+{
+    return strings + nodes[n].element;
+}
+
+const char *XMLimage::text(uint32_t n) const
+{
+    return nodes[n].text == NONE ? NULL : strings + nodes[n].text;
+}
+
+const char *XMLimage::attr(uint32_t n, const char *name) const
+{
+    const Attr *a = attrs + nodes[n].attrs;
+    for(uint32_t i = 0; i < nodes[n].nattrs; ++i)
+        if(!strcmp(strings + a[i].name, name))
+            return strings + a[i].value;
+    return NULL;
+}
+
+int XMLimage::attrcount(uint32_t n) const
+{
+    return nodes[n].nattrs;
+}
+
+const char *XMLimage::attr(uint32_t n, int i, const char **name) const
+{
+    const Attr &a = attrs[nodes[n].attrs + i];
+    if(name)
+        *name = strings + a.name;
+    return strings + a.value;
+}
+
+uint32_t XMLimage::parent(uint32_t n) const
+{
+    return nodes[n].parent;
+}
+
+uint32_t XMLimage::firstchild(uint32_t n) const
+{
+    return n + 1 < nodes[n].end ? n + 1 : NONE;
+}
+
+uint32_t XMLimage::next(uint32_t n) const
+{
+    if(nodes[n].parent == NONE)
+        return NONE;
+    return nodes[n].end < nodes[nodes[n].parent].end ? nodes[n].end : NONE;
+}
+
+bool XMLimage::matches(uint32_t n, const char *element_, char attr_,
+                       const char *value) const
+{
+    const uint32_t dup = attr_ == 'n' ? DUP_NAME
+                       : attr_ == 'i' ? DUP_ID : DUP_ELEMENT;
+    if((nodes[n].dup & dup) || strcmp(element(n), element_))
+        return false;
+    if(!attr_)
+        return true;
+    const char *v = attr(n, attr_ == 'n' ? "name" : "id");
+    return v && !strcmp(v, value);
+}
+
+uint32_t XMLimage::find(uint32_t parent_, uint32_t from, const char *element_,
+                        char attr_, const char *value) const
+{
+    const uint32_t first = firstchild(parent_);
+    if(first == NONE)
+        return NONE;
+    if(from == NONE || from >= nnodes || nodes[from].parent != parent_)
+        from = first;
+
+    for(uint32_t c = from; c != NONE; c = next(c))
+        if(matches(c, element_, attr_, value))
+            return c;
+    for(uint32_t c = first; c != from && c != NONE; c = next(c))
+        if(matches(c, element_, attr_, value))
+            return c;
+    return NONE;
+}
+
+void XMLimage::toxml(uint32_t n, mxml_node_t *parent_) const
+{
+    mxml_node_t *elm = mxmlNewElement(parent_, element(n));
+    for(int i = 0; i < attrcount(n); ++i) {
+        const char *name;
+        const char *value = attr(n, i, &name);
+        mxmlElementSetAttr(elm, name, value);
+    }
+    if(text(n))
+        mxmlNewOpaque(elm, text(n));
+    for(uint32_t c = firstchild(n); c != NONE; c = next(c))
+        toxml(c, elm);
+}
+
+}
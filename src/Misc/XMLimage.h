@@ -0,0 +1,111 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  XMLimage.h - Binary Images Of XML Parameter Trees
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mxml.h>
+
+namespace zyn {
+
+/**
+ * Binary image of the tree of a XMLwrapper (an instrument, a session, ...).
+ *
+ * The image holds the nodes in document order: element name, attributes,
+ * text, parent and the end of the subtree of each. Their strings follow in
+ * one pool without duplicates. Everything is referenced by offset, so a
+ * file is mapped into memory and read in place, without parsing it or
+ * building an mxml tree.
+ *
+ * Lookups scan the children of a branch from the child after the last one
+ * found, as parameters are mostly read in the order they were written.
+ * Children flagged as repeating the key of an earlier sibling are skipped,
+ * so a lookup still finds the same node as mxmlFindElement().
+ *
+ * An image converts to the XML tree it was built from and back without
+ * losses. It uses the byte order of the machine which wrote it, and images
+ * with another byte order are rejected.
+ */
+class XMLimage
+{
+    public:
+        enum {NONE = 0xffffffff};
+        //The earlier sibling with the same element / element and "name" /
+        //element and "id"
+        enum {DUP_ELEMENT = 1, DUP_NAME = 2, DUP_ID = 4};
+
+        struct Node {
+            uint32_t element, text; //NONE without text
+            uint32_t attrs, nattrs;
+            uint32_t parent, end;   //end is the node after the subtree
+            uint32_t dup;
+        };
+        struct Attr {
+            uint32_t name, value;
+        };
+
+        XMLimage();
+        ~XMLimage();
+        XMLimage(const XMLimage&) = delete;
+        XMLimage &operator=(const XMLimage&) = delete;
+
+        //! Image of the subtree of root
+        static std::string build(mxml_node_t *root);
+
+        /**Map an image file
+         * @returns false if it is no image (e.g. a XML file) or invalid*/
+        bool open(const std::string &filename);
+        //! Copy an image from memory, false if it is invalid
+        bool load(const char *bytes, size_t size);
+
+        //! The image as stored in the file
+        const char *bytes(void) const { return data; }
+        size_t length(void) const { return size; }
+
+        uint32_t root(void) const { return 0; }
+        const char *element(uint32_t n) const;
+        const char *text(uint32_t n) const;    //!< NULL without text
+        const char *attr(uint32_t n, const char *name) const;
+        int attrcount(uint32_t n) const;
+        //! Value of attribute i, like mxmlElementGetAttrByIndex()
+        const char *attr(uint32_t n, int i, const char **name) const;
+        uint32_t parent(uint32_t n) const;
+        uint32_t firstchild(uint32_t n) const; //!< NONE without children
+        uint32_t next(uint32_t n) const;       //!< next sibling or NONE
+
+        /**Child of parent with the element name and, for attr 'n' or 'i',
+         * the "name" or "id" attribute value, scanning from child from
+         * @returns the child or NONE*/
+        uint32_t find(uint32_t parent, uint32_t from, const char *element,
+                      char attr, const char *value) const;
+
+        //! Add the subtree of n to parent as mxml nodes
+        void toxml(uint32_t n, mxml_node_t *parent) const;
+
+    private:
+        void close(void);
+        bool validate(void);
+        bool matches(uint32_t n, const char *element, char attr,
+                     const char *value) const;
+
+        const char *data;
+        size_t      size;
+        bool        mapped;
+        std::vector<uint32_t> copy; //the image if it is not mapped
+
+        const Node *nodes;
+        const Attr *attrs;
+        const char *strings;
+        uint32_t    nnodes;
+};
+
+}
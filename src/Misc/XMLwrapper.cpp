@@ -14,13 +14,15 @@
 */
 
 #include "XMLwrapper.h"
+#include "XMLimage.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <stdio.h>
 #include <stdlib.h>
 #include <cstdarg>
 #include <zlib.h>
 #include <iostream>
-#include <sstream>
 
 #include "globals.h"
 #include "Util.h"
@@ -116,13 +118,11 @@ const char *mxmlElementGetAttr(const mxml_node_t *node, const char *name)
     return mxmlElementGetAttr(const_cast<mxml_node_t *>(node), name);
 }
 
-XMLwrapper::XMLwrapper()
+//?xml and !DOCTYPE nodes, without the ZynAddSubFX-data
+static mxml_node_t *newXMLtree(void)
 {
-    minimal = true;
-    SaveFullXml=false;
-
-    node = tree = mxmlNewXML("1.0");
-    assert(node);
+    mxml_node_t *tree = mxmlNewXML("1.0");
+    assert(tree);
     /*  for mxml 2.1f (and older)
         tree=mxmlNewElement(MXML_NO_PARENT,"?xml");
         mxmlElementSetAttr(tree,"version","1.0f");
@@ -138,6 +138,16 @@ XMLwrapper::XMLwrapper()
         mxmlNewDeclaration(tree, "DOCTYPE ZynAddSubFX-data");
         assert(doctype);
 #endif
+    return tree;
+}
+
+XMLwrapper::XMLwrapper()
+    :image(NULL), inode(0), icursor(XMLimage::NONE)
+{
+    minimal = true;
+    SaveFullXml=false;
+
+    node = tree = newXMLtree();
 
     node = root = addparams("ZynAddSubFX-data", 4,
                             "version-major", stringFrom<int>(
@@ -169,8 +179,11 @@ XMLwrapper::cleanup(void)
 {
     if(tree)
         mxmlDelete(tree);
+    delete image;
 
     /* make sure freed memory is not referenced */
+    index.clear();
+    image = NULL;
     tree = 0;
     node = 0;
     root = 0;
@@ -193,6 +206,17 @@ void XMLwrapper::setPadSynth(bool enabled)
 
 bool XMLwrapper::hasPadSynth() const
 {
+    if(image) {
+        const uint32_t info_ = image->find(image->root(), XMLimage::NONE,
+                                           "INFORMATION", 0, NULL);
+        const uint32_t par = info_ == XMLimage::NONE ? XMLimage::NONE
+            : image->find(info_, XMLimage::NONE, "par_bool", 'n',
+                          "PADsynth_used");
+        const char *strval = par == XMLimage::NONE ? NULL
+                             : image->attr(par, "value");
+        return strval && ((strval[0] == 'Y') || (strval[0] == 'y'));
+    }
+
     /**Right now this has a copied implementation of setparbool, so this should
      * be reworked as XMLwrapper evolves*/
     mxml_node_t *tmp = mxmlFindElement(tree,
@@ -240,20 +264,56 @@ char *XMLwrapper::getXMLdata() const
 {
     xml_k = 0;
 
+    //an image is turned into a tree just for saving it
+    mxml_node_t *xml = tree;
+    if(image) {
+        xml = newXMLtree();
+        image->toxml(image->root(), xml);
+    }
+
 #if MXML_MAJOR_VERSION <= 3
-    char *xmldata = mxmlSaveAllocString(tree, XMLwrapper_whitespace_callback);
+    char *xmldata = mxmlSaveAllocString(xml, XMLwrapper_whitespace_callback);
 #else
     mxml_options_t *options = mxmlOptionsNew();
     mxmlOptionsSetWhitespaceCallback(options, XMLwrapper_whitespace_callback, /*cbdata*/nullptr);
-    char *xmldata = mxmlSaveAllocString(tree, options);
+    char *xmldata = mxmlSaveAllocString(xml, options);
     mxmlOptionsDelete(options);
 #endif
 
+    if(xml != tree)
+        mxmlDelete(xml);
 
     return xmldata;
 }
 
 
+int XMLwrapper::saveBinaryfile(const string &filename) const
+{
+    const string built = image ? string() : XMLimage::build(root);
+    const char  *data  = image ? image->bytes() : built.data();
+    const size_t size  = image ? image->length() : built.size();
+
+    //Images are mapped by loadXMLfile(), so the file is never changed in
+    //place: readers keep the old file until the new one replaces it
+    static std::atomic<int> counter(0);
+    const string tmp = filename + "." + os_pid_as_padded_string() + "-"
+                       + to_s(counter++) + ".tmp";
+    FILE *file = fopen(tmp.c_str(), "wb");
+    if(file == NULL)
+        return -1;
+    const bool written = fwrite(data, 1, size, file) == size;
+    bool ok = fclose(file) == 0 && written;
+#ifdef WIN32
+    //rename() does not replace files there
+    if(ok)
+        remove(filename.c_str());
+#endif
+    ok = ok && !rename(tmp.c_str(), filename.c_str());
+    if(!ok)
+        remove(tmp.c_str());
+    return ok ? 0 : -1;
+}
+
 int XMLwrapper::dosavefile(const char *filename,
                            int compression,
                            const char *xmldata) const
@@ -313,6 +373,7 @@ void XMLwrapper::addparbool(const string &name, int val)
 
 void XMLwrapper::addparstr(const string &name, const string &val)
 {
+    index.erase(node);
     mxml_node_t *element = mxmlNewElement(node, "string");
     mxmlElementSetAttr(element, "name", name.c_str());
     mxmlNewText(element, 0, val.c_str());
@@ -357,6 +418,20 @@ int XMLwrapper::loadXMLfile(const string &filename)
 {
     cleanup();
 
+    XMLimage *img = new XMLimage;
+    if(img->open(filename)) {
+        image   = img;
+        inode   = image->root();
+        icursor = XMLimage::NONE;
+        if(strcmp(image->element(inode), "ZynAddSubFX-data")) {
+            cleanup();
+            return -3;  //the image doesn't embbed zynaddsubfx data
+        }
+        readversion();
+        return 0;
+    }
+    delete img;
+
     const char *xmldata = doloadfile(filename);
     if(xmldata == NULL)
         return -1;  //the file could not be loaded or uncompressed
@@ -385,11 +460,7 @@ int XMLwrapper::loadXMLfile(const string &filename)
     if(root == NULL)
         return -3;  //the XML doesn't embbed zynaddsubfx data
 
-    //fetch version information
-    _fileversion.set_major(stringTo<int>(mxmlElementGetAttr(root, "version-major")));
-    _fileversion.set_minor(stringTo<int>(mxmlElementGetAttr(root, "version-minor")));
-    _fileversion.set_revision(
-        stringTo<int>(mxmlElementGetAttr(root, "version-revision")));
+    readversion();
 
     if(verbose)
         cout << "loadXMLfile() version: " << _fileversion << endl;
@@ -398,33 +469,68 @@ int XMLwrapper::loadXMLfile(const string &filename)
 }
 
 
-char *XMLwrapper::doloadfile(const string &filename) const
-{
-    char  *xmldata = NULL;
-    gzFile gzfile  = gzopen(filename.c_str(), "rb");
-
-    if(gzfile != NULL) { //The possibly compressed file opened
-        stringstream strBuf;             //reading stream
-        const int    bufSize = 500;      //fetch size
-        char fetchBuf[bufSize + 1];      //fetch buffer
-        int  read = 0;                   //chars read in last fetch
-
-        fetchBuf[bufSize] = 0; //force null termination
+//Largest buffer taken from the size in a gzip trailer
+static const size_t LOAD_SIZE_HINT_MAX = 64 << 20;
 
-        while(bufSize == (read = gzread(gzfile, fetchBuf, bufSize)))
-            strBuf << fetchBuf;
-
-        fetchBuf[read] = 0; //Truncate last partial read
-        strBuf << fetchBuf;
+//Size of the data in a gzip file (or of a plain file), a hint for doloadfile
+static size_t loadsize(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL)
+        return 0;
 
-        gzclose(gzfile);
+    unsigned char magic[2] = {0, 0}, isize[4] = {0, 0, 0, 0};
+    size_t size = 0;
+    if(fread(magic, 1, 2, file) == 2 && !fseek(file, 0, SEEK_END)) {
+        const long bytes = ftell(file);
+        size = bytes > 0 ? bytes : 0;
+        //gzip keeps the inflated size (modulo 2^32) in its last 4 bytes
+        if(magic[0] == 0x1f && magic[1] == 0x8b && bytes >= 18
+           && !fseek(file, -4, SEEK_END) && fread(isize, 1, 4, file) == 4) {
+            const size_t hint = isize[0] | isize[1] << 8 | isize[2] << 16
+                                | (size_t)isize[3] << 24;
+            //the trailer of a truncated or corrupt file is arbitrary, so
+            //the hint can't exceed what deflate expands the file to
+            //(about 1032:1) nor LOAD_SIZE_HINT_MAX, beyond it the buffer
+            //grows as needed
+            size = std::min(hint, std::min(size * 1032, LOAD_SIZE_HINT_MAX));
+        }
+    }
+    fclose(file);
+    return size;
+}
 
-        //Place data in output format
-        string tmp = strBuf.str();
-        xmldata = new char[tmp.size() + 1];
-        strncpy(xmldata, tmp.c_str(), tmp.size() + 1);
+char *XMLwrapper::doloadfile(const string &filename) const
+{
+    gzFile gzfile = gzopen(filename.c_str(), "rb");
+    if(gzfile == NULL)
+        return NULL;
+    gzbuffer(gzfile, 128 * 1024);
+
+    //inflate into one buffer, which only grows if the size hint was wrong
+    //(one spare byte sees the end of the file, one is for the terminator)
+    size_t capacity = loadsize(filename.c_str()) + 2;
+    size_t size     = 0;
+    char  *xmldata  = new char[capacity];
+    while(true) {
+        if(capacity - size < 2) {
+            char *grown = new char[capacity * 2];
+            memcpy(grown, xmldata, size);
+            delete[] xmldata;
+            xmldata   = grown;
+            capacity *= 2;
+        }
+        const unsigned chunk = capacity - size - 1 < (1u << 30)
+                               ? capacity - size - 1 : (1u << 30);
+        const int read = gzread(gzfile, xmldata + size, chunk);
+        if(read > 0)
+            size += read;
+        if(read < (int)chunk)
+            break;
     }
+    gzclose(gzfile);
 
+    xmldata[size] = 0;
     return xmldata;
 }
 
@@ -456,24 +562,37 @@ bool XMLwrapper::putXMLdata(const char *xmldata)
     if(root == NULL)
         return false;
 
-    //fetch version information
-    _fileversion.set_major(stringTo<int>(mxmlElementGetAttr(root, "version-major")));
-    _fileversion.set_minor(stringTo<int>(mxmlElementGetAttr(root, "version-minor")));
-    _fileversion.set_revision(
-        stringTo<int>(mxmlElementGetAttr(root, "version-revision")));
+    readversion();
 
     return true;
 }
 
+void XMLwrapper::readversion(void)
+{
+    auto attr = [this](const char *name) {
+        return image ? image->attr(inode, name) : mxmlElementGetAttr(root, name);
+    };
+    //fetch version information
+    _fileversion.set_major(stringTo<int>(attr("version-major")));
+    _fileversion.set_minor(stringTo<int>(attr("version-minor")));
+    _fileversion.set_revision(stringTo<int>(attr("version-revision")));
+}
+
 
 
 int XMLwrapper::enterbranch(const string &name)
 {
     if(verbose)
         cout << "enterbranch() " << name << endl;
-    mxml_node_t *tmp = mxmlFindElement(node, node,
-                                       name.c_str(), NULL, NULL,
-                                       MXML_DESCEND_FIRST);
+    if(image) {
+        const uint32_t tmp = image->find(inode, icursor, name.c_str(), 0, NULL);
+        if(tmp == XMLimage::NONE)
+            return 0;
+        inode   = tmp;
+        icursor = XMLimage::NONE;
+        return 1;
+    }
+    mxml_node_t *tmp = findchild(name.c_str(), 0, NULL);
     if(tmp == NULL)
         return 0;
 
@@ -485,9 +604,17 @@ int XMLwrapper::enterbranch(const string &name, int id)
 {
     if(verbose)
         cout << "enterbranch(" << id << ") " << name << endl;
-    mxml_node_t *tmp = mxmlFindElement(node, node,
-                                       name.c_str(), "id", stringFrom<int>(
-                                           id).c_str(), MXML_DESCEND_FIRST);
+    if(image) {
+        const uint32_t tmp = image->find(inode, icursor, name.c_str(), 'i',
+                                         stringFrom<int>(id).c_str());
+        if(tmp == XMLimage::NONE)
+            return 0;
+        inode   = tmp;
+        icursor = XMLimage::NONE;
+        return 1;
+    }
+    mxml_node_t *tmp = findchild(name.c_str(), 'i',
+                                 stringFrom<int>(id).c_str());
     if(tmp == NULL)
         return 0;
 
@@ -498,6 +625,14 @@ int XMLwrapper::enterbranch(const string &name, int id)
 
 void XMLwrapper::exitbranch()
 {
+    if(image) {
+        if(verbose)
+            cout << "exitbranch()" << image->element(inode) << endl;
+        //the siblings are mostly read in order, so continue after this one
+        icursor = image->next(inode);
+        inode   = image->parent(inode);
+        return;
+    }
     if(verbose)
         cout << "exitbranch()" << node << "-" << mxmlGetElement(node)
              << " To "
@@ -508,7 +643,8 @@ void XMLwrapper::exitbranch()
 
 int XMLwrapper::getbranchid(int min, int max) const
 {
-    int id = stringTo<int>(mxmlElementGetAttr(node, "id"));
+    int id = stringTo<int>(image ? image->attr(inode, "id")
+                                 : mxmlElementGetAttr(node, "id"));
     if((min == 0) && (max == 0))
         return id;
 
@@ -524,17 +660,7 @@ int XMLwrapper::getbranchid(int min, int max) const
 int XMLwrapper::getpar(const string &name, int defaultpar, int min,
                        int max) const
 {
-    const mxml_node_t *tmp = mxmlFindElement(node,
-                                             node,
-                                             "par",
-                                             "name",
-                                             name.c_str(),
-                                             MXML_DESCEND_FIRST);
-
-    if(tmp == NULL)
-        return defaultpar;
-
-    const char *strval = mxmlElementGetAttr(tmp, "value");
+    const char *strval = childattr("par", 'n', name.c_str(), "value");
     if(strval == NULL)
         return defaultpar;
 
@@ -555,17 +681,7 @@ int XMLwrapper::getpar127(const string &name, int defaultpar) const
 
 bool XMLwrapper::getparbool(const string &name, bool defaultpar) const
 {
-    const mxml_node_t *tmp = mxmlFindElement(node,
-                                             node,
-                                             "par_bool",
-                                             "name",
-                                             name.c_str(),
-                                             MXML_DESCEND_FIRST);
-
-    if(tmp == NULL)
-        return defaultpar;
-
-    const char *strval = mxmlElementGetAttr(tmp, "value");
+    const char *strval = childattr("par_bool", 'n', name.c_str(), "value");
     if(strval == NULL)
         return defaultpar;
 
@@ -575,82 +691,34 @@ bool XMLwrapper::getparbool(const string &name, bool defaultpar) const
 void XMLwrapper::getparstr(const string &name, char *par, int maxstrlen) const
 {
     ZERO(par, maxstrlen);
-    mxml_node_t *tmp = mxmlFindElement(node,
-                                       node,
-                                       "string",
-                                       "name",
-                                        name.c_str(),
-                                        MXML_DESCEND_FIRST);
-
-    if(tmp == NULL)
-        return;
-    if(mxmlGetFirstChild(tmp) == NULL)
-        return;
-    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TYPE_OPAQUE) {
-        snprintf(par, maxstrlen, "%s", mxmlGetOpaque(mxmlGetFirstChild(tmp)));
-        return;
-    }
-    if((mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TYPE_TEXT)
-       && (mxmlGetFirstChild(tmp) != NULL)) {
-        snprintf(par, maxstrlen, "%s", mxmlGetText(mxmlGetFirstChild(tmp),NULL));
-        return;
-    }
+    const char *text = childtext(name.c_str());
+    if(text)
+        snprintf(par, maxstrlen, "%s", text);
 }
 
 string XMLwrapper::getparstr(const string &name,
                              const std::string &defaultpar) const
 {
-    mxml_node_t *tmp = mxmlFindElement(node,
-                                       node,
-                                       "string",
-                                       "name",
-                                       name.c_str(),
-                                       MXML_DESCEND_FIRST);
-
-    if((tmp == NULL) || (mxmlGetFirstChild(tmp) == NULL))
-        return defaultpar;
-
-    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TYPE_OPAQUE
-       && (mxmlGetOpaque(mxmlGetFirstChild(tmp)) != NULL))
-        return mxmlGetOpaque(mxmlGetFirstChild(tmp));
-
-    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TYPE_TEXT
-       && (mxmlGetText(mxmlGetFirstChild(tmp),NULL) != NULL))
-        return mxmlGetText(mxmlGetFirstChild(tmp),NULL);
-
-    return defaultpar;
+    const char *text = childtext(name.c_str());
+    return text ? text : defaultpar;
 }
 
 bool XMLwrapper::hasparreal(const char *name) const
 {
-    const mxml_node_t *tmp = mxmlFindElement(node,
-                                             node,
-                                             "par_real",
-                                             "name",
-                                             name,
-                                             MXML_DESCEND_FIRST);
-    return tmp != nullptr;
+    //the child found always has the attribute name
+    return childattr("par_real", 'n', name, "name") != nullptr;
 }
 
 float XMLwrapper::getparreal(const char *name, float defaultpar) const
 {
-    const mxml_node_t *tmp = mxmlFindElement(node,
-                                             node,
-                                             "par_real",
-                                             "name",
-                                             name,
-                                             MXML_DESCEND_FIRST);
-    if(tmp == NULL)
-        return defaultpar;
-
-    const char *strval = mxmlElementGetAttr(tmp, "exact_value");
+    const char *strval = childattr("par_real", 'n', name, "exact_value");
     if (strval != NULL) {
         union { float out; uint32_t in; } convert;
         sscanf(strval+2, "%x", &convert.in);
         return convert.out;
     }
 
-    strval = mxmlElementGetAttr(tmp, "value");
+    strval = childattr("par_real", 'n', name, "value");
     if(strval == NULL)
         return defaultpar;
 
@@ -675,11 +743,93 @@ float XMLwrapper::getparreal(const char *name,
 
 /** Private members **/
 
+//Key of a child in the index of its branch
+static string indexkey(const char *element, char attr, const char *value)
+{
+    string key(element);
+    if(attr) {
+        key += '\0';
+        key += attr;
+        key += value;
+    }
+    return key;
+}
+
+mxml_node_t *XMLwrapper::findchild(const char *element, char attr,
+                                   const char *value) const
+{
+    if(node == NULL)
+        return NULL;
+
+    auto branch = index.find(node);
+    if(branch == index.end()) {
+        branch = index.emplace(node,
+                               unordered_map<string, mxml_node_t *>()).first;
+        auto &children = branch->second;
+        for(mxml_node_t *child = mxmlGetFirstChild(node); child;
+            child = mxmlGetNextSibling(child)) {
+            if(mxmlGetType(child) != MXML_TYPE_ELEMENT)
+                continue;
+            const char *name = mxmlGetElement(child);
+            if(name == NULL)
+                continue;
+            //emplace() keeps the first of equal keys, as a scan finds it
+            children.emplace(indexkey(name, 0, NULL), child);
+            if(const char *v = mxmlElementGetAttr(child, "name"))
+                children.emplace(indexkey(name, 'n', v), child);
+            if(const char *v = mxmlElementGetAttr(child, "id"))
+                children.emplace(indexkey(name, 'i', v), child);
+        }
+    }
+
+    auto child = branch->second.find(indexkey(element, attr, value));
+    return child == branch->second.end() ? NULL : child->second;
+}
+
+const char *XMLwrapper::childattr(const char *element, char attr,
+                                  const char *value, const char *name) const
+{
+    if(image) {
+        const uint32_t tmp = image->find(inode, icursor, element, attr, value);
+        if(tmp == XMLimage::NONE)
+            return NULL;
+        icursor = image->next(tmp);
+        return image->attr(tmp, name);
+    }
+
+    const mxml_node_t *tmp = findchild(element, attr, value);
+    return tmp ? mxmlElementGetAttr(tmp, name) : NULL;
+}
+
+const char *XMLwrapper::childtext(const char *name) const
+{
+    if(image) {
+        const uint32_t tmp = image->find(inode, icursor, "string", 'n', name);
+        if(tmp == XMLimage::NONE)
+            return NULL;
+        icursor = image->next(tmp);
+        return image->text(tmp);
+    }
+
+    mxml_node_t *tmp = findchild("string", 'n', name);
+    if((tmp == NULL) || (mxmlGetFirstChild(tmp) == NULL))
+        return NULL;
+
+    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TYPE_OPAQUE)
+        return mxmlGetOpaque(mxmlGetFirstChild(tmp));
+
+    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TYPE_TEXT)
+        return mxmlGetText(mxmlGetFirstChild(tmp), NULL);
+
+    return NULL;
+}
+
 mxml_node_t *XMLwrapper::addparams(const char *name, unsigned int params,
                                    ...) const
 {
     /**@todo make this function send out a good error message if something goes
      * wrong**/
+    index.erase(node);
     mxml_node_t *element = mxmlNewElement(node, name);
 
     if(params) {
@@ -728,6 +878,7 @@ bool XmlNode::has(std::string name_)
 
 void XMLwrapper::add(const XmlNode &node_)
 {
+    index.erase(node);
     mxml_node_t *element = mxmlNewElement(node, node_.name.c_str());
     for(auto attr:node_.attrs)
         mxmlElementSetAttr(element, attr.name.c_str(),
@@ -737,6 +888,19 @@ void XMLwrapper::add(const XmlNode &node_)
 std::vector<XmlNode> XMLwrapper::getBranch(void) const
 {
     std::vector<XmlNode> res;
+    if(image) {
+        for(uint32_t c = image->firstchild(inode); c != XMLimage::NONE;
+            c = image->next(c)) {
+            XmlNode n(image->element(c));
+            for(int i = 0; i < image->attrcount(c); ++i) {
+                const char *name;
+                const char *attrib = image->attr(c, i, &name);
+                n[name] = attrib;
+            }
+            res.push_back(n);
+        }
+        return res;
+    }
     mxml_node_t *current = mxmlGetFirstChild(node);
     while(current) {
         if(mxmlGetType(current) == MXML_TYPE_ELEMENT) {
@@ -14,7 +14,9 @@
 */
 
 #include <mxml.h>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "zyn-version.h"
 
@@ -27,6 +29,8 @@
 
 namespace zyn {
 
+class XMLimage;
+
 class XmlAttr
 {
     public:
@@ -66,6 +70,16 @@ class XMLwrapper
          */
         int saveXMLfile(const std::string &filename, int compression) const;
 
+        /**
+         * Saves the tree as a binary image (see XMLimage), which
+         * loadXMLfile() reads like a XML file.
+         * The image is written to a temporary file which then replaces the
+         * destination, as other instances may have the old one mapped.
+         * @param filename the name of the destination file.
+         * @returns 0 if ok or -1 if the file cannot be saved.
+         */
+        int saveBinaryfile(const std::string &filename) const;
+
         /**
          * Return XML tree as a string.
          * Note: The string must be freed with free() to deallocate
@@ -125,7 +139,9 @@ class XMLwrapper
 
         /**
          * Loads file into XMLwrapper.
-         * @param filename file to be loaded
+         * Binary images are mapped and read in place, which leaves nothing
+         * to add to (the tree is read only then).
+         * @param filename file to be loaded (XML, gzipped XML or an image)
          * @returns 0 if ok or -1 if the file cannot be loaded
          */
         int loadXMLfile(const std::string &filename);
@@ -275,6 +291,49 @@ class XMLwrapper
          */
         void cleanup(void);
 
+        /**
+         * Find a child of the current node, like mxmlFindElement() with
+         * MXML_DESCEND_FIRST (the first match wins), through the index of
+         * the node.
+         * @param element Element name of the child
+         * @param attr 0 for any child with that name, 'n' or 'i' for the one
+         * with the "name" or "id" attribute value
+         * @param value The attribute value
+         */
+        mxml_node_t *findchild(const char *element, char attr,
+                               const char *value) const;
+
+        /**
+         * Attribute of a child of the current node (found as with
+         * findchild()) in the tree or the image.
+         * @returns NULL if there is no such child or attribute
+         */
+        const char *childattr(const char *element, char attr,
+                              const char *value, const char *name) const;
+        /**
+         * Text of the "string" child name of the current node.
+         * @returns NULL if there is no such child or text
+         */
+        const char *childtext(const char *name) const;
+
+        //Read the version of the file from the attributes of root
+        void readversion(void);
+
+        XMLimage *image;   /**<loaded image, which replaces the tree*/
+        uint32_t  inode;   /**<current node of the image*/
+        mutable uint32_t icursor; /**<child of inode after the last found*/
+
+        /**
+         * Children of the branches that were looked up, by element name
+         * and "name" or "id" attribute. A branch is indexed in a single
+         * pass over its children on its first lookup, so loading no longer
+         * scans all siblings for every parameter. Adding to a branch drops
+         * its index.
+         */
+        mutable std::unordered_map<const mxml_node_t *,
+                                   std::unordered_map<std::string,
+                                                      mxml_node_t *>> index;
+
         mxml_node_t *tree; /**<all xml data*/
         mxml_node_t *root; /**<xml data used by zynaddsubfx*/
         mxml_node_t *node; /**<current subtree in parsing or writing */
@@ -16,6 +16,8 @@
 #include "../Misc/Part.h"
 #include "../Misc/MiddleWare.h"
 #include <rtosc/thread-link.h>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 using namespace std;
 
@@ -62,9 +64,16 @@ ostream &operator<<(ostream &out, const MidiEvent &ev)
 }
 
 MidiEvent::MidiEvent()
-    :channel(0), type(0), num(0), value(0), time(0)
+    :channel(0), type(0), num(0), value(0), time(0), log2_freq(0.0f), stamp(0)
 {}
 
+static uint64_t now_us(void)
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(
+            steady_clock::now().time_since_epoch()).count();
+}
+
 InMgr &InMgr::getInstance()
 {
     static InMgr instance;
@@ -72,10 +81,9 @@ InMgr &InMgr::getInstance()
 }
 
 InMgr::InMgr()
-    :queue(256), master(NULL)
+    :queue(1024), master(NULL), events(0), maxLatency(0)
 {
     current = NULL;
-    work.init(PTHREAD_PROCESS_PRIVATE, 0);
 }
 
 InMgr::~InMgr()
@@ -85,29 +93,31 @@ InMgr::~InMgr()
 
 void InMgr::putEvent(MidiEvent ev)
 {
-    if(queue.push(ev)) //check for error
-        cerr << "ERROR: MIDI ringbuffer is FULL" << endl;
-    else
-        work.post();
+    ev.stamp = now_us();
+    //overflows are counted by the queue (see stats())
+    queue.push(ev);
 }
 
 bool InMgr::flush(unsigned frameStart, unsigned frameStop)
 {
-    MidiEvent ev;
     bool endReached = true;
-
-    while(!work.trywait()) {
-        queue.peak(ev);
-        if(ev.time < (int)frameStart || ev.time > (int)frameStop) {
-            //Check if end was reached
-            endReached = ev.time < (int)frameStart;
-            //Back out of transaction
-            work.post();
-            //printf("%d vs [%d..%d]\n",ev.time, frameStart, frameStop);
+    const uint64_t now = now_us();
+    uint32_t applied = 0, latency = 0;
+
+    while(MidiEvent *next = queue.front()) {
+        if(next->time < (int)frameStart || next->time > (int)frameStop) {
+            //Check if end was reached, the event stays queued
+            endReached = next->time < (int)frameStart;
+            //printf("%d vs [%d..%d]\n",next->time, frameStart, frameStop);
             break;
         }
-        queue.pop(ev);
+        const MidiEvent ev = *next;
+        queue.pop();
+        ++applied;
+        if(now > ev.stamp)
+            latency = std::max(latency, (uint32_t)(now - ev.stamp));
         //cout << ev << endl;
+        master->setEventOffset(ev.time - frameStart);
 
         switch(ev.type) {
             case M_NOTE:
@@ -149,13 +159,30 @@ bool InMgr::flush(unsigned frameStart, unsigned frameStop)
                 break;
         }
     }
+
+    if(applied) {
+        events.fetch_add(applied, std::memory_order_relaxed);
+        uint32_t prev = maxLatency.load(std::memory_order_relaxed);
+        while(latency > prev &&
+              !maxLatency.compare_exchange_weak(prev, latency,
+                                                std::memory_order_relaxed))
+            ;
+    }
     return endReached;
 }
 
 bool InMgr::empty(void) const
 {
-    int semvalue = work.getvalue();
-    return semvalue <= 0;
+    return queue.empty();
+}
+
+MidiStats InMgr::stats(void)
+{
+    MidiStats s;
+    s.events     = events.exchange(0);
+    s.overflows  = queue.overflows.load();
+    s.maxLatency = maxLatency.exchange(0);
+    return s;
 }
 
 bool InMgr::setSource(string name)
@@ -12,9 +12,10 @@
 #ifndef INMGR_H
 #define INMGR_H
 
+#include <atomic>
+#include <cstdint>
 #include <string>
-#include "ZynSema.h"
-#include "SafeQueue.h"
+#include "../Containers/MpscRing.h"
 
 namespace zyn {
 
@@ -35,6 +36,14 @@ struct MidiEvent {
     int value;   //velocity or controller value
     int time;    //time offset of event (used only in jack->jack case at the moment)
     float log2_freq;   //type=5,6 for logarithmic representation of note/parameter
+    uint64_t stamp;    //microseconds on the steady clock when it was queued
+};
+
+//counters of the MIDI input queue
+struct MidiStats {
+    uint32_t events;     //events applied
+    uint32_t overflows;  //events dropped since the queue was full
+    uint32_t maxLatency; //microseconds from putEvent() to flush()
 };
 
 //super simple class to manage the inputs
@@ -44,9 +53,13 @@ class InMgr
         static InMgr &getInstance();
         ~InMgr();
 
+        /**Queue an event, this may be called from any number of threads
+         * (it neither locks nor allocates)*/
         void putEvent(MidiEvent ev);
 
-        /**Flush the Midi Queue*/
+        /**Flush the Midi Queue
+         * All events up to frameStop are applied in one pass, each at its
+         * frame within the buffer (see Master::setEventOffset())*/
         bool flush(unsigned frameStart, unsigned frameStop);
 
         bool empty() const;
@@ -57,14 +70,19 @@ class InMgr
 
         void setMaster(class Master *master);
 
+        /**Counters since the last call (the overflows since the start)*/
+        MidiStats stats(void);
+
         friend class EngineMgr;
     private:
         InMgr();
         class MidiIn *getIn(std::string name);
-        SafeQueue<MidiEvent> queue;
-        mutable ZynSema work;
+        MpscRing<MidiEvent> queue;
         class MidiIn * current;
 
+        std::atomic<uint32_t> events;
+        std::atomic<uint32_t> maxLatency;
+
         /**the link to the rest of zyn*/
         class Master *master;
 };
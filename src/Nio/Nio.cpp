@@ -197,4 +197,13 @@ bool Nio::getAudioCompressor(void)
     return out->getAudioCompressor();
 }
 
+void Nio::getMidiStats(unsigned &events, unsigned &overflows,
+                       unsigned &maxLatency)
+{
+    const MidiStats stats = InMgr::getInstance().stats();
+    events     = stats.events;
+    overflows  = stats.overflows;
+    maxLatency = stats.maxLatency;
+}
+
 }
@@ -60,6 +60,11 @@ namespace Nio
     void setAudioCompressor(bool isEnabled);
     bool getAudioCompressor(void);
 
+    //MIDI input counters, events and latency (in microseconds) are
+    //reset by every call
+    void getMidiStats(unsigned &events, unsigned &overflows,
+                      unsigned &maxLatency);
+
     extern bool autoConnect;
     extern bool pidInClientName;
     extern std::string defaultSource;
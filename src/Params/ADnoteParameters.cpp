@@ -154,6 +154,8 @@ static const Ports voicePorts = {
         "Signal Inverter"), //do we really need this??
     rToggle(PAAEnabled,        rShort("enable"), rDefault(false),
         "AntiAliasing Enable"),
+    rOption(PAAType,           rShort("type"), rOptions(sinc, mipmap),
+        rDefault(sinc), "AntiAliasing Method"),
     rParamZyn(PAmpVelocityScaleFunction, rShort("sense"), rDefault(127),
         "Velocity Sensing"),
     rToggle(PAmpEnvelopeEnabled, rShort("enable"), rDefault(false),
@@ -576,6 +578,7 @@ void ADnoteVoiceParam::defaults()
     volume                    = -60.0f* (1.0f - 100.0f / 127.0f);
     PVolumeminus              = false;
     PAAEnabled                = 0;
+    PAAType                   = 0;
     PPanning                  = 64; //center
     PDetune                   = 8192; //8192=0
     PCoarseDetune             = 0;
@@ -659,6 +662,29 @@ void ADnoteVoiceParam::enable(const SYNTH_T &synth, FFTwrapper *fft,
     FMAmpEnvelope->init(ad_voice_fm_amp);
 }
 
+/*
+ * Prepare the oscillators for note-on, including the ones voices borrow
+ */
+void ADnoteParameters::applyparameters(void)
+{
+    bool oscil[NUM_VOICES] = {}, fmoscil[NUM_VOICES] = {};
+    for(int nvoice = 0; nvoice < NUM_VOICES; ++nvoice) {
+        const ADnoteVoiceParam &param = VoicePar[nvoice];
+        if(!param.Enabled)
+            continue;
+        oscil[param.Pextoscil != -1 ? param.Pextoscil : nvoice] = true;
+        if(param.PFMEnabled != FMTYPE::NONE && param.PFMVoice < 0)
+            fmoscil[param.PextFMoscil != -1 ? param.PextFMoscil : nvoice] = true;
+    }
+
+    for(int nvoice = 0; nvoice < NUM_VOICES; ++nvoice) {
+        if(oscil[nvoice])
+            VoicePar[nvoice].OscilGn->updateBands();
+        if(fmoscil[nvoice])
+            VoicePar[nvoice].FmGn->updateBands();
+    }
+}
+
 /*
  * Get the Multiplier of the fine detunes of the voices
  */
@@ -780,6 +806,8 @@ void ADnoteVoiceParam::add2XML(XMLwrapper& xml, bool fmoscilused)
 
     xml.addpar("fm_enabled", (int)PFMEnabled);
     xml.addparbool("sync_enabled", PsyncEnabled);
+    xml.addparbool("anti_aliasing", PAAEnabled);
+    xml.addpar("anti_aliasing_type", PAAType);
 
     xml.beginbranch("OSCIL");
     OscilGn->add2XML(xml);
@@ -1141,6 +1169,8 @@ void ADnoteVoiceParam::paste(ADnoteVoiceParam &a)
     copy(PPanning);
     copy(volume);
     copy(PVolumeminus);
+    copy(PAAEnabled);
+    copy(PAAType);
     copy(PAmpVelocityScaleFunction);
     copy(PAmpEnvelopeEnabled);
 
@@ -1275,6 +1305,8 @@ void ADnoteVoiceParam::getfromXML(XMLwrapper& xml, unsigned nvoice)
     PfilterFcCtlBypass  = xml.getparbool("filter_fcctl_bypass", PfilterFcCtlBypass);
     PFMEnabled     = (FMTYPE)xml.getpar127("fm_enabled", (int)PFMEnabled);
     PsyncEnabled   = xml.getparbool("sync_enabled", PsyncEnabled);
+    PAAEnabled     = xml.getparbool("anti_aliasing", PAAEnabled);
+    PAAType        = xml.getpar127("anti_aliasing_type", PAAType);
 
     if(xml.enterbranch("OSCIL")) {
         OscilGn->getfromXML(xml);
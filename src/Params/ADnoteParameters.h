@@ -224,6 +224,9 @@ struct ADnoteVoiceParam {
     /* if AntiAliasing is enabled */
     bool PAAEnabled;
 
+    /* AntiAliasing method (0=windowed sinc, 1=mipmapped wavetables) */
+    unsigned char PAAType;
+
     /* Velocity sensing */
     unsigned char PAmpVelocityScaleFunction;
 
@@ -333,6 +336,8 @@ class ADnoteParameters:public PresetsArray
         void paste(ADnoteParameters &a);
         void pasteArray(ADnoteParameters &a, int section);
 
+        //! Make the band tables of the oscillators the enabled voices use
+        void applyparameters(void) NONREALTIME;
 
         float getBandwidthDetuneMultiplier() const;
         float getUnisonFrequencySpreadCents(int nvoice) const;
@@ -10,7 +10,6 @@
   as published by the Free Software Foundation; either version 2
   of the License, or (at your option) any later version.
 */
-#include <limits>
 #include <cmath>
 #include "PADnoteParameters.h"
 #include "FilterParams.h"
@@ -18,13 +17,17 @@
 #include "LFOParams.h"
 #include "../Synth/Resonance.h"
 #include "../Synth/OscilGen.h"
+#include "../Misc/Denormals.h"
+#include "../Misc/PadGenPool.h"
+#include "../Misc/PadSampleCache.h"
 #include "../Misc/WavFile.h"
+#include "../Misc/XMLwrapper.h"
 #include "../Misc/Time.h"
 #include <cstdio>
-#include <thread>
 
 #include <rtosc/ports.h>
 #include <rtosc/port-sugar.h>
+#include <rtosc/thread-link.h>
 using namespace rtosc;
 
 namespace zyn {
@@ -93,10 +96,15 @@ static const rtosc::Ports realtime_ports =
             const char *mm = m;
             while(!isdigit(*mm))++mm;
             int n = atoi(mm);
-            float *oldsmp = p->sample[n].smp;
+            //The replaced sample is kept until the notes which play it
+            //crossfaded to the new one (see releaseprevsamples()). One
+            //replaced earlier in the same buffer was never played.
+            float *oldsmp = p->prevsample[n].smp;
+            p->prevsample[n]      = p->sample[n];
             p->sample[n].size     = rtosc_argument(m,0).i;
             p->sample[n].basefreq = rtosc_argument(m,1).f;
             p->sample[n].smp      = *(float**)rtosc_argument(m,2).b.data;
+            p->prevpending        = true;
             if (oldsmp)
                 d.reply("/free", "sb", "PADsample", sizeof(void*), &oldsmp);
         }},
@@ -352,7 +360,8 @@ PADnoteParameters::PADnoteParameters(const SYNTH_T &synth_, FFTwrapper *fft_,
     FilterLfo = new LFOParams(ad_global_filter, time_);
 
     for(int i = 0; i < PAD_MAX_SAMPLES; ++i)
-        sample[i].smp = NULL;
+        sample[i].smp = prevsample[i].smp = NULL;
+    prevpending = false;
 
     defaults();
 }
@@ -447,6 +456,8 @@ void PADnoteParameters::deletesample(int n)
     sample[n].smp = NULL;
     sample[n].size     = 0;
     sample[n].basefreq = 440.0f;
+    delete[] prevsample[n].smp;
+    prevsample[n].smp = NULL;
 }
 
 void PADnoteParameters::deletesamples()
@@ -455,6 +466,18 @@ void PADnoteParameters::deletesamples()
         deletesample(i);
 }
 
+void PADnoteParameters::releaseprevsamples(rtosc::ThreadLink &link)
+{
+    for(int n = 0; n < PAD_MAX_SAMPLES; ++n) {
+        float *smp = prevsample[n].smp;
+        if(!smp)
+            continue;
+        prevsample[n].smp = NULL;
+        link.write("/free", "sb", "PADsample", sizeof(void*), &smp);
+    }
+    prevpending = false;
+}
+
 /*
  * Get the harmonic profile (i.e. the frequency distributio of a single harmonic)
  */
@@ -875,6 +898,19 @@ void PADnoteParameters::applyparameters(std::function<bool()> do_abort,
         deletesample(i);
 }
 
+//Seed of the random phases of sample nsample of a generation, hashed so
+//the streams of neighbouring samples are unrelated
+static prng_t sampleSeed(prng_t seed, int nsample)
+{
+    prng_t x = seed ^ (0x9e3779b9u * (prng_t)(nsample + 1));
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
 //Requires
 // - Pquality.samplesize
 // - Pquality.basenote
@@ -883,11 +919,9 @@ void PADnoteParameters::applyparameters(std::function<bool()> do_abort,
 // - spectrum at various frequencies (oodles of data)
 int PADnoteParameters::sampleGenerator(PADnoteParameters::callback cb,
         std::function<bool()> do_abort,
-        unsigned max_threads)
+        unsigned max_threads,
+        bool cached)
 {
-    if(!max_threads)
-        max_threads = std::numeric_limits<unsigned>::max();
-
     const int samplesize   = (((int) 1) << (Pquality.samplesize + 14));
     const int spectrumsize = samplesize / 2;
     const int profilesize = 512;
@@ -926,96 +960,140 @@ int PADnoteParameters::sampleGenerator(PADnoteParameters::callback cb,
 
     const PADnoteParameters* this_c = this;
 
-    auto thread_cb = [basefreq, bwadjust, &cb, do_abort,
-                      samplesize, samplemax, spectrumsize,
-                      adj_ptr, &profile, this_c](
-                      unsigned nthreads, unsigned threadno)
+    //Samples generated from the same parameters before are loaded from disk
+    const std::string key = cached && PadSampleCache::enabled()
+                            ? sampleFingerprint() : "";
+    if(!key.empty() && PadSampleCache::load(key, samplemax, samplesize, cb))
+        return samplemax;
+    PadSampleCache::Writer cache(key, samplemax, samplesize);
+
+    //Every sample draws from a stream of its own, so the samples do not
+    //depend on which thread generates which of them
+    const prng_t seed = prng_r(prng_state);
+
+    auto generate = [basefreq, bwadjust, &cb, &cache, do_abort,
+                     samplesize, samplemax, spectrumsize, seed,
+                     adj_ptr, &profile, this_c](
+                     int nsample, FFTwrapper *fft, FFTfreqBuffer fftfreqs,
+                     float *spectrum)
     {
+        if(do_abort())
+            return;
+        //the workers flush denormals, so the calling thread does it too
+        DenormalGuard guard;
+        prng_t stream = sampleSeed(seed, nsample);
+        PrngScope scope(stream);
+        const float basefreqadjust =
+            powf(2.0f, adj_ptr[nsample] - adj_ptr[samplemax - 1] * 0.5f);
+
+        if(this_c->Pmode == pad_mode::bandwidth)
+            this_c->generatespectrum_bandwidthMode(spectrum,
+                                                   spectrumsize,
+                                                   basefreq*basefreqadjust,
+                                                   profile,
+                                                   profilesize,
+                                                   bwadjust);
+        else
+            this_c->generatespectrum_otherModes(spectrum, spectrumsize,
+                                                basefreq * basefreqadjust);
+
+        //the last samples contain the first samples
+        //(used for linear/cubic interpolation)
+        PADnoteParameters::Sample newsample;
+        newsample.smp = new float[samplesize + extra_samples];
+
+        newsample.smp[0] = 0.0f;
+        fftfreqs[0] = fft_t(0, 0);
+        for(int i = 1; i < spectrumsize; ++i) //randomize the phases
+            fftfreqs[i] = FFTpolar(spectrum[i], (float)RND * 2 * PI);
+        //that's all; here is the only ifft for the whole sample;
+        //no windows are used ;-)
+        fft->freqs2smps_noconst_input(fftfreqs, fft->allocSampleBuf(newsample.smp));
+
+        //normalize(rms)
+        float rms = 0.0f;
+        for(int i = 0; i < samplesize; ++i)
+            rms += newsample.smp[i] * newsample.smp[i];
+        rms = sqrtf(rms);
+        if(rms < 0.000001f)
+            rms = 1.0f;
+        rms *= sqrtf(262144.0f / samplesize);//262144=2^18
+        for(int i = 0; i < samplesize; ++i)
+            newsample.smp[i] *= 1.0f / rms * 50.0f;
+
+        //prepare extra samples used by the linear or cubic interpolation
+        for(int i = 0; i < extra_samples; ++i)
+            newsample.smp[i + samplesize] = newsample.smp[i];
+
+        //yield new sample
+        newsample.size     = samplesize;
+        newsample.basefreq = basefreq * basefreqadjust;
+        cache.add(nsample, newsample);
+        cb(nsample, std::move(newsample));
+    };
+
+    if(oscilgen->needPrepare())
+        oscilgen->prepare();
+
+    //Each sample is one task of the shared generator pool, whose workers
+    //keep their big IFFTs between the calls
+    std::shared_ptr<PadGenPool> pool;
+    if(max_threads != 1)
+        pool = PadGenPool::current();
+    if(pool)
+        pool->run(samplemax, [&](int nsample, PadGenPool::Scratch &scratch) {
+                generate(nsample, scratch.fft(samplesize),
+                         scratch.freqs(samplesize),
+                         scratch.buffer(spectrumsize));
+            });
+    else {
         //prepare a BIG IFFT
         FFTwrapper    *fft      = new FFTwrapper(samplesize);
         FFTfreqBuffer  fftfreqs = fft->allocFreqBuf();
         float         *spectrum = new float[spectrumsize];
 
         for(int nsample = 0; nsample < samplemax; ++nsample)
-        if(nsample % nthreads == threadno)
-        {
-            if(do_abort())
-                break;
-            const float basefreqadjust =
-                powf(2.0f, adj_ptr[nsample] - adj_ptr[samplemax - 1] * 0.5f);
-
-            if(this_c->Pmode == pad_mode::bandwidth)
-                this_c->generatespectrum_bandwidthMode(spectrum,
-                                                       spectrumsize,
-                                                       basefreq*basefreqadjust,
-                                                       profile,
-                                                       profilesize,
-                                                       bwadjust);
-            else
-                this_c->generatespectrum_otherModes(spectrum, spectrumsize,
-                                                    basefreq * basefreqadjust);
-
-            //the last samples contain the first samples
-            //(used for linear/cubic interpolation)
-            const int extra_samples = 5;
-            PADnoteParameters::Sample newsample;
-            newsample.smp = new float[samplesize + extra_samples];
-
-            newsample.smp[0] = 0.0f;
-            fftfreqs[0] = fft_t(0, 0);
-            for(int i = 1; i < spectrumsize; ++i) //randomize the phases
-                fftfreqs[i] = FFTpolar(spectrum[i], (float)RND * 2 * PI);
-            //that's all; here is the only ifft for the whole sample;
-            //no windows are used ;-)
-            fft->freqs2smps_noconst_input(fftfreqs, fft->allocSampleBuf(newsample.smp));
-
-            //normalize(rms)
-            float rms = 0.0f;
-            for(int i = 0; i < samplesize; ++i)
-                rms += newsample.smp[i] * newsample.smp[i];
-            rms = sqrtf(rms);
-            if(rms < 0.000001f)
-                rms = 1.0f;
-            rms *= sqrtf(262144.0f / samplesize);//262144=2^18
-            for(int i = 0; i < samplesize; ++i)
-                newsample.smp[i] *= 1.0f / rms * 50.0f;
-
-            //prepare extra samples used by the linear or cubic interpolation
-            for(int i = 0; i < extra_samples; ++i)
-                newsample.smp[i + samplesize] = newsample.smp[i];
-
-            //yield new sample
-            newsample.size     = samplesize;
-            newsample.basefreq = basefreq * basefreqadjust;
-            cb(nsample, std::move(newsample));
-        }
+            generate(nsample, fft, fftfreqs, spectrum);
 
         //Cleanup
         delete (fft);
-        delete[] fftfreqs.data;
+        FFT_freeBuffer(fftfreqs.data);
         delete[] spectrum;
-    };
-
-    if(oscilgen->needPrepare())
-        oscilgen->prepare();
-
-#ifdef WIN32
-    //Temporarily disable multi-threading here as C++11 threads are broken on
-    //mingw cross compilation
-    thread_cb(1,0);
-#else
-    unsigned nthreads = std::min(max_threads,
-                                 std::thread::hardware_concurrency());
-    std::vector<std::thread> threads(nthreads);
-    for(unsigned i = 0; i < nthreads; ++i)
-        threads[i] = std::thread(thread_cb, nthreads, i);
-    for(unsigned i = 0; i < nthreads; ++i)
-        threads[i].join();
-#endif
+    }
+    cache.commit();
 
     return samplemax;
 }
 
+std::string PADnoteParameters::sampleFingerprint(void) const
+{
+    std::string key;
+    auto put = [&key](const void *data, size_t size) {
+        key.append((const char*)data, size);
+    };
+    put(&synth.samplerate, sizeof(synth.samplerate));
+    put(&synth.oscilsize, sizeof(synth.oscilsize));
+    put(&Pmode, sizeof(Pmode));
+    put(&Php, sizeof(Php));
+    put(&Pbandwidth, sizeof(Pbandwidth));
+    put(&Pbwscale, sizeof(Pbwscale));
+    put(&Phrpos, sizeof(Phrpos));
+    put(&Pquality, sizeof(Pquality));
+
+    //the spectrum comes from the oscillator (and resonance)
+    XMLwrapper xml;
+    xml.beginbranch("OSCIL");
+    oscilgen->add2XML(xml);
+    xml.endbranch();
+    xml.beginbranch("RESONANCE");
+    resonance->add2XML(xml);
+    xml.endbranch();
+    char *data = xml.getXMLdata();
+    key += data;
+    free(data);
+    return key;
+}
+
 void PADnoteParameters::export2wav(std::string basefilename)
 {
     applyparameters();
@@ -175,6 +175,21 @@ class PADnoteParameters:public Presets
 
         //! RT sample data
         Sample sample[PAD_MAX_SAMPLES];
+        //! Samples replaced last, PADnote crossfades from them to the new ones
+        //! during the next buffer it renders
+        Sample prevsample[PAD_MAX_SAMPLES];
+        //! Whether prevsample holds samples to free after this buffer
+        bool prevpending;
+
+        //! Send the replaced samples to be freed. Called after the notes
+        //! rendered the buffer following the replacement.
+        void releaseprevsamples(rtosc::ThreadLink &link);
+
+        //! Samples repeated at the end of each table for the interpolation
+        static constexpr int extra_samples = 5;
+
+        //! Everything the samples are generated from (the sample cache key)
+        std::string sampleFingerprint(void) const;
 
         //! callback type for sampleGenerator
         typedef std::function<void(int,PADnoteParameters::Sample&&)> callback;
@@ -188,11 +203,14 @@ class PADnoteParameters:public Presets
         //! @param do_abort Function that decides whether the calculation should
         //!                 be aborted (probably because of interruptions by the
         //!                 user)
-        //! @param max_threads Maximum number of threads for computation, or
-        //!                    zero if no maximum shall be set
+        //! @param max_threads 1 computes all samples on the calling thread,
+        //!                    otherwise the PadGenPool of the process is used
+        //!                    (if there is one)
+        //! @param cached false bypasses the PadSampleCache (e.g. previews)
         int sampleGenerator(PADnoteParameters::callback cb,
                             std::function<bool()> do_abort,
-                            unsigned max_threads = 0);
+                            unsigned max_threads = 0,
+                            bool cached = true);
 
         const AbsTime *time;
         int64_t last_update_timestamp;
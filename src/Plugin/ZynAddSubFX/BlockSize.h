@@ -0,0 +1,46 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BlockSize.h - Internal block size and latency of the plugin
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+// Largest internal block. The output is computed one internal block ahead
+// and events other than note-ons take effect between blocks, so larger
+// blocks would add latency and make the controls coarser.
+static const uint32_t kMaxBlockSize = 128;
+
+// Internal block size for a host block: the largest divisor of the host
+// block up to kMaxBlockSize, so that every run() computes the same number
+// of internal blocks. Host blocks without a reasonable divisor use blocks
+// of kMaxBlockSize frames, which some run() calls compute one more of.
+static inline int internalBufferSize(uint32_t hostBufferSize)
+{
+    const uint32_t maxBlock = std::min(hostBufferSize, kMaxBlockSize);
+
+    for (uint32_t n = maxBlock; n >= 16; --n)
+        if (hostBufferSize % n == 0)
+            return static_cast<int>(n);
+
+    return static_cast<int>(maxBlock > 0 ? maxBlock : kMaxBlockSize);
+}
+
+// Latency reported to the host, in frames of the host rate: the output of
+// an event starts one internal block (at the internal rate) later.
+static inline uint32_t internalLatency(int bufferSize, unsigned internalRate,
+                                       unsigned hostRate)
+{
+    if (internalRate == 0)
+        return 0;
+    return static_cast<uint32_t>(
+        (static_cast<uint64_t>(bufferSize) * hostRate + internalRate - 1)
+        / internalRate);
+}
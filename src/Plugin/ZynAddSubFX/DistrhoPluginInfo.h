@@ -15,8 +15,14 @@
 #define DISTRHO_PLUGIN_INFO_H_INCLUDED
 
 #define DISTRHO_PLUGIN_BRAND "ZynAddSubFX"
-#define DISTRHO_PLUGIN_NAME  "ZynAddSubFX"
-#define DISTRHO_PLUGIN_URI   "http://zynaddsubfx.sourceforge.net"
+#if defined(ZYN_MULTI_OUT)
+ // variant with a stereo output per part next to the main mix
+ #define DISTRHO_PLUGIN_NAME  "ZynAddSubFX Multi"
+ #define DISTRHO_PLUGIN_URI   "http://zynaddsubfx.sourceforge.net/multi"
+#else
+ #define DISTRHO_PLUGIN_NAME  "ZynAddSubFX"
+ #define DISTRHO_PLUGIN_URI   "http://zynaddsubfx.sourceforge.net"
+#endif
 
 #if defined(NTK_GUI)
  #define DISTRHO_PLUGIN_HAS_UI          1
@@ -38,11 +44,16 @@
 #define DISTRHO_PLUGIN_IS_RT_SAFE       1
 #define DISTRHO_PLUGIN_IS_SYNTH         1
 #define DISTRHO_PLUGIN_NUM_INPUTS       0
-#define DISTRHO_PLUGIN_NUM_OUTPUTS      2
+#if defined(ZYN_MULTI_OUT)
+ #define DISTRHO_PLUGIN_NUM_OUTPUTS     34 // 2 + 2 * NUM_MIDI_PARTS
+#else
+ #define DISTRHO_PLUGIN_NUM_OUTPUTS     2
+#endif
 #define DISTRHO_PLUGIN_WANT_PROGRAMS    1
 #define DISTRHO_PLUGIN_WANT_STATE       1
 #define DISTRHO_PLUGIN_WANT_FULL_STATE  1
 #define DISTRHO_PLUGIN_WANT_TIMEPOS     1
+#define DISTRHO_PLUGIN_WANT_LATENCY     1
 #define DISTRHO_PLUGIN_MINIMUM_BUFFER_SIZE 131072
 
 enum Parameters {
@@ -63,6 +74,12 @@ enum Parameters {
     kParamSlot15,
     kParamSlot16,
     kParamOscPort,
+    kParamDroppedBuffers,
+#if defined(ZYN_MULTI_OUT)
+    // the part is left out of the main mix, it is only on its own output
+    kParamSeparate1,
+    kParamSeparate16 = kParamSeparate1 + 15,
+#endif
     kParamCount
 };
 
@@ -20,6 +20,7 @@
 #include "Misc/MiddleWare.h"
 #include "Misc/Part.h"
 #include "Misc/Util.h"
+#include "BlockSize.h"
 
 // Extra includes
 #include "extra/Mutex.hpp"
@@ -28,6 +29,17 @@
 
 #include <lo/lo.h>
 #include <rtosc/thread-link.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#if defined(ZYN_MULTI_OUT)
+static_assert(DISTRHO_PLUGIN_NUM_OUTPUTS == 2 + 2 * NUM_MIDI_PARTS,
+              "one stereo output per part");
+static const bool kPartOutputs = true;
+#else
+static const bool kPartOutputs = false;
+#endif
 
 /* ------------------------------------------------------------------------------------------------------------
  * MiddleWare thread class */
@@ -114,17 +126,21 @@ public:
           middleware(nullptr),
           defaultState(nullptr),
           oscPort(0),
+          hostRate(static_cast<uint>(getSampleRate())),
+          droppedBuffers(0),
+          separateOut(),
           middlewareThread(new MiddleWareThread())
     {
-        synth.buffersize = static_cast<int>(getBufferSize());
-        synth.samplerate = static_cast<uint>(getSampleRate());
-
-        if (synth.buffersize > 32)
-            synth.buffersize = 32;
+        // Notes start at their exact frame within a block (see
+        // Master::setEventOffset()), so the internal blocks can be larger
+        // than the former 32 frames without making note-ons late
+        synth.buffersize = internalBufferSize(getBufferSize());
+        synth.samplerate = hostRate;
 
         synth.alias();
 
         _initMaster();
+        _setLatency();
 
         defaultState = _getState();
 
@@ -147,7 +163,7 @@ protected:
     */
     const char* getLabel() const noexcept override
     {
-        return "ZynAddSubFX";
+        return kPartOutputs ? "ZynAddSubFXMulti" : "ZynAddSubFX";
     }
 
    /**
@@ -201,9 +217,36 @@ protected:
     */
     int64_t getUniqueId() const noexcept override
     {
-        return d_cconst('Z', 'A', 'S', 'F');
+        return kPartOutputs ? d_cconst('Z', 'A', 'S', 'M')
+                            : d_cconst('Z', 'A', 'S', 'F');
     }
 
+#if defined(ZYN_MULTI_OUT)
+   /**
+      Initialize the audio port @a index.
+      The main mix comes first, followed by a stereo pair per part.
+    */
+    void initAudioPort(bool input, uint32_t index, AudioPort& port) override
+    {
+        if (input)
+            return Plugin::initAudioPort(input, index, port);
+
+        const char* const side = index % 2 ? "Right" : "Left";
+        const char* const sym  = index % 2 ? "_r" : "_l";
+        if (index < 2)
+        {
+            port.name   = (std::string("Main ") + side).c_str();
+            port.symbol = (std::string("main") + sym).c_str();
+        }
+        else
+        {
+            const std::string npart = zyn::to_s((index - 2) / 2 + 1);
+            port.name   = ("Part " + npart + " " + side).c_str();
+            port.symbol = ("part" + npart + sym).c_str();
+        }
+    }
+#endif
+
    /* --------------------------------------------------------------------------------------------------------
     * Parameters, empty for now */
 
@@ -224,6 +267,15 @@ protected:
             parameter.ranges.max = 999999.0f;
             parameter.ranges.def = 0.0f;
             break;
+        case kParamDroppedBuffers:
+            parameter.hints  = kParameterIsOutput | kParameterIsInteger;
+            parameter.name   = "Dropped Buffers";
+            parameter.symbol = "dropped_buffers";
+            parameter.unit   = "";
+            parameter.ranges.min = 0.0f;
+            parameter.ranges.max = 16777216.0f;
+            parameter.ranges.def = 0.0f;
+            break;
         }
         if(index <= kParamSlot16) {
             parameter.hints  = kParameterIsAutomable;
@@ -234,6 +286,18 @@ protected:
             parameter.ranges.max = 1.0f;
             parameter.ranges.def = 0.5f;
         }
+#if defined(ZYN_MULTI_OUT)
+        if(index >= kParamSeparate1 && index <= kParamSeparate16) {
+            const std::string npart = zyn::to_s(index - kParamSeparate1 + 1);
+            parameter.hints  = kParameterIsAutomable | kParameterIsBoolean;
+            parameter.name   = ("Part " + npart + " Separate").c_str();
+            parameter.symbol = ("part" + npart + "_separate").c_str();
+            parameter.unit   = "";
+            parameter.ranges.min = 0.0f;
+            parameter.ranges.max = 1.0f;
+            parameter.ranges.def = 0.0f;
+        }
+#endif
     }
 
    /**
@@ -246,10 +310,16 @@ protected:
         {
         case kParamOscPort:
             return oscPort;
+        case kParamDroppedBuffers:
+            return droppedBuffers;
         }
         if(index <= kParamSlot16) {
             return master->automate.getSlot(index - kParamSlot1);
         }
+#if defined(ZYN_MULTI_OUT)
+        if(index >= kParamSeparate1 && index <= kParamSeparate16)
+            return separateOut[index - kParamSeparate1] ? 1.0f : 0.0f;
+#endif
         return 0.0f;
     }
 
@@ -263,6 +333,13 @@ protected:
     {
         if(index <= kParamSlot16)
             master->automate.setSlot(index - kParamSlot1, value);
+#if defined(ZYN_MULTI_OUT)
+        if(index >= kParamSeparate1 && index <= kParamSeparate16) {
+            const int npart = index - kParamSeparate1;
+            separateOut[npart] = value > 0.5f;
+            master->separateOut[npart] = separateOut[npart];
+        }
+#endif
     }
 
    /* --------------------------------------------------------------------------------------------------------
@@ -318,19 +395,15 @@ protected:
     void setState(const char* key, const char* value) override
     {
         const MiddleWareThread::ScopedStopper mwss(*middlewareThread);
-        const MutexLocker cml(mutex);
 
         if(key && strlen(key) > 1000 && (!value || strlen(value) < 1000)) {
             //Loading a Jackoo VST File
             value = key;
         }
 
-        master->defaults();
-        master->putalldata(value);
-        master->applyparameters();
-        master->initialize_rt();
-
-        middleware->updateResources(master);
+        // The state goes into a new master, which run() switches to at
+        // the start of a buffer, so the audio is not interrupted
+        middleware->loadMasterData(value);
     }
 
    /* --------------------------------------------------------------------------------------------------------
@@ -347,12 +420,15 @@ protected:
         const TimePosition& timePosition = getTimePosition();
 
 
+        // Only taken while the master is rebuilt, which hosts should not
+        // do while running
         if (! mutex.tryLock())
         {
             //if (! isOffline())
             {
-                std::memset(outputs[0], 0, sizeof(float)*frames);
-                std::memset(outputs[1], 0, sizeof(float)*frames);
+                ++droppedBuffers;
+                for (uint32_t i=0; i<DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+                    std::memset(outputs[i], 0, sizeof(float)*frames);
                 return;
             }
             mutex.lock();
@@ -373,9 +449,12 @@ protected:
 
             if (midiEvent.frame > framesOffset)
             {
-                master->GetAudioOutSamples(midiEvent.frame-framesOffset, synth.samplerate,
+                master->GetAudioOutSamples(midiEvent.frame-framesOffset, hostRate,
                                                                          outputs[0]+framesOffset,
-                                                                         outputs[1]+framesOffset);
+                                                                         outputs[1]+framesOffset,
+                                                                         0, 0, 0.0f, 0.0f, 0.0f,
+                                                                         0.0f, 0.0f, false, 0,
+                                                                         _partOutputs(outputs, framesOffset));
 
                 framesOffset = midiEvent.frame;
             }
@@ -450,7 +529,7 @@ protected:
         }
 
         if (timePosition.bbt.valid)
-            master->GetAudioOutSamples(frames-framesOffset, synth.samplerate,
+            master->GetAudioOutSamples(frames-framesOffset, hostRate,
                                                                  outputs[0]+framesOffset,
                                                                  outputs[1]+framesOffset,
                                                                  timePosition.bbt.bar,
@@ -461,12 +540,16 @@ protected:
                                                                  timePosition.bbt.beatsPerMinute,
                                                                  timePosition.bbt.ticksPerBeat,
                                                                  timePosition.playing,
-                                                                 frames);
+                                                                 frames,
+                                                                 _partOutputs(outputs, framesOffset));
 
         else
-            master->GetAudioOutSamples(frames-framesOffset, synth.samplerate,
+            master->GetAudioOutSamples(frames-framesOffset, hostRate,
                                                                  outputs[0]+framesOffset,
-                                                                 outputs[1]+framesOffset);
+                                                                 outputs[1]+framesOffset,
+                                                                 0, 0, 0.0f, 0.0f, 0.0f,
+                                                                 0.0f, 0.0f, false, 0,
+                                                                 _partOutputs(outputs, framesOffset));
 
         mutex.unlock();
     }
@@ -482,20 +565,30 @@ protected:
     */
     void bufferSizeChanged(uint32_t newBufferSize) override
     {
+        // GetAudioOutSamples() hands out the internal blocks in pieces of
+        // any size, so they only need to change if they no longer fit into
+        // a host block a whole number of times (a larger block would make
+        // some run() calls compute much more than others).
+        // Everything else keeps running without rebuilding the Master.
+        if (newBufferSize == 0 ||
+            newBufferSize % static_cast<uint32_t>(synth.buffersize) == 0 ||
+            internalBufferSize(newBufferSize) == synth.buffersize)
+            return;
+
         MiddleWareThread::ScopedStopper mwss(*middlewareThread);
+        const MutexLocker cml(mutex);
 
         char* const state(_getState());
 
         _deleteMaster();
 
-        synth.buffersize = static_cast<int>(newBufferSize);
-
-        if (synth.buffersize > 32)
-            synth.buffersize = 32;
-
+        synth.buffersize = internalBufferSize(newBufferSize);
         synth.alias();
 
+        // the state is loaded into the new Master, which generates the
+        // PADsynth samples again
         _initMaster();
+        _setLatency();
         mwss.updateMiddleWare(middleware);
 
         setState(nullptr, state);
@@ -508,20 +601,15 @@ protected:
     */
     void sampleRateChanged(double newSampleRate) override
     {
-        MiddleWareThread::ScopedStopper mwss(*middlewareThread);
-
-        char* const state(_getState());
-
-        _deleteMaster();
-
-        synth.samplerate = static_cast<uint>(newSampleRate);
-        synth.alias();
-
-        _initMaster();
-        mwss.updateMiddleWare(middleware);
+        // The engine keeps running at the rate it was created with and the
+        // Master converts its output, so neither the Master nor the PADsynth
+        // samples have to be rebuilt
+        const MiddleWareThread::ScopedStopper mwss(*middlewareThread);
+        const MutexLocker cml(mutex);
 
-        setState(nullptr, state);
-        std::free(state);
+        hostRate = static_cast<uint>(newSampleRate);
+        _setOutputRate();
+        _setLatency();
     }
 
 private:
@@ -533,6 +621,10 @@ private:
     Mutex mutex;
     char* defaultState;
     int   oscPort;
+    uint  hostRate; // rate of run(), synth.samplerate is the internal one
+    std::atomic<uint32_t> droppedBuffers; // run() calls which output silence
+    bool   separateOut[NUM_MIDI_PARTS];     // see zyn::Master::separateOut
+    float* partOutputs[2*NUM_MIDI_PARTS];
 
     ScopedPointer<MiddleWareThread> middlewareThread;
 
@@ -540,8 +632,10 @@ private:
     {
         const MiddleWareThread::ScopedStopper mwss(*middlewareThread);
 
+        // the master of the MiddleWare includes a state which run() has
+        // not switched to yet
         char* data = nullptr;
-        master->getalldata(&data);
+        middleware->spawnMaster()->getalldata(&data);
         return data;
     }
 
@@ -551,6 +645,7 @@ private:
         middleware->setUiCallback(0, __uiCallback, this);
         middleware->setIdleCallback(__idleCallback, this);
         _masterChangedCallback(middleware->spawnMaster());
+        _setOutputRate();
 
         if (char* portStr = middleware->getServerPort())
         {
@@ -563,8 +658,34 @@ private:
         }
     }
 
+    void _setLatency()
+    {
+        setLatency(internalLatency(synth.buffersize, synth.samplerate, hostRate));
+    }
+
+    void _setOutputRate()
+    {
+        master->setOutputRate(hostRate, kPartOutputs);
+        if (master != middleware->spawnMaster())
+            middleware->spawnMaster()->setOutputRate(hostRate, kPartOutputs);
+    }
+
+    // the part outputs from frame on, if the plugin has them
+    float** _partOutputs(float** outputs, uint32_t frame)
+    {
+        if (! kPartOutputs)
+            return nullptr;
+        for (int i=0; i<2*NUM_MIDI_PARTS; ++i)
+            partOutputs[i] = outputs[2+i] + frame;
+        return partOutputs;
+    }
+
     void _deleteMaster()
     {
+        // a master replaced by setState() belongs to the MiddleWare only
+        // once run() switched away from it
+        if (master != middleware->spawnMaster())
+            delete master;
         master = nullptr;
         delete middleware;
         middleware = nullptr;
@@ -576,6 +697,7 @@ private:
     void _masterChangedCallback(zyn::Master* m)
     {
         master = m;
+        std::copy(separateOut, separateOut + NUM_MIDI_PARTS, master->separateOut);
         master->setMasterChangedCallback(__masterChangedCallback, this);
     }
 
@@ -28,10 +28,15 @@
 #include "ModFilter.h"
 #include "OscilGen.h"
 #include "ADnote.h"
+#include "UnisonKernels.h"
 
 #define LENGTHOF(x) ((int)(sizeof(x)/sizeof(x[0])))
 
 namespace zyn {
+
+//Fastest unison kernels of this CPU
+static const UnisonKernels &unisonKernels = UnisonKernels::best();
+
 ADnote::ADnote(ADnoteParameters *pars_, const SynthParams &spars,
                WatchManager *wm, const char *prefix, bool constPowerMixing)
     :SynthNote(spars, constPowerMixing), watch_be4_add(wm, prefix, "noteout/be4_mix"), watch_after_add(wm,prefix,"noteout/after_mix"),
@@ -111,6 +116,7 @@ void ADnote::setupVoice(int nvoice)
 
     param.OscilGn->newrandseed(prng());
     voice.OscilSmp = NULL;
+    voice.OscilMip = NULL;
     voice.FMSmp    = NULL;
     voice.VoiceOut = NULL;
 
@@ -197,6 +203,9 @@ void ADnote::setupVoice(int nvoice)
     for(int i = 0; i < OSCIL_SMP_EXTRA_SAMPLES; ++i)
         voice.OscilSmp[synth.oscilsize + i] = voice.OscilSmp[i];
 
+    if(voice.AAEnabled && param.PAAType == 1 && param.Type == 0)
+        setupVoiceMipmap(nvoice, vc);
+
     voice.phase_offset = (int)((pars.VoicePar[nvoice].Poscilphase
                     - 64.0f) / 128.0f * synth.oscilsize + synth.oscilsize * 4);
     oscposhi_start += NoteVoicePar[nvoice].phase_offset;
@@ -240,6 +249,58 @@ void ADnote::setupVoice(int nvoice)
                     - 1.0f) / synth.buffersize_f / 10.0f * synth.samplerate_f);
 }
 
+void ADnote::setupVoiceMipmap(int nvoice, int vc)
+{
+    auto &voice = NoteVoicePar[nvoice];
+    const int   half  = synth.oscilsize / 2;
+    const float freq  = getvoicebasefreq(nvoice);
+    const float speed = freq * synth.oscilsize_f / synth.samplerate_f;
+
+    //OscilGen::get() already cut the harmonics above Nyquist of the base
+    //frequency, the levels which keep more are the same as OscilSmp
+    const int harmonics = std::min((int)(synth.halfsamplerate_f / freq), half);
+
+    int levels = 1;
+    while((half >> levels) >= 1)
+        ++levels;
+    int first = 0;
+    while(first < levels - 1 && (half >> first) >= harmonics)
+        ++first;
+    int last = (int)ceilf(log2f(speed)) + ADNOTE_MIP_OCTAVES;
+    last = std::min(last, levels - 1);
+    if(last < first)
+        return;
+
+    //The levels are copied from the band tables, which are made outside of
+    //the realtime thread. Oscillators without them use the sinc kernel.
+    OscilGen &oscil = *pars.VoicePar[vc].OscilGn;
+    const int resonance = pars.VoicePar[nvoice].Presonance;
+    if(!oscil.hasmipmaps(freq, resonance))
+        return;
+
+    //Each table is owned by the voice as soon as it is allocated, so kill()
+    //frees them if an allocation fails
+    float **mip = memory.valloc<float*>(levels);
+    voice.OscilMip  = mip;
+    voice.miplevels = levels;
+    voice.mipfirst  = first;
+    voice.miplast   = first - 1;
+    for(int l = first; l <= last; ++l) {
+        mip[l] = memory.valloc<float>(synth.oscilsize + OSCIL_SMP_EXTRA_SAMPLES);
+        voice.miplast = l;
+    }
+    for(int l = 0; l < first; ++l)
+        mip[l] = voice.OscilSmp;
+    for(int l = last + 1; l < levels; ++l)
+        mip[l] = mip[last];
+
+    oscil.getmipmaps(mip + first, last - first + 1, half >> first, freq,
+                     resonance);
+    for(int l = first; l <= last; ++l)
+        for(int i = 0; i < OSCIL_SMP_EXTRA_SAMPLES; ++i)
+            mip[l][synth.oscilsize + i] = mip[l][i];
+}
+
 int ADnote::setupVoiceUnison(int nvoice)
 {
     auto &voice = NoteVoicePar[nvoice];
@@ -1209,46 +1270,15 @@ inline void ADnote::fadein(float *smps) const
 
 /*
  * Computes the Oscillator (Without Modulation) - LinearInterpolation
- */
-
-/* As the code here is a bit odd due to optimization, here is what happens
- * First the current position and frequency are retrieved from the running
- * state. These are broken up into high and low portions to indicate how many
- * samples are skipped in one step and how many fractional samples are skipped.
- * Outside of this method the fractional samples are just handled with floating
- * point code, but that's a bit slower than it needs to be. In this code the low
- * portions are known to exist between 0.0 and 1.0 and it is known that they are
- * stored in single precision floating point IEEE numbers. This implies that
- * a maximum of 24 bits are significant. The below code does your standard
- * linear interpolation that you'll see throughout this codebase, but by
- * sticking to integers for tracking the overflow of the low portion, around 15%
- * of the execution time was shaved off in the ADnote test.
+ * (see UnisonKernels.cpp for the fixed point phase tracking)
  */
 inline void ADnote::ComputeVoiceOscillator_LinearInterpolation(int nvoice)
 {
     Voice& vce = NoteVoicePar[nvoice];
-    for(int k = 0; k < vce.unison_size; ++k) {
-        int    poshi  = vce.oscposhi[k];
-        // convert floating point fractional part (sample interval phase)
-        // with range [0.0 ... 1.0] to fixed point with 1 digit is 2^-24
-        // by multiplying with precalculated 2^24 and casting to integer:
-        int    poslo  = (int)(vce.oscposlo[k] * 16777216.0f);
-        int    freqhi = vce.oscfreqhi[k];
-        // same for phase increment:
-        int    freqlo = (int)(vce.oscfreqlo[k] * 16777216.0f);
-        float *smps   = NoteVoicePar[nvoice].OscilSmp;
-        float *tw     = tmpwave_unison[k];
-        assert(vce.oscfreqlo[k] < 1.0f);
-        for(int i = 0; i < synth.buffersize; ++i) {
-            tw[i]  = (smps[poshi] * (0x01000000 - poslo) + smps[poshi + 1] * poslo)/(16777216.0f);
-            poslo += freqlo;                // increment fractional part (sample interval phase)
-            poshi += freqhi + (poslo>>24);  // add overflow over 24 bits in poslo to poshi
-            poslo &= 0xffffff;              // remove overflow from poslo
-            poshi &= synth.oscilsize - 1;   // remove overflow
-        }
-        vce.oscposhi[k] = poshi;
-        vce.oscposlo[k] = poslo/(16777216.0f);
-    }
+    unisonKernels.oscLinear(vce.OscilSmp, synth.oscilsize,
+                            vce.oscposhi, vce.oscposlo,
+                            vce.oscfreqhi, vce.oscfreqlo,
+                            tmpwave_unison, vce.unison_size, synth.buffersize);
 }
 
 
@@ -1347,6 +1377,65 @@ inline void ADnote::ComputeVoiceOscillator_SincInterpolation(int nvoice)
 }
 
 
+/*
+ * Computes the Oscillator (Without Modulation) - mipmapped wavetables
+ *
+ * Level l of the mipmap does not alias up to a speed of 2^l samples. Between
+ * the speeds 2^(l-1) and 2^l each subvoice crossfades from level l to level
+ * l+1 by the octave, so the harmonics which would get above Nyquist fade out
+ * before they do. It needs two linear interpolations per sample instead of
+ * the 38 of the sinc kernel.
+ */
+inline void ADnote::ComputeVoiceOscillator_Mipmap(int nvoice)
+{
+    Voice& vce = NoteVoicePar[nvoice];
+    for(int k = 0; k < vce.unison_size; ++k) {
+        const float speed = vce.oscfreqhi[k] + vce.oscfreqlo[k];
+        const float octave = log2f(speed > 0.0f ? speed : 1e-6f);
+        int   level = (int)ceilf(octave);
+        float fade  = octave - level + 1.0f;
+        if(level < 0) {
+            level = 0;
+            fade  = 0.0f;
+        }
+        if(level >= vce.miplevels - 1) {
+            level = vce.miplevels - 1;
+            fade  = 0.0f;
+        }
+        const float *a = vce.OscilMip[level];
+        const float *b = vce.OscilMip[level + (fade > 0.0f)];
+
+        if(a == b || fade <= 0.0f || fade >= 1.0f) {
+            unisonKernels.oscLinear(fade >= 1.0f ? b : a, synth.oscilsize,
+                                    vce.oscposhi + k, vce.oscposlo + k,
+                                    vce.oscfreqhi + k, vce.oscfreqlo + k,
+                                    tmpwave_unison + k, 1, synth.buffersize);
+            continue;
+        }
+
+        //same fixed point phase as the linear interpolation
+        int    poshi  = vce.oscposhi[k];
+        int    poslo  = (int)(vce.oscposlo[k] * (1<<24));
+        int    freqhi = vce.oscfreqhi[k];
+        int    freqlo = (int)(vce.oscfreqlo[k] * (1<<24));
+        float *tw     = tmpwave_unison[k];
+        assert(vce.oscfreqlo[k] < 1.0f);
+
+        for(int i = 0; i < synth.buffersize; ++i) {
+            const float x0 = a[poshi]     + (b[poshi]     - a[poshi])     * fade;
+            const float x1 = a[poshi + 1] + (b[poshi + 1] - a[poshi + 1]) * fade;
+            tw[i]  = (x0 * ((1<<24) - poslo) + x1 * poslo) / (1.0f*(1<<24));
+            poslo += freqlo;
+            poshi += freqhi + (poslo>>24);
+            poslo &= 0xffffff;
+            poshi &= synth.oscilsize - 1;
+        }
+        vce.oscposhi[k] = poshi;
+        vce.oscposlo[k] = poslo/(1.0f*(1<<24));
+    }
+}
+
+
 /*
  * Computes the Oscillator (Mixing)
  */
@@ -1749,8 +1838,13 @@ inline void ADnote::ComputeVoiceDC(int nvoice)
  */
 int ADnote::noteout(float *outl, float *outr)
 {
-    memcpy(outl, synth.denormalkillbuf, synth.bufferbytes);
-    memcpy(outr, synth.denormalkillbuf, synth.bufferbytes);
+    if(synth.denormalnoise) {
+        memcpy(outl, synth.denormalkillbuf, synth.bufferbytes);
+        memcpy(outr, synth.denormalkillbuf, synth.bufferbytes);
+    } else {
+        memset(outl, 0, synth.bufferbytes);
+        memset(outr, 0, synth.bufferbytes);
+    }
 
     if(NoteEnabled == OFF)
         return 0;
@@ -1789,8 +1883,12 @@ int ADnote::noteout(float *outl, float *outr)
                                                                   NoteVoicePar[nvoice].FMEnabled);
                         break;
                     default:
-                        if(NoteVoicePar[nvoice].AAEnabled)
-                            ComputeVoiceOscillator_SincInterpolation(nvoice);
+                        if(NoteVoicePar[nvoice].AAEnabled) {
+                            if(NoteVoicePar[nvoice].OscilMip)
+                                ComputeVoiceOscillator_Mipmap(nvoice);
+                            else
+                                ComputeVoiceOscillator_SincInterpolation(nvoice);
+                        }
                         else
                             if(NoteVoicePar[nvoice].syncEnabled)
                                 ComputeVoiceOscillatorSync(nvoice);
@@ -1815,8 +1913,9 @@ int ADnote::noteout(float *outl, float *outr)
         memset(tmpwavel, 0, synth.bufferbytes);
         if(stereo)
             memset(tmpwaver, 0, synth.bufferbytes);
+        STACKALLOC(float, unison_lvol, vce.unison_size);
+        STACKALLOC(float, unison_rvol, vce.unison_size);
         for(int k = 0; k < vce.unison_size; ++k) {
-            float *tw = tmpwave_unison[k];
             if(stereo) {
                 float stereo_pos = 0;
                 bool is_pwm = NoteVoicePar[nvoice].FMEnabled == FMTYPE::PW_MOD;
@@ -1867,19 +1966,27 @@ int ADnote::noteout(float *outl, float *outr)
                     lvol = -lvol;
                     rvol = -rvol;
                 }
-
-                for(int i = 0; i < synth.buffersize; ++i)
-                    tmpwavel[i] += tw[i] * lvol;
-                for(int i = 0; i < synth.buffersize; ++i)
-                    tmpwaver[i] += tw[i] * rvol;
+                unison_lvol[k] = lvol;
+                unison_rvol[k] = rvol;
             }
             else
-                for(int i = 0; i < synth.buffersize; ++i)
-                    tmpwavel[i] += tw[i];
-            if(nvoice == 0)
-                watch_be4_add(tmpwavel,synth.buffersize);
+                unison_lvol[k] = unison_rvol[k] = 1.0f;
         }
 
+        float *mixr = stereo ? &tmpwaver[0] : NULL;
+        if(nvoice == 0 && watch_be4_add.is_active())
+            //the watch point sees the mix after each subvoice
+            for(int k = 0; k < vce.unison_size; ++k) {
+                unisonKernels.mix(tmpwave_unison + k, 1, &unison_lvol[k],
+                                  &unison_rvol[k], tmpwavel, mixr,
+                                  synth.buffersize);
+                watch_be4_add(tmpwavel,synth.buffersize);
+            }
+        else
+            unisonKernels.mix(tmpwave_unison, vce.unison_size,
+                              &unison_lvol[0], &unison_rvol[0],
+                              tmpwavel, mixr, synth.buffersize);
+
         float unison_amplitude = 1.0f / sqrtf(vce.unison_size); //reduce the amplitude for large unison sizes
         // Amplitude
         float oldam = vce.oldamplitude * unison_amplitude;
@@ -2102,6 +2209,11 @@ void ADnote::Voice::releasekey()
 void ADnote::Voice::kill(Allocator &memory, const SYNTH_T &synth)
 {
     memory.devalloc(OscilSmp);
+    if(OscilMip) {
+        for(int l = mipfirst; l <= miplast; ++l)
+            memory.devalloc(OscilMip[l]);
+        memory.devalloc(OscilMip);
+    }
     memory.dealloc(FreqEnvelope);
     memory.dealloc(FreqLfo);
     memory.dealloc(AmpEnvelope);
@@ -29,6 +29,10 @@
 
 #define OSCIL_SMP_EXTRA_SAMPLES 5
 
+/**Octaves above the base frequency a voice with mipmapped antialiasing can
+ * play without aliasing (for pitch bends, LFOs and unison)*/
+#define ADNOTE_MIP_OCTAVES 3
+
 namespace zyn {
 
 /**The "additive" synthesizer*/
@@ -60,6 +64,9 @@ class ADnote:public SynthNote
         int  setupVoiceUnison(int nvoice);
         void setupVoiceDetune(int nvoice);
         void setupVoiceMod(int nvoice, bool first_run = true);
+        /**Makes the band limited levels of OscilSmp for the mipmapped
+         * antialiasing of a voice which uses the oscillator vc*/
+        void setupVoiceMipmap(int nvoice, int vc);
         VecWatchPoint watch_be4_add,watch_after_add, watch_punch, watch_legato;
         /**Changes the frequency of an oscillator.
          * @param nvoice voice to run computations on
@@ -89,6 +96,9 @@ class ADnote:public SynthNote
          * Affects tmpwave_unison and updates oscposhi/oscposlo
          * @todo remove this declaration if it is commented out*/
         inline void ComputeVoiceOscillator_SincInterpolation(int nvoice);
+        /**Compute the Oscillator's samples from the mipmap levels.
+         * Affects tmpwave_unison and updates oscposhi/oscposlo*/
+        inline void ComputeVoiceOscillator_Mipmap(int nvoice);
         /**Compute the Oscillator's samples.
          * Affects tmpwave_unison and updates oscposhi/oscposlo
          * @todo remove this declaration if it is commented out*/
@@ -202,6 +212,15 @@ class ADnote:public SynthNote
             /* Range of waveform */
             float OscilSmpMin, OscilSmpMax;
 
+            /* Band limited copies of OscilSmp for the mipmapped antialiasing
+             * (NULL if it is not used or the oscillator has no band tables,
+             * the sinc kernel is used then). Level l keeps the harmonics up to
+             * oscilsize/2^(l+1), so it does not alias up to a speed of 2^l
+             * samples. Levels from mipfirst to miplast have own tables, the
+             * ones below point to OscilSmp and the ones above to miplast */
+            float **OscilMip;
+            int     miplevels, mipfirst, miplast;
+
             /************************************
             *     FREQUENCY PARAMETERS          *
             ************************************/
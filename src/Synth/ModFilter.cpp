@@ -35,6 +35,7 @@ ModFilter::ModFilter(const FilterParams &pars_,
     noteFreq(notefreq),
     left(nullptr),
     right(nullptr),
+    analog(false),
     env(nullptr),
     lfo(nullptr)
 {
@@ -48,6 +49,7 @@ ModFilter::ModFilter(const FilterParams &pars_,
     if(stereo)
         right = Filter::generate(alloc, &pars,
                 synth.samplerate, synth.buffersize);
+    updateStereo();
 }
 
 ModFilter::~ModFilter(void)
@@ -73,6 +75,7 @@ void ModFilter::update(float relfreq, float relq)
         paramUpdate(left);
         if(right)
             paramUpdate(right);
+        updateStereo();
 
         baseFreq = pars.getfreq();
         baseQ    = pars.getq();
@@ -112,12 +115,25 @@ void ModFilter::updateSense(float velocity, uint8_t scale,
 
 void ModFilter::filter(float *l, float *r)
 {
+    if(analog && l && r) {
+        AnalogFilter::filterout(*static_cast<AnalogFilter*>(left),
+                                *static_cast<AnalogFilter*>(right), l, r);
+        return;
+    }
     if(left && l)
         left->filterout(l);
     if(right && r)
         right->filterout(r);
 }
 
+//Checked when the filters are (re)created rather than for every buffer
+void ModFilter::updateStereo(void)
+{
+    analog = left && right
+             && dynamic_cast<AnalogFilter*>(left)
+             && dynamic_cast<AnalogFilter*>(right);
+}
+
 static unsigned current_category(Filter *f)
 {
     if(dynamic_cast<AnalogFilter*>(f))
@@ -43,6 +43,7 @@ class ModFilter
         void filter(float *l, float *r);
     private:
         void paramUpdate(Filter *&f);
+        void updateStereo(void);
         void svParamUpdate(SVFilter &sv);
         void anParamUpdate(AnalogFilter &an);
         void mgParamUpdate(MoogFilter &mg);
@@ -64,6 +65,7 @@ class ModFilter
 
         Filter       *left; //left  channel filter
         Filter       *right;//right channel filter
+        bool          analog;//both channels are analog filters
         Envelope     *env;  //center freq envelope
         LFO          *lfo;  //center freq lfo
 };
@@ -22,6 +22,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstddef>
+#include <cstring>
 #include <complex>
 
 #include <unistd.h>
@@ -32,6 +33,15 @@
 namespace zyn {
 
 
+//Hand prepared freqs and their band tables to the realtime side
+static void chainPrepared(const OscilGen &o, rtosc::RtData &d,
+                          const char *path, FFTfreqBuffer freqs)
+{
+    OscilBands *bands = o.makeBands(freqs);
+    d.chain(path, "bb", sizeof(fft_t*), &freqs.data,
+            sizeof(OscilBands*), &bands);
+}
+
 #define rObject OscilGen
 const rtosc::Ports OscilGen::non_realtime_ports = {
     rSelf(OscilGen),
@@ -125,7 +135,7 @@ const rtosc::Ports OscilGen::non_realtime_ports = {
                 OscilGenBuffers& bfrs = o.myBuffers();
                 o.prepare(bfrs, freqs);
                 // fprintf(stderr, "sending '%p' of fft data\n", data);
-                d.chain(repath, "b", sizeof(fft_t*), &freqs.data);
+                chainPrepared(o, d, repath, freqs);
                 bfrs.pendingfreqs = freqs.data;
                 d.broadcast(d.loc, "i", phase);
             }
@@ -154,7 +164,7 @@ const rtosc::Ports OscilGen::non_realtime_ports = {
                 OscilGenBuffers& bfrs = o.myBuffers();
                 o.prepare(bfrs, freqs);
                 // fprintf(stderr, "sending '%p' of fft data\n", data);
-                d.chain(repath, "b", sizeof(fft_t*), &freqs.data);
+                chainPrepared(o, d, repath, freqs);
                 bfrs.pendingfreqs = freqs.data;
                 d.broadcast(d.loc, "i", mag);
             }
@@ -195,7 +205,7 @@ const rtosc::Ports OscilGen::non_realtime_ports = {
                 FFTfreqBuffer freqs = obj->fft->allocFreqBuf();
                 OscilGenBuffers& bfrs = obj->myBuffers();
                 obj->prepare(bfrs, freqs);
-                data.chain(repath, "b", sizeof(fft_t*), &freqs.data);
+                chainPrepared(*obj, data, repath, freqs);
                 bfrs.pendingfreqs = freqs.data;
                 data.broadcast(loc, "b", bufsize*sizeof(float), buf);
             }
@@ -219,7 +229,7 @@ const rtosc::Ports OscilGen::non_realtime_ports = {
             memset(smps.data, 0, n);
             ((OscilGen*)d.obj)->getcurrentbasefunction(smps);
             d.reply(d.loc, "b", n, smps.data);
-            delete[] smps.data;
+            FFT_freeBuffer(smps.data);
         }},
     {"prepare:", rProp(non-realtime) rDoc("Performs setup operation to oscillator"),
         NULL, [](const char *, rtosc::RtData &d) {
@@ -229,7 +239,7 @@ const rtosc::Ports OscilGen::non_realtime_ports = {
             OscilGenBuffers& bfrs = o.myBuffers();
             o.prepare(bfrs, freqs);
             // fprintf(stderr, "sending '%p' of fft data\n", data);
-            d.chain(d.loc, "b", sizeof(fft_t*), &freqs.data);
+            chainPrepared(o, d, d.loc, freqs);
             bfrs.pendingfreqs = freqs.data;
         }},
     {"convert2sine:", rProp(non-realtime) rDoc("Translates waveform into FS"),
@@ -306,6 +316,21 @@ const rtosc::Ports OscilGen::realtime_ports{
             d.reply("/free", "sb", "fft_t", sizeof(void*), &bfrs.oscilFFTfreqs.data);
             assert(bfrs.oscilFFTfreqs.data !=*(fft_t**)rtosc_argument(m,0).b.data);
             bfrs.oscilFFTfreqs.data = *(fft_t**)rtosc_argument(m,0).b.data;
+            bfrs.bandsvalid = false;
+        }},
+    {"prepare:bb", rProp(internal) rProp(realtime) rProp(pointer)
+        rDoc("Sets prepared fft data and its band tables"),
+        NULL, [](const char *m, rtosc::RtData &d) {
+            OscilGen &o = *(OscilGen*)d.obj;
+            OscilGenBuffers& bfrs = o.myBuffers();
+            assert(rtosc_argument(m,0).b.len == sizeof(void*));
+            assert(rtosc_argument(m,1).b.len == sizeof(void*));
+            d.reply("/free", "sb", "fft_t", sizeof(void*), &bfrs.oscilFFTfreqs.data);
+            if(bfrs.bands)
+                d.reply("/free", "sb", "OscilBands", sizeof(void*), &bfrs.bands);
+            bfrs.oscilFFTfreqs.data = *(fft_t**)rtosc_argument(m,0).b.data;
+            bfrs.bands      = *(OscilBands**)rtosc_argument(m,1).b.data;
+            bfrs.bandsvalid = bfrs.bands;
         }},
 
 };
@@ -405,6 +430,7 @@ OscilGenBuffers::OscilGenBuffers(zyn::OscilGenBuffersCreator c) :
     // fft_ can be nullptr in case of pasting
     oscilFFTfreqs(ctorAllocFreqs(c.fft, c.oscilsize)),
     pendingfreqs(oscilFFTfreqs.data),
+    bands(nullptr),
     tmpsmps(ctorAllocSamples(c.fft, c.oscilsize)),
     outoscilFFTfreqs(ctorAllocFreqs(c.fft, c.oscilsize)),
     cachedbasefunc(ctorAllocSamples(c.fft, c.oscilsize)),
@@ -417,12 +443,13 @@ OscilGenBuffers::OscilGenBuffers(zyn::OscilGenBuffersCreator c) :
 
 OscilGenBuffers::~OscilGenBuffers()
 {
-    delete[] tmpsmps.data;
-    delete[] outoscilFFTfreqs.data;
-    delete[] basefuncFFTfreqs.data;
-    delete[] oscilFFTfreqs.data;
-    delete[] cachedbasefunc.data;
-    delete[] scratchFreqs.data;
+    FFT_freeBuffer(tmpsmps.data);
+    FFT_freeBuffer(outoscilFFTfreqs.data);
+    FFT_freeBuffer(basefuncFFTfreqs.data);
+    FFT_freeBuffer(oscilFFTfreqs.data);
+    FFT_freeBuffer(cachedbasefunc.data);
+    FFT_freeBuffer(scratchFreqs.data);
+    delete bands;
 }
 
 zyn::OscilGenBuffersCreator OscilGen::createOscilGenBuffers() const
@@ -454,6 +481,7 @@ void OscilGenBuffers::defaults()
 
     clearAll(oscilFFTfreqs.data, oscilsize);
     clearAll(basefuncFFTfreqs.data, oscilsize);
+    bandsvalid    = false;
     oscilprepared = 0;
     oldfilterpars = 0;
     oldsapars     = 0;
@@ -540,6 +568,7 @@ void OscilGen::convert2sine()
         FFTsampleBuffer oscil = fft->allocSampleBuf();
         get(oscil.data, -1.0f);
         fft->smps2freqs_noconst_input(oscil, bfrs.scratchFreqs);
+        FFT_freeBuffer(oscil.data);
         delete (fft);
     }
 
@@ -909,6 +938,7 @@ void OscilGen::shiftharmonics(fft_t *freqs) const
  */
 void OscilGen::prepare(OscilGenBuffers& bfrs) const
 {
+    bfrs.bandsvalid = false;
     prepare(bfrs, bfrs.oscilFFTfreqs);
 }
 
@@ -1149,6 +1179,13 @@ short int OscilGen::get(OscilGenBuffers& bfrs, float* smps, float freqHz, int re
                - 1.0f) * synth.oscilsize_f * (Prand - 64.0f) / 64.0f);
     outpos = (outpos + 2 * synth.oscilsize) % synth.oscilsize;
 
+    //The output does not change between notes of one band
+    const int band = cachedBand(bfrs, freqHz, resonance);
+    if(band >= 0) {
+        memcpy(smps, bfrs.bands->table(band), synth.oscilsize * sizeof(float));
+        sprng(realrnd + 1);
+        return Prand < 64 ? outpos : 0;
+    }
 
     clearAll(bfrs.outoscilFFTfreqs.data, synth.oscilsize);
 
@@ -1232,6 +1269,128 @@ short int OscilGen::get(OscilGenBuffers& bfrs, float* smps, float freqHz, int re
         return 0;
 }
 
+int OscilGen::cachedBand(const OscilGenBuffers& bfrs, float freqHz,
+                         int resonance) const
+{
+    if(!bfrs.bands || !bfrs.bandsvalid || ADvsPAD || freqHz <= 0.1f)
+        return -1;
+    if(Prand > 64 || Pamprandtype != 0 || Padaptiveharmonics != 0)
+        return -1;
+    if(resonance != 0 && res->Penabled)
+        return -1;
+    return bfrs.bands->band(freqHz);
+}
+
+/*
+ * Make the outputs of get() for all bands, like get() without randomness
+ */
+OscilBands *OscilGen::makeBands(const FFTfreqBuffer freqs) const
+{
+    if(!fft || ADvsPAD)
+        return nullptr;
+
+    //Below basefreq get() keeps all harmonics, above the last band it keeps
+    //at most the fundamental
+    const int   half      = synth.oscilsize / 2;
+    const float basefreq  = 0.5f * synth.samplerate_f / (half - 2);
+    const int   semitones =
+        (int)(12.0f * log2f(0.5f * synth.samplerate_f / basefreq)) + 1;
+
+    //Bound the memory of the tables, wider bands only lose the harmonics
+    //within a few semitones of Nyquist
+    const int maxbands = std::max(12, OSCIL_BANDS_SAMPLES / synth.oscilsize);
+    const int step     = std::max(1, (semitones - 1 + maxbands - 2)
+                                     / (maxbands - 1));
+    const int nbands   = (semitones - 1 + step - 1) / step + 1;
+    OscilBands *bands  =
+        new OscilBands(basefreq, step, nbands, synth.oscilsize);
+
+    FFTfreqBuffer   out     = fft->allocFreqBuf();
+    FFTfreqBuffer   scratch = fft->allocFreqBuf();
+    FFTsampleBuffer smps    = fft->allocSampleBuf();
+    for(int b = 0; b < nbands; ++b) {
+        const float top = basefreq * powf(2.0f, b * step / 12.0f);
+        int nyquist = (int)(0.5f * synth.samplerate_f / top) + 2;
+        if(b == 0 || nyquist > half)
+            nyquist = half;
+
+        clearAll(out.data, synth.oscilsize);
+        float sum = 0.0f;
+        for(int i = 1; i < nyquist - 1; ++i) {
+            out[i] = freqs[i];
+            sum   += normal(out.data, i);
+        }
+        rmsNormalize(out.data, synth.oscilsize);
+        bands->harmonics[b] = nyquist - 2;
+        bands->rms[b]       = sum < 0.000001f ? 1.0f : sqrtf(sum);
+
+        fft->freqs2smps(out, smps, scratch);
+        float *table = bands->table(b);
+        for(int i = 0; i < synth.oscilsize; ++i)
+            table[i] = smps[i] * 0.25f;
+    }
+    FFT_freeBuffer(out.data);
+    FFT_freeBuffer(scratch.data);
+    FFT_freeBuffer(smps.data);
+
+    return bands;
+}
+
+void OscilGen::updateBands()
+{
+    OscilGenBuffers& bfrs = myBuffers();
+    if(needPrepare(bfrs))
+        prepare(bfrs);
+    delete bfrs.bands;
+    bfrs.bands      = makeBands(bfrs.oscilFFTfreqs);
+    bfrs.bandsvalid = bfrs.bands;
+}
+
+/*
+ * Copy the band tables which keep the harmonics of each level of a mipmap,
+ * scaled like the table of freqHz so the levels can be crossfaded
+ */
+void OscilGen::getmipmaps(OscilGenBuffers& bfrs, float *const *levels,
+                          int nlevels, int maxharmonic, float freqHz,
+                          int resonance) const
+{
+    const int band = cachedBand(bfrs, freqHz, resonance);
+    assert(band >= 0);
+    const OscilBands &bands = *bfrs.bands;
+
+    //the tables keep less harmonics with each band
+    int b = band;
+    for(int l = 0; l < nlevels; ++l) {
+        while(b < bands.nbands - 1 && bands.harmonics[b] > maxharmonic >> l)
+            ++b;
+        const float  gain  = bands.rms[b] / bands.rms[band];
+        const float *table = bands.table(b);
+        for(int i = 0; i < synth.oscilsize; ++i)
+            levels[l][i] = table[i] * gain;
+    }
+}
+
+OscilBands::OscilBands(float basefreq, int step, int nbands, int oscilsize)
+    :basefreq(basefreq), step(step), nbands(nbands), oscilsize(oscilsize),
+     smps(new float[nbands * oscilsize]), harmonics(new int[nbands]),
+     rms(new float[nbands])
+{}
+
+OscilBands::~OscilBands()
+{
+    delete[] smps;
+    delete[] harmonics;
+    delete[] rms;
+}
+
+int OscilBands::band(float freqHz) const
+{
+    if(freqHz <= basefreq)
+        return 0;
+    const int b = (int)ceilf(12.0f * log2f(freqHz / basefreq) / step);
+    return b < nbands ? b : -1;
+}
+
 ///*
 // * Get the oscillator function's harmonics
 // */
@@ -40,6 +40,39 @@ struct OscilGenBuffersCreator
         fft(fft), oscilsize(oscilsize) {}
 };
 
+/**
+ * Outputs of OscilGen::get() for the note frequencies of bands of one or more
+ * semitones
+ *
+ * Without randomness, adaptive harmonics and resonance, get() only depends on
+ * the frequency through the harmonics it cuts for antialiasing. Such
+ * oscillators copy the table of their band at note-on instead of doing an
+ * IFFT. Each table keeps the harmonics below Nyquist for the highest frequency
+ * of its band; band 0 keeps all of them and serves all lower frequencies.
+ * Large oscillators use wider bands to keep all tables within
+ * OSCIL_BANDS_SAMPLES floats.
+ */
+#define OSCIL_BANDS_SAMPLES (1 << 19)
+struct OscilBands
+{
+    OscilBands(float basefreq, int step, int nbands, int oscilsize);
+    ~OscilBands();
+    OscilBands(const OscilBands&) = delete;
+
+    //! Band of a note frequency, -1 if it is above all bands
+    int band(float freqHz) const;
+    float *table(int band) { return smps + band * oscilsize; }
+    const float *table(int band) const { return smps + band * oscilsize; }
+
+    const float basefreq; //highest frequency of band 0
+    const int   step;     //semitones per band
+    const int   nbands;
+    const int   oscilsize;
+    float *const smps;
+    int   *const harmonics; //harmonics kept by each table
+    float *const rms;       //rms of those harmonics before normalizing
+};
+
 //All temporary variables and buffers for OscilGen computations
 class OscilGenBuffers : NoCopyNoMove
 {
@@ -58,6 +91,9 @@ private:
     FFTfreqBuffer oscilFFTfreqs;
     fft_t *pendingfreqs;
 
+    OscilBands *bands; //tables made from oscilFFTfreqs
+    bool bandsvalid;   //false once oscilFFTfreqs changed without new tables
+
     //This array stores some temporary data and it has OSCIL_SIZE elements
     FFTsampleBuffer tmpsmps;
     FFTfreqBuffer outoscilFFTfreqs;
@@ -103,6 +139,30 @@ class OscilGen:public Presets, NoCopyNoMove
         }
         //if freqHz is smaller than 0, return the "un-randomized" sample for UI
 
+        /**band limited outputs of get() for prepared freqs, see OscilBands*/
+        OscilBands *makeBands(const FFTfreqBuffer freqs) const NONREALTIME;
+        /**prepare and replace the tables of an oscil, which the realtime
+         * side is not using yet (e.g. after loading)*/
+        void updateBands() NONREALTIME;
+
+        /**whether get() takes its output for freqHz from the band tables,
+         * which getmipmaps() needs*/
+        bool hasmipmaps(float freqHz, int resonance = 0) {
+            return cachedBand(myBuffers(), freqHz, resonance) >= 0;
+        }
+        /**band limited copies of the output of get() for the mipmap
+         * antialiasing of ADnote, levels[l] keeps at most maxharmonic>>l
+         * harmonics (the tables have no extra samples). They are copied from
+         * the band tables, so no FFT is done.*/
+        void getmipmaps(OscilGenBuffers& bfrs, float *const *levels,
+                        int nlevels, int maxharmonic, float freqHz,
+                        int resonance) const REALTIME;
+        void getmipmaps(float *const *levels, int nlevels, int maxharmonic,
+                        float freqHz, int resonance = 0) {
+            getmipmaps(myBuffers(), levels, nlevels, maxharmonic, freqHz,
+                       resonance);
+        }
+
         void getbasefunction(OscilGenBuffers& bfrs, FFTsampleBuffer smps) const;
 
         //called by UI
@@ -219,6 +279,10 @@ class OscilGen:public Presets, NoCopyNoMove
         bool needPrepare() { return needPrepare(myBuffers()); }
     private:
 
+        //Band of bfrs.bands get() can copy, -1 if it has to compute
+        int cachedBand(const OscilGenBuffers& bfrs, float freqHz,
+                       int resonance) const;
+
         //Do the adaptive harmonic stuff
         void adaptiveharmonic(fft_t *f, float freq) const;
 
@@ -104,6 +104,7 @@ void PADnote::setup(float velocity_,
     int size = pars.sample[nsample].size;
     if(size == 0)
         size = 1;
+    playing = pars.sample[nsample].smp;
 
 
     if(!legato) { //not sure
@@ -280,17 +281,31 @@ void PADnote::computecurrentparameters()
 }
 
 
-int PADnote::Compute_Linear(float *outl,
+void PADnote::computeSample(const float *smps, int size, float smpfreq,
+                            float *outl, float *outr)
+{
+    float freqrap = realfreq / smpfreq;
+    int   freqhi  = (int) (floor(freqrap));
+    float freqlo  = freqrap - floorf(freqrap);
+
+
+    if(interpolation)
+        Compute_Cubic(smps, size, outl, outr, freqhi, freqlo);
+    else
+        Compute_Linear(smps, size, outl, outr, freqhi, freqlo);
+}
+
+int PADnote::Compute_Linear(const float *smps,
+                            int size,
+                            float *outl,
                             float *outr,
                             int freqhi,
                             float freqlo)
 {
-    const float *smps = pars.sample[nsample].smp;
     if(smps == NULL) {
         finished_ = true;
         return 1;
     }
-    int size = pars.sample[nsample].size;
     for(int i = 0; i < synth.buffersize; ++i) {
         poshi_l += freqhi;
         poshi_r += freqhi;
@@ -310,17 +325,17 @@ int PADnote::Compute_Linear(float *outl,
     }
     return 1;
 }
-int PADnote::Compute_Cubic(float *outl,
+int PADnote::Compute_Cubic(const float *smps,
+                           int size,
+                           float *outl,
                            float *outr,
                            int freqhi,
                            float freqlo)
 {
-    float *smps = pars.sample[nsample].smp;
     if(smps == NULL) {
         finished_ = true;
         return 1;
     }
-    int   size = pars.sample[nsample].size;
     float xm1, x0, x1, x2, a, b, c;
     for(int i = 0; i < synth.buffersize; ++i) {
         poshi_l += freqhi;
@@ -363,26 +378,37 @@ int PADnote::Compute_Cubic(float *outl,
 int PADnote::noteout(float *outl, float *outr)
 {
     computecurrentparameters();
-    float *smps = pars.sample[nsample].smp;
-    if(smps == NULL) {
+    const PADnoteParameters::Sample &smp = pars.sample[nsample];
+    if(smp.smp == NULL) {
         for(int i = 0; i < synth.buffersize; ++i) {
             outl[i] = 0.0f;
             outr[i] = 0.0f;
         }
         return 1;
     }
-    float smpfreq = pars.sample[nsample].basefreq;
-
-
-    float freqrap = realfreq / smpfreq;
-    int   freqhi  = (int) (floor(freqrap));
-    float freqlo  = freqrap - floorf(freqrap);
 
-
-    if(interpolation)
-        Compute_Cubic(outl, outr, freqhi, freqlo);
+    //The sample was replaced (e.g. the quick preview by the full quality
+    //one), so crossfade from the old one during this buffer
+    const PADnoteParameters::Sample &prev = pars.prevsample[nsample];
+    if(smp.smp != playing && playing && prev.smp == playing) {
+        const int   pos_l = poshi_l, pos_r = poshi_r;
+        const float pos   = poslo;
+        STACKALLOC(float, prevl, synth.buffersize);
+        STACKALLOC(float, prevr, synth.buffersize);
+        computeSample(prev.smp, prev.size, prev.basefreq, prevl, prevr);
+        poshi_l = pos_l;
+        poshi_r = pos_r;
+        poslo   = pos;
+        computeSample(smp.smp, smp.size, smp.basefreq, outl, outr);
+        for(int i = 0; i < synth.buffersize; ++i) {
+            const float x = (i + 1) / synth.buffersize_f;
+            outl[i] = prevl[i] + (outl[i] - prevl[i]) * x;
+            outr[i] = prevr[i] + (outr[i] - prevr[i]) * x;
+        }
+    }
     else
-        Compute_Linear(outl, outr, freqhi, freqlo);
+        computeSample(smp.smp, smp.size, smp.basefreq, outl, outr);
+    playing = smp.smp;
 
     watch_int(outl,synth.buffersize);
 
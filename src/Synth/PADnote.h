@@ -55,13 +55,21 @@ class PADnote:public SynthNote
         bool  firsttime;
 
         int nsample;
+        //table of the last buffer, to notice when the sample gets replaced
+        const float *playing;
         Portamento *portamento;
 
-        int Compute_Linear(float *outl,
+        void computeSample(const float *smps, int size, float smpfreq,
+                           float *outl, float *outr);
+        int Compute_Linear(const float *smps,
+                           int size,
+                           float *outl,
                            float *outr,
                            int freqhi,
                            float freqlo);
-        int Compute_Cubic(float *outl,
+        int Compute_Cubic(const float *smps,
+                          int size,
+                          float *outl,
                           float *outr,
                           int freqhi,
                           float freqlo);
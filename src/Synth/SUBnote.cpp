@@ -14,6 +14,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <cassert>
 #include <iostream>
 #include "../globals.h"
@@ -21,6 +22,7 @@
 #include "Envelope.h"
 #include "ModFilter.h"
 #include "Portamento.h"
+#include "SubFilterBank.h"
 #include "../Containers/ScratchString.h"
 #include "../Containers/NotePool.h"
 #include "../Params/Controller.h"
@@ -36,6 +38,9 @@
 
 namespace zyn {
 
+//Widest filter bank of this CPU
+static const SubFilterBank *filterBank = SubFilterBank::best();
+
 SUBnote::SUBnote(const SUBnoteParameters *parameters, const SynthParams &spars,
     WatchManager *wm, const char *prefix, bool constPowerMixing) :
     SynthNote(spars, constPowerMixing),
@@ -526,6 +531,11 @@ void SUBnote::chanOutput(float *out, bpfilter *bp, int buffer_size)
     for(int i = 0; i < buffer_size; ++i)
         tmprnd[i] = RND * 2.0f - 1.0f;
 
+    if(filterBank && numstages <= MAX_FILTER_STAGES) {
+        bankOutput(*filterBank, out, bp, tmprnd, buffer_size);
+        return;
+    }
+
     //For each harmonic apply the filter on the random input stream
     //Sum the filter outputs to obtain the output signal
     for(int n = 0; n < numharmonics; ++n) {
@@ -540,13 +550,56 @@ void SUBnote::chanOutput(float *out, bpfilter *bp, int buffer_size)
     }
 }
 
+/*
+ * Same as the harmonic loop of chanOutput, but all harmonics are run
+ * side by side on the SIMD lanes of the filter bank
+ */
+void SUBnote::bankOutput(const SubFilterBank &fb, float *out, bpfilter *bp,
+                         const float *in, int buffer_size)
+{
+    const int size = fb.size(numharmonics, numstages);
+    STACKALLOC(float, bank, size);
+    memset(bank, 0, size * sizeof(float));
+
+    for(int n = 0; n < numharmonics; ++n) {
+        bank[fb.gain(numstages, n)] = overtone_rolloff[n];
+        for(int nph = 0; nph < numstages; ++nph) {
+            const bpfilter &f = bp[nph + n * numstages];
+            bank[fb.value(numstages, n, nph, SubFilterBank::B0)]  = f.b0;
+            bank[fb.value(numstages, n, nph, SubFilterBank::B2)]  = f.b2;
+            bank[fb.value(numstages, n, nph, SubFilterBank::NA1)] = -f.a1;
+            bank[fb.value(numstages, n, nph, SubFilterBank::NA2)] = -f.a2;
+            bank[fb.value(numstages, n, nph, SubFilterBank::XN1)] = f.xn1;
+            bank[fb.value(numstages, n, nph, SubFilterBank::XN2)] = f.xn2;
+            bank[fb.value(numstages, n, nph, SubFilterBank::YN1)] = f.yn1;
+            bank[fb.value(numstages, n, nph, SubFilterBank::YN2)] = f.yn2;
+        }
+    }
+
+    fb.run(&bank[0], fb.groups(numharmonics), numstages, in, out, buffer_size);
+
+    for(int n = 0; n < numharmonics; ++n)
+        for(int nph = 0; nph < numstages; ++nph) {
+            bpfilter &f = bp[nph + n * numstages];
+            f.xn1 = bank[fb.value(numstages, n, nph, SubFilterBank::XN1)];
+            f.xn2 = bank[fb.value(numstages, n, nph, SubFilterBank::XN2)];
+            f.yn1 = bank[fb.value(numstages, n, nph, SubFilterBank::YN1)];
+            f.yn2 = bank[fb.value(numstages, n, nph, SubFilterBank::YN2)];
+        }
+}
+
 /*
  * Note Output
  */
 int SUBnote::noteout(float *outl, float *outr)
 {
-    memcpy(outl, synth.denormalkillbuf, synth.bufferbytes);
-    memcpy(outr, synth.denormalkillbuf, synth.bufferbytes);
+    if(synth.denormalnoise) {
+        memcpy(outl, synth.denormalkillbuf, synth.bufferbytes);
+        memcpy(outr, synth.denormalkillbuf, synth.bufferbytes);
+    } else {
+        memset(outl, 0, synth.bufferbytes);
+        memset(outr, 0, synth.bufferbytes);
+    }
 
     if(!NoteEnabled)
         return 0;
@@ -82,6 +82,8 @@ class SUBnote:public SynthNote
         };
 
         void chanOutput(float *out, bpfilter *bp, int buffer_size);
+        void bankOutput(const struct SubFilterBank &fb, float *out,
+                        bpfilter *bp, const float *in, int buffer_size);
 
         void initfilter(bpfilter &filter,
                         float freq,
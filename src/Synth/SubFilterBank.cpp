@@ -0,0 +1,174 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  SubFilterBank.cpp - Vectorized Band Pass Filter Bank Of SUBnote
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "SubFilterBank.h"
+#include "../globals.h"
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define FILTER_BANK_X86 1
+#endif
+
+namespace zyn {
+
+#ifdef __GNUC__
+
+//Samples accumulated before the sums of the lanes are added to the output
+#define BANK_BLOCK 64
+
+#define LOADV(v, p)  __builtin_memcpy(&(v), (p), sizeof(v))
+#define STOREV(p, v) __builtin_memcpy((p), &(v), sizeof(v))
+
+//Vector of W floats (a dependent vector_size is not supported by GCC)
+template<int W> struct BankVec;
+template<> struct BankVec<4>  { typedef float type __attribute__((vector_size(16))); };
+template<> struct BankVec<8>  { typedef float type __attribute__((vector_size(32))); };
+template<> struct BankVec<16> { typedef float type __attribute__((vector_size(64))); };
+
+/* Same biquad (b1 = 0) as SUBnote::filter, W harmonics at a time.
+ * The stage count is a template parameter, so the whole cascade of a
+ * group stays in registers. */
+template<int W, int S>
+static inline __attribute__((always_inline))
+void runBank(float *bank, int ngroups, const float *in, float *out,
+             int buffersize)
+{
+    typedef typename BankVec<W>::type vf;
+    const int stride = (1 + S * SubFilterBank::VALUES) * W;
+
+    for(int i0 = 0; i0 < buffersize; i0 += BANK_BLOCK) {
+        const int n = buffersize - i0 < BANK_BLOCK ? buffersize - i0 : BANK_BLOCK;
+        vf acc[BANK_BLOCK];
+        for(int i = 0; i < n; ++i)
+            acc[i] = (vf){};
+
+        for(int g = 0; g < ngroups; ++g) {
+            float *grp = bank + g * stride;
+            vf gain, c[S][4], st[S][4];
+            LOADV(gain, grp);
+            for(int s = 0; s < S; ++s)
+                for(int v = 0; v < 4; ++v) {
+                    LOADV(c[s][v],  grp + (1 + s * SubFilterBank::VALUES + v) * W);
+                    LOADV(st[s][v], grp + (5 + s * SubFilterBank::VALUES + v) * W);
+                }
+
+            for(int i = 0; i < n; ++i) {
+                vf x = (vf){} + in[i0 + i];
+                for(int s = 0; s < S; ++s) {
+                    const vf y = x * c[s][0] + st[s][1] * c[s][1]
+                               + st[s][2] * c[s][2] + st[s][3] * c[s][3];
+                    st[s][1] = st[s][0];
+                    st[s][0] = x;
+                    st[s][3] = st[s][2];
+                    st[s][2] = y;
+                    x = y;
+                }
+                acc[i] += x * gain;
+            }
+
+            for(int s = 0; s < S; ++s)
+                for(int v = 0; v < 4; ++v)
+                    STOREV(grp + (5 + s * SubFilterBank::VALUES + v) * W, st[s][v]);
+        }
+
+        for(int i = 0; i < n; ++i)
+            for(int l = 0; l < W; ++l)
+                out[i0 + i] += acc[i][l];
+    }
+}
+
+template<int W>
+static inline __attribute__((always_inline))
+void runBankStages(float *bank, int ngroups, int nstages, const float *in,
+                   float *out, int buffersize)
+{
+    static_assert(MAX_FILTER_STAGES == 5, "one case per stage count");
+    switch(nstages) {
+        case 1: runBank<W, 1>(bank, ngroups, in, out, buffersize); break;
+        case 2: runBank<W, 2>(bank, ngroups, in, out, buffersize); break;
+        case 3: runBank<W, 3>(bank, ngroups, in, out, buffersize); break;
+        case 4: runBank<W, 4>(bank, ngroups, in, out, buffersize); break;
+        case 5: runBank<W, 5>(bank, ngroups, in, out, buffersize); break;
+    }
+}
+
+//4 lanes with the baseline instruction set (SSE2 on x86_64, NEON on AArch64)
+static void runGeneric(float *bank, int ngroups, int nstages,
+                       const float *in, float *out, int buffersize)
+{
+    runBankStages<4>(bank, ngroups, nstages, in, out, buffersize);
+}
+
+static const SubFilterBank bankGeneric = {runGeneric, 4, "generic"};
+
+#ifdef FILTER_BANK_X86
+__attribute__((target("avx2")))
+static void runAVX2(float *bank, int ngroups, int nstages,
+                    const float *in, float *out, int buffersize)
+{
+    runBankStages<8>(bank, ngroups, nstages, in, out, buffersize);
+}
+
+__attribute__((target("avx512f")))
+static void runAVX512(float *bank, int ngroups, int nstages,
+                      const float *in, float *out, int buffersize)
+{
+    runBankStages<16>(bank, ngroups, nstages, in, out, buffersize);
+}
+
+static const SubFilterBank bankAVX2   = {runAVX2,   8,  "avx2"};
+static const SubFilterBank bankAVX512 = {runAVX512, 16, "avx512"};
+#endif
+
+const SubFilterBank *SubFilterBank::find(const char *name)
+{
+    if(!strcmp(name, "generic"))
+        return &bankGeneric;
+#ifdef FILTER_BANK_X86
+    __builtin_cpu_init();
+    if(!strcmp(name, "avx2") && __builtin_cpu_supports("avx2"))
+        return &bankAVX2;
+    if(!strcmp(name, "avx512") && __builtin_cpu_supports("avx512f"))
+        return &bankAVX512;
+#endif
+    return nullptr;
+}
+
+static const SubFilterBank *pickBank(void)
+{
+    static const char *order[] = {"avx512", "avx2", "generic"};
+    for(const char *name:order)
+        if(const SubFilterBank *bank = SubFilterBank::find(name))
+            return bank;
+    return nullptr;
+}
+
+const SubFilterBank *SubFilterBank::best(void)
+{
+    static const SubFilterBank *bank = pickBank();
+    return bank;
+}
+
+#else
+
+const SubFilterBank *SubFilterBank::find(const char *)
+{
+    return nullptr;
+}
+
+const SubFilterBank *SubFilterBank::best(void)
+{
+    return nullptr;
+}
+
+#endif
+
+}
@@ -0,0 +1,63 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  SubFilterBank.h - Vectorized Band Pass Filter Bank Of SUBnote
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+
+namespace zyn {
+
+/**
+ * Runs the band pass cascades of all SUBnote harmonics side by side.
+ *
+ * Every harmonic filters the same noise input, so the harmonics are packed
+ * into groups of `lanes` (4 for SSE2/NEON, 8 for AVX2, 16 for AVX-512) and
+ * one instruction advances the same stage of a whole group.
+ * The bank is a plain float array with interleaved coefficients and state:
+ *
+ *     group g: gain[lanes], then per stage: b0, b2, -a1, -a2,
+ *                                          xn1, xn2, yn1, yn2 [lanes each]
+ *
+ * Unused lanes of the last group must be zeroed, so they stay silent.
+ */
+struct SubFilterBank
+{
+    enum {B0, B2, NA1, NA2, XN1, XN2, YN1, YN2, VALUES};
+
+    /**Filter in through every cascade, add the cascade outputs multiplied
+     * by their gain to out and update the filter state in the bank*/
+    void (*run)(float *bank, int ngroups, int nstages,
+                const float *in, float *out, int buffersize);
+
+    int lanes;
+    const char *name;
+
+    int groups(int nharmonics) const {
+        return (nharmonics + lanes - 1) / lanes;
+    }
+    //! Size of the bank in floats
+    int size(int nharmonics, int nstages) const {
+        return groups(nharmonics) * (1 + nstages * VALUES) * lanes;
+    }
+    //! Offset of the gain of harmonic n
+    int gain(int nstages, int n) const {
+        return (n / lanes) * (1 + nstages * VALUES) * lanes + n % lanes;
+    }
+    //! Offset of value v (B0 ... YN2) of stage s of harmonic n
+    int value(int nstages, int n, int s, int v) const {
+        return gain(nstages, n) + (1 + s * VALUES + v) * lanes;
+    }
+
+    //! Widest bank supported by this CPU or NULL if the compiler has none
+    static const SubFilterBank *best(void);
+    //! Bank "generic", "avx2" or "avx512" or NULL if unsupported
+    static const SubFilterBank *find(const char *name);
+};
+
+}
@@ -12,7 +12,10 @@
 #include "SynthNote.h"
 #include "../Params/Controller.h"
 #include "../Misc/Util.h"
+#include "../Misc/Time.h"
+#include "../Misc/Allocator.h"
 #include "../globals.h"
+#include <algorithm>
 #include <cstring>
 #include <new>
 #include <iostream>
@@ -20,12 +23,43 @@
 namespace zyn {
 
 SynthNote::SynthNote(const SynthParams &pars, bool constPowerMixing)
-    :memory(pars.memory),
+    :render_prng_state(~pars.seed), silentBuffers(0), memory(pars.memory),
     legato(pars.synth, pars.velocity, pars.portamento,
             pars.note_log2_freq, pars.quiet, pars.seed), ctl(pars.ctl), synth(pars.synth), time(pars.time),
-            m_constPowerMixing(constPowerMixing)
+            m_constPowerMixing(constPowerMixing),
+            startdelay(pars.quiet ? 0 :
+                       limit(pars.time.eventOffset, 0, pars.synth.buffersize - 1)),
+            delaybuf(startdelay ? memory.valloc<float>(2 * startdelay) : nullptr)
 {}
 
+SynthNote::~SynthNote()
+{
+    memory.devalloc(delaybuf);
+}
+
+void SynthNote::delayOutput(float *outl, float *outr)
+{
+    if(!startdelay)
+        return;
+    //The end of this buffer is played at the start of the next one
+    const int bs = synth.buffersize;
+    std::rotate(outl, outl + bs - startdelay, outl + bs);
+    std::rotate(outr, outr + bs - startdelay, outr + bs);
+    std::swap_ranges(outl, outl + startdelay, delaybuf);
+    std::swap_ranges(outr, outr + startdelay, delaybuf + startdelay);
+}
+
+void SynthNote::flushDelay(float *outl, float *outr)
+{
+    memset(outl, 0, synth.bufferbytes);
+    memset(outr, 0, synth.bufferbytes);
+    if(!startdelay)
+        return;
+    memcpy(outl, delaybuf, startdelay * sizeof(float));
+    memcpy(outr, delaybuf + startdelay, startdelay * sizeof(float));
+    startdelay = 0;
+}
+
 SynthNote::Legato::Legato(const SYNTH_T &synth_, float vel,
                           Portamento *portamento,
                           float note_log2_freq, bool quiet, prng_t seed)
@@ -47,7 +47,7 @@ class SynthNote
 {
     public:
         SynthNote(const SynthParams &pars, bool constPowerMixing);
-        virtual ~SynthNote() {}
+        virtual ~SynthNote();
 
         /**Compute Output Samples
          * @return 0 if note is finished*/
@@ -84,6 +84,26 @@ class SynthNote
 
         bool constPowerMixing() const { return m_constPowerMixing; }
 
+        /* Delay the output of noteout() by the offset of the note-on event
+         * within its buffer (AbsTime::eventOffset), so the note starts at
+         * the exact sample instead of at the start of the buffer */
+        void delayOutput(float *outl, float *outr);
+
+        /* Output the end of the last buffer of a finished note, which
+         * delayOutput() kept back, followed by silence */
+        void flushDelay(float *outl, float *outr);
+
+        /* If the note is finished and nothing of it is left to output */
+        bool outputFinished(void) const { return !startdelay && finished(); }
+
+        /* Stream of prng()/RND while the note is rendered (see PrngScope)
+         * so the output does not depend on the order notes are rendered */
+        prng_t render_prng_state;
+
+        /* Buffers a released note stayed below the silence threshold of its
+         * part (see Part::noteFadedOut) */
+        int silentBuffers;
+
         //Realtime Safe Memory Allocator For notes
         class Allocator  &memory;
     protected:
@@ -137,6 +157,8 @@ class SynthNote
         smooth_float     filtercutoff_relfreq;
     private:
         bool m_constPowerMixing;
+        int    startdelay; //samples, 0 for notes starting with the buffer
+        float *delaybuf;   //last startdelay samples of the previous buffer
 };
 
 }
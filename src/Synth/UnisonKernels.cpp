@@ -0,0 +1,437 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  UnisonKernels.cpp - Vectorized Inner Loops Of The ADnote Unison
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "UnisonKernels.h"
+#include <cassert>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define UNISON_X86 1
+#include <immintrin.h>
+#endif
+//ARMv7 NEON flushes denormals, which the scalar code does not
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define UNISON_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace zyn {
+
+/* As the code here is a bit odd due to optimization, here is what happens
+ * First the current position and frequency are retrieved from the running
+ * state. These are broken up into high and low portions to indicate how many
+ * samples are skipped in one step and how many fractional samples are skipped.
+ * Outside of this method the fractional samples are just handled with floating
+ * point code, but that's a bit slower than it needs to be. In this code the low
+ * portions are known to exist between 0.0 and 1.0 and it is known that they are
+ * stored in single precision floating point IEEE numbers. This implies that
+ * a maximum of 24 bits are significant. The below code does your standard
+ * linear interpolation that you'll see throughout this codebase, but by
+ * sticking to integers for tracking the overflow of the low portion, around 15%
+ * of the execution time was shaved off in the ADnote test.
+ */
+static void oscLinearScalar(const float *smps, int oscilsize,
+                            int *poshi_, float *poslo_,
+                            const int *freqhi_, const float *freqlo_,
+                            float *const *out, int nunison, int buffersize)
+{
+    for(int k = 0; k < nunison; ++k) {
+        int    poshi  = poshi_[k];
+        // convert floating point fractional part (sample interval phase)
+        // with range [0.0 ... 1.0] to fixed point with 1 digit is 2^-24
+        // by multiplying with precalculated 2^24 and casting to integer:
+        int    poslo  = (int)(poslo_[k] * 16777216.0f);
+        int    freqhi = freqhi_[k];
+        // same for phase increment:
+        int    freqlo = (int)(freqlo_[k] * 16777216.0f);
+        float *tw     = out[k];
+        assert(freqlo_[k] < 1.0f);
+        for(int i = 0; i < buffersize; ++i) {
+            tw[i]  = (smps[poshi] * (0x01000000 - poslo) + smps[poshi + 1] * poslo)/(16777216.0f);
+            poslo += freqlo;                // increment fractional part (sample interval phase)
+            poshi += freqhi + (poslo>>24);  // add overflow over 24 bits in poslo to poshi
+            poslo &= 0xffffff;              // remove overflow from poslo
+            poshi &= oscilsize - 1;         // remove overflow
+        }
+        poshi_[k] = poshi;
+        poslo_[k] = poslo/(16777216.0f);
+    }
+}
+
+//Accumulation order per sample is the one of the original subvoice loop
+static void mixScalar(const float *const *in, int nunison,
+                      const float *lvol, const float *rvol,
+                      float *outl, float *outr, int buffersize)
+{
+    for(int k = 0; k < nunison; ++k) {
+        const float *tw = in[k];
+        for(int i = 0; i < buffersize; ++i)
+            outl[i] += tw[i] * lvol[k];
+        if(outr)
+            for(int i = 0; i < buffersize; ++i)
+                outr[i] += tw[i] * rvol[k];
+    }
+}
+
+/* The vector kernels keep one subvoice per lane. Division by 2^24 is done
+ * as a multiplication with 2^-24, which is exact and gives the same
+ * result. */
+#define UNISON_INV24 (1.0f / 16777216.0f)
+
+#ifdef UNISON_X86
+__attribute__((target("sse2")))
+static inline __m128 lerpSSE2(const float *smps, __m128i hi, __m128i lo)
+{
+    alignas(16) int idx[4];
+    _mm_store_si128((__m128i*)idx, hi);
+    const __m128 a = _mm_setr_ps(smps[idx[0]], smps[idx[1]],
+                                 smps[idx[2]], smps[idx[3]]);
+    const __m128 b = _mm_setr_ps(smps[idx[0] + 1], smps[idx[1] + 1],
+                                 smps[idx[2] + 1], smps[idx[3] + 1]);
+    const __m128 wl = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_set1_epi32(0x01000000), lo));
+    const __m128 wr = _mm_cvtepi32_ps(lo);
+    return _mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, wl), _mm_mul_ps(b, wr)),
+                      _mm_set1_ps(UNISON_INV24));
+}
+
+__attribute__((target("sse2")))
+static void oscLinearSSE2(const float *smps, int oscilsize,
+                          int *poshi, float *poslo,
+                          const int *freqhi, const float *freqlo,
+                          float *const *out, int nunison, int buffersize)
+{
+    const __m128  scale  = _mm_set1_ps(16777216.0f);
+    const __m128i mask   = _mm_set1_epi32(oscilsize - 1);
+    const __m128i lomask = _mm_set1_epi32(0xffffff);
+    int k = 0;
+    for(; k + 4 <= nunison; k += 4) {
+        __m128i hi  = _mm_loadu_si128((const __m128i*)(poshi + k));
+        __m128i lo  = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(poslo + k), scale));
+        __m128i fhi = _mm_loadu_si128((const __m128i*)(freqhi + k));
+        __m128i flo = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(freqlo + k), scale));
+        float *o0 = out[k], *o1 = out[k + 1], *o2 = out[k + 2], *o3 = out[k + 3];
+        for(int i = 0; i < buffersize; i += 4) {
+            __m128 s[4];
+            const int n = buffersize - i < 4 ? buffersize - i : 4;
+            for(int j = 0; j < n; ++j) {
+                s[j] = lerpSSE2(smps, hi, lo);
+                lo   = _mm_add_epi32(lo, flo);
+                hi   = _mm_add_epi32(hi, _mm_add_epi32(fhi, _mm_srli_epi32(lo, 24)));
+                lo   = _mm_and_si128(lo, lomask);
+                hi   = _mm_and_si128(hi, mask);
+            }
+            if(n == 4) {
+                _MM_TRANSPOSE4_PS(s[0], s[1], s[2], s[3]);
+                _mm_storeu_ps(o0 + i, s[0]);
+                _mm_storeu_ps(o1 + i, s[1]);
+                _mm_storeu_ps(o2 + i, s[2]);
+                _mm_storeu_ps(o3 + i, s[3]);
+            } else {
+                alignas(16) float tmp[4];
+                for(int j = 0; j < n; ++j) {
+                    _mm_store_ps(tmp, s[j]);
+                    o0[i + j] = tmp[0];
+                    o1[i + j] = tmp[1];
+                    o2[i + j] = tmp[2];
+                    o3[i + j] = tmp[3];
+                }
+            }
+        }
+        _mm_storeu_si128((__m128i*)(poshi + k), hi);
+        _mm_storeu_ps(poslo + k, _mm_mul_ps(_mm_cvtepi32_ps(lo),
+                                            _mm_set1_ps(UNISON_INV24)));
+    }
+    oscLinearScalar(smps, oscilsize, poshi + k, poslo + k, freqhi + k,
+                    freqlo + k, out + k, nunison - k, buffersize);
+}
+
+__attribute__((target("sse2")))
+static void mixSSE2(const float *const *in, int nunison,
+                    const float *lvol, const float *rvol,
+                    float *outl, float *outr, int buffersize)
+{
+    int i = 0;
+    for(; i + 4 <= buffersize; i += 4) {
+        __m128 l = _mm_loadu_ps(outl + i);
+        if(outr) {
+            __m128 r = _mm_loadu_ps(outr + i);
+            for(int k = 0; k < nunison; ++k) {
+                const __m128 tw = _mm_loadu_ps(in[k] + i);
+                l = _mm_add_ps(l, _mm_mul_ps(tw, _mm_set1_ps(lvol[k])));
+                r = _mm_add_ps(r, _mm_mul_ps(tw, _mm_set1_ps(rvol[k])));
+            }
+            _mm_storeu_ps(outr + i, r);
+        } else
+            for(int k = 0; k < nunison; ++k)
+                l = _mm_add_ps(l, _mm_mul_ps(_mm_loadu_ps(in[k] + i),
+                                             _mm_set1_ps(lvol[k])));
+        _mm_storeu_ps(outl + i, l);
+    }
+    for(; i < buffersize; ++i)
+        for(int k = 0; k < nunison; ++k) {
+            outl[i] += in[k][i] * lvol[k];
+            if(outr)
+                outr[i] += in[k][i] * rvol[k];
+        }
+}
+
+__attribute__((target("avx2")))
+static inline void transpose8(__m256 *r)
+{
+    __m256 t[8], u[8];
+    for(int j = 0; j < 8; j += 2) {
+        t[j]     = _mm256_unpacklo_ps(r[j], r[j + 1]);
+        t[j + 1] = _mm256_unpackhi_ps(r[j], r[j + 1]);
+    }
+    for(int j = 0; j < 8; j += 4) {
+        u[j]     = _mm256_shuffle_ps(t[j],     t[j + 2], _MM_SHUFFLE(1, 0, 1, 0));
+        u[j + 1] = _mm256_shuffle_ps(t[j],     t[j + 2], _MM_SHUFFLE(3, 2, 3, 2));
+        u[j + 2] = _mm256_shuffle_ps(t[j + 1], t[j + 3], _MM_SHUFFLE(1, 0, 1, 0));
+        u[j + 3] = _mm256_shuffle_ps(t[j + 1], t[j + 3], _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for(int j = 0; j < 4; ++j) {
+        r[j]     = _mm256_permute2f128_ps(u[j], u[j + 4], 0x20);
+        r[j + 4] = _mm256_permute2f128_ps(u[j], u[j + 4], 0x31);
+    }
+}
+
+__attribute__((target("avx2")))
+static void oscLinearAVX2(const float *smps, int oscilsize,
+                          int *poshi, float *poslo,
+                          const int *freqhi, const float *freqlo,
+                          float *const *out, int nunison, int buffersize)
+{
+    const __m256  scale  = _mm256_set1_ps(16777216.0f);
+    const __m256  inv    = _mm256_set1_ps(UNISON_INV24);
+    const __m256i one    = _mm256_set1_epi32(0x01000000);
+    const __m256i next   = _mm256_set1_epi32(1);
+    const __m256i mask   = _mm256_set1_epi32(oscilsize - 1);
+    const __m256i lomask = _mm256_set1_epi32(0xffffff);
+    int k = 0;
+    for(; k + 8 <= nunison; k += 8) {
+        __m256i hi  = _mm256_loadu_si256((const __m256i*)(poshi + k));
+        __m256i lo  = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(poslo + k), scale));
+        __m256i fhi = _mm256_loadu_si256((const __m256i*)(freqhi + k));
+        __m256i flo = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(freqlo + k), scale));
+        for(int i = 0; i < buffersize; i += 8) {
+            __m256 s[8];
+            const int n = buffersize - i < 8 ? buffersize - i : 8;
+            for(int j = 0; j < n; ++j) {
+                const __m256 a  = _mm256_i32gather_ps(smps, hi, 4);
+                const __m256 b  = _mm256_i32gather_ps(smps, _mm256_add_epi32(hi, next), 4);
+                const __m256 wl = _mm256_cvtepi32_ps(_mm256_sub_epi32(one, lo));
+                const __m256 wr = _mm256_cvtepi32_ps(lo);
+                s[j] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(a, wl),
+                                                   _mm256_mul_ps(b, wr)), inv);
+                lo   = _mm256_add_epi32(lo, flo);
+                hi   = _mm256_add_epi32(hi, _mm256_add_epi32(fhi, _mm256_srli_epi32(lo, 24)));
+                lo   = _mm256_and_si256(lo, lomask);
+                hi   = _mm256_and_si256(hi, mask);
+            }
+            if(n == 8) {
+                transpose8(s);
+                for(int j = 0; j < 8; ++j)
+                    _mm256_storeu_ps(out[k + j] + i, s[j]);
+            } else {
+                alignas(32) float tmp[8];
+                for(int j = 0; j < n; ++j) {
+                    _mm256_store_ps(tmp, s[j]);
+                    for(int l = 0; l < 8; ++l)
+                        out[k + l][i + j] = tmp[l];
+                }
+            }
+        }
+        _mm256_storeu_si256((__m256i*)(poshi + k), hi);
+        _mm256_storeu_ps(poslo + k, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), inv));
+    }
+    oscLinearSSE2(smps, oscilsize, poshi + k, poslo + k, freqhi + k,
+                  freqlo + k, out + k, nunison - k, buffersize);
+}
+
+__attribute__((target("avx2")))
+static void mixAVX2(const float *const *in, int nunison,
+                    const float *lvol, const float *rvol,
+                    float *outl, float *outr, int buffersize)
+{
+    int i = 0;
+    for(; i + 8 <= buffersize; i += 8) {
+        __m256 l = _mm256_loadu_ps(outl + i);
+        if(outr) {
+            __m256 r = _mm256_loadu_ps(outr + i);
+            for(int k = 0; k < nunison; ++k) {
+                const __m256 tw = _mm256_loadu_ps(in[k] + i);
+                l = _mm256_add_ps(l, _mm256_mul_ps(tw, _mm256_set1_ps(lvol[k])));
+                r = _mm256_add_ps(r, _mm256_mul_ps(tw, _mm256_set1_ps(rvol[k])));
+            }
+            _mm256_storeu_ps(outr + i, r);
+        } else
+            for(int k = 0; k < nunison; ++k)
+                l = _mm256_add_ps(l, _mm256_mul_ps(_mm256_loadu_ps(in[k] + i),
+                                                   _mm256_set1_ps(lvol[k])));
+        _mm256_storeu_ps(outl + i, l);
+    }
+    for(; i < buffersize; ++i)
+        for(int k = 0; k < nunison; ++k) {
+            outl[i] += in[k][i] * lvol[k];
+            if(outr)
+                outr[i] += in[k][i] * rvol[k];
+        }
+}
+#endif
+
+#ifdef UNISON_NEON
+static inline float32x4_t lerpNEON(const float *smps, int32x4_t hi, int32x4_t lo)
+{
+    int idx[4];
+    vst1q_s32(idx, hi);
+    float32x4_t a = vdupq_n_f32(0.0f), b = vdupq_n_f32(0.0f);
+    a = vld1q_lane_f32(smps + idx[0], a, 0);
+    a = vld1q_lane_f32(smps + idx[1], a, 1);
+    a = vld1q_lane_f32(smps + idx[2], a, 2);
+    a = vld1q_lane_f32(smps + idx[3], a, 3);
+    b = vld1q_lane_f32(smps + idx[0] + 1, b, 0);
+    b = vld1q_lane_f32(smps + idx[1] + 1, b, 1);
+    b = vld1q_lane_f32(smps + idx[2] + 1, b, 2);
+    b = vld1q_lane_f32(smps + idx[3] + 1, b, 3);
+    const float32x4_t wl = vcvtq_f32_s32(vsubq_s32(vdupq_n_s32(0x01000000), lo));
+    const float32x4_t wr = vcvtq_f32_s32(lo);
+    return vmulq_f32(vaddq_f32(vmulq_f32(a, wl), vmulq_f32(b, wr)),
+                     vdupq_n_f32(UNISON_INV24));
+}
+
+static void oscLinearNEON(const float *smps, int oscilsize,
+                          int *poshi, float *poslo,
+                          const int *freqhi, const float *freqlo,
+                          float *const *out, int nunison, int buffersize)
+{
+    const float32x4_t scale  = vdupq_n_f32(16777216.0f);
+    const int32x4_t   mask   = vdupq_n_s32(oscilsize - 1);
+    const int32x4_t   lomask = vdupq_n_s32(0xffffff);
+    int k = 0;
+    for(; k + 4 <= nunison; k += 4) {
+        int32x4_t hi  = vld1q_s32(poshi + k);
+        int32x4_t lo  = vcvtq_s32_f32(vmulq_f32(vld1q_f32(poslo + k), scale));
+        int32x4_t fhi = vld1q_s32(freqhi + k);
+        int32x4_t flo = vcvtq_s32_f32(vmulq_f32(vld1q_f32(freqlo + k), scale));
+        float *o0 = out[k], *o1 = out[k + 1], *o2 = out[k + 2], *o3 = out[k + 3];
+        for(int i = 0; i < buffersize; i += 4) {
+            float32x4_t s[4];
+            const int n = buffersize - i < 4 ? buffersize - i : 4;
+            for(int j = 0; j < n; ++j) {
+                s[j] = lerpNEON(smps, hi, lo);
+                lo   = vaddq_s32(lo, flo);
+                hi   = vaddq_s32(hi, vaddq_s32(fhi, vshrq_n_s32(lo, 24)));
+                lo   = vandq_s32(lo, lomask);
+                hi   = vandq_s32(hi, mask);
+            }
+            if(n == 4) {
+                const float32x4x2_t p01 = vtrnq_f32(s[0], s[1]);
+                const float32x4x2_t p23 = vtrnq_f32(s[2], s[3]);
+                vst1q_f32(o0 + i, vcombine_f32(vget_low_f32(p01.val[0]),
+                                               vget_low_f32(p23.val[0])));
+                vst1q_f32(o1 + i, vcombine_f32(vget_low_f32(p01.val[1]),
+                                               vget_low_f32(p23.val[1])));
+                vst1q_f32(o2 + i, vcombine_f32(vget_high_f32(p01.val[0]),
+                                               vget_high_f32(p23.val[0])));
+                vst1q_f32(o3 + i, vcombine_f32(vget_high_f32(p01.val[1]),
+                                               vget_high_f32(p23.val[1])));
+            } else {
+                float tmp[4];
+                for(int j = 0; j < n; ++j) {
+                    vst1q_f32(tmp, s[j]);
+                    o0[i + j] = tmp[0];
+                    o1[i + j] = tmp[1];
+                    o2[i + j] = tmp[2];
+                    o3[i + j] = tmp[3];
+                }
+            }
+        }
+        vst1q_s32(poshi + k, hi);
+        vst1q_f32(poslo + k, vmulq_f32(vcvtq_f32_s32(lo),
+                                       vdupq_n_f32(UNISON_INV24)));
+    }
+    oscLinearScalar(smps, oscilsize, poshi + k, poslo + k, freqhi + k,
+                    freqlo + k, out + k, nunison - k, buffersize);
+}
+
+static void mixNEON(const float *const *in, int nunison,
+                    const float *lvol, const float *rvol,
+                    float *outl, float *outr, int buffersize)
+{
+    int i = 0;
+    for(; i + 4 <= buffersize; i += 4) {
+        float32x4_t l = vld1q_f32(outl + i);
+        if(outr) {
+            float32x4_t r = vld1q_f32(outr + i);
+            for(int k = 0; k < nunison; ++k) {
+                const float32x4_t tw = vld1q_f32(in[k] + i);
+                l = vaddq_f32(l, vmulq_f32(tw, vdupq_n_f32(lvol[k])));
+                r = vaddq_f32(r, vmulq_f32(tw, vdupq_n_f32(rvol[k])));
+            }
+            vst1q_f32(outr + i, r);
+        } else
+            for(int k = 0; k < nunison; ++k)
+                l = vaddq_f32(l, vmulq_f32(vld1q_f32(in[k] + i),
+                                           vdupq_n_f32(lvol[k])));
+        vst1q_f32(outl + i, l);
+    }
+    for(; i < buffersize; ++i)
+        for(int k = 0; k < nunison; ++k) {
+            outl[i] += in[k][i] * lvol[k];
+            if(outr)
+                outr[i] += in[k][i] * rvol[k];
+        }
+}
+#endif
+
+static const UnisonKernels kernelsScalar = {oscLinearScalar, mixScalar, "scalar"};
+#ifdef UNISON_X86
+static const UnisonKernels kernelsSSE2 = {oscLinearSSE2, mixSSE2, "sse2"};
+static const UnisonKernels kernelsAVX2 = {oscLinearAVX2, mixAVX2, "avx2"};
+#endif
+#ifdef UNISON_NEON
+static const UnisonKernels kernelsNEON = {oscLinearNEON, mixNEON, "neon"};
+#endif
+
+const UnisonKernels *UnisonKernels::find(const char *name)
+{
+    if(!strcmp(name, "scalar"))
+        return &kernelsScalar;
+#ifdef UNISON_X86
+    __builtin_cpu_init();
+    if(!strcmp(name, "sse2") && __builtin_cpu_supports("sse2"))
+        return &kernelsSSE2;
+    if(!strcmp(name, "avx2") && __builtin_cpu_supports("avx2"))
+        return &kernelsAVX2;
+#endif
+#ifdef UNISON_NEON
+    if(!strcmp(name, "neon"))
+        return &kernelsNEON;
+#endif
+    return nullptr;
+}
+
+static const UnisonKernels *pickKernels(void)
+{
+    static const char *order[] = {"avx2", "sse2", "neon"};
+    for(const char *name:order)
+        if(const UnisonKernels *kernels = UnisonKernels::find(name))
+            return kernels;
+    return &kernelsScalar;
+}
+
+const UnisonKernels &UnisonKernels::best(void)
+{
+    static const UnisonKernels *kernels = pickKernels();
+    return *kernels;
+}
+
+}
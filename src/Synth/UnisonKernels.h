@@ -0,0 +1,53 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  UnisonKernels.h - Vectorized Inner Loops Of The ADnote Unison
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+
+namespace zyn {
+
+/**
+ * Inner loops of ADnote which run once per unison subvoice.
+ *
+ * The unison state of a voice is already kept as structure of arrays
+ * (oscposhi[k], oscposlo[k], ...), so the vector kernels process 4 (SSE2,
+ * NEON) or 8 (AVX2) subvoices per instruction and transpose the result
+ * into the per subvoice buffers.
+ * The kernel set is picked at runtime by CPU features. Every kernel does
+ * the same float operations in the same order as the scalar one, so all of
+ * them produce the same output.
+ */
+struct UnisonKernels
+{
+    /**Linear interpolating wavetable oscillator of all subvoices
+     * @param smps   wavetable of oscilsize samples (+1 guard sample)
+     * @param poshi  integer phase of each subvoice (updated)
+     * @param poslo  fractional phase of each subvoice (updated)
+     * @param out    one buffer of buffersize samples per subvoice*/
+    void (*oscLinear)(const float *smps, int oscilsize,
+                      int *poshi, float *poslo,
+                      const int *freqhi, const float *freqlo,
+                      float *const *out, int nunison, int buffersize);
+
+    /**Adds the subvoices to the voice with a gain per subvoice and channel
+     * (outr may be NULL for mono voices)*/
+    void (*mix)(const float *const *in, int nunison,
+                const float *lvol, const float *rvol,
+                float *outl, float *outr, int buffersize);
+
+    const char *name;
+
+    //! Fastest kernel set supported by this CPU
+    static const UnisonKernels &best(void);
+    //! Kernel set "scalar", "sse2", "avx2" or "neon" or NULL if unsupported
+    static const UnisonKernels *find(const char *name);
+};
+
+}
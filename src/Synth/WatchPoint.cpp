@@ -158,6 +158,14 @@ bool WatchManager::active(const char *id) const
     return false;
 }
 
+bool WatchManager::empty(void) const
+{
+    for(int i=0; i<MAX_WATCH; ++i)
+        if(active_list[i][0])
+            return false;
+    return true;
+}
+
 bool WatchManager::trigger_active(const char *id) const
 {
     for(int i=0; i<MAX_WATCH; ++i)
@@ -0,0 +1,290 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BankDbTest.cpp - Test the indexed instrument bank database
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../Misc/BankDb.h"
+#include "../Misc/XMLwrapper.h"
+#include "../Misc/Util.h"
+
+using namespace std;
+using namespace zyn;
+
+class BankDbTest
+{
+    public:
+        char root[64];
+        string banka, bankb;
+
+        void setUp() {
+            strcpy(root, "/tmp/zyn-bank-db-XXXXXX");
+            TS_ASSERT(mkdtemp(root) != NULL);
+            //keep the cache file of the database in the test directory
+            setenv("HOME", root, 1);
+            banka = string(root) + "/Pads/";
+            bankb = string(root) + "/Leads/";
+            mkdir(banka.c_str(), 0700);
+            mkdir(bankb.c_str(), 0700);
+        }
+
+        void tearDown() {
+            for(auto bank:{banka, bankb}) {
+                DIR *dir = opendir(bank.c_str());
+                while(struct dirent *fn = dir ? readdir(dir) : NULL)
+                    if(fn->d_name[0] != '.')
+                        unlink((bank + fn->d_name).c_str());
+                if(dir)
+                    closedir(dir);
+                rmdir(bank.c_str());
+            }
+            unlink((string(root) + "/.zynaddsubfx-bank-cache.bin").c_str());
+            rmdir(root);
+        }
+
+        void instrument(string file, string author, string comments,
+                        bool pad) {
+            XMLwrapper xml;
+            xml.beginbranch("INSTRUMENT");
+            xml.beginbranch("INFO");
+            xml.addparstr("author", author);
+            xml.addparstr("comments", comments);
+            xml.addpar("type", 12);
+            xml.endbranch();
+            xml.beginbranch("INSTRUMENT_KIT");
+            xml.beginbranch("INSTRUMENT_KIT_ITEM", 0);
+            xml.addparbool("add_enabled", !pad);
+            xml.addparbool("pad_enabled", pad);
+            xml.endbranch();
+            xml.endbranch();
+            xml.endbranch();
+            TS_ASSERT_EQUAL_INT(xml.saveXMLfile(file, 0), 0);
+        }
+
+        void fill(int n) {
+            const char *words[] = {"Warm", "bright STRING", "dark", "Choir",
+                                   "soft\tbell", "Brass"};
+            for(int i = 0; i < n; ++i) {
+                char name[64];
+                snprintf(name, sizeof(name), "%04d-%s %d.xiz", i % 128 + 1,
+                         words[i % 6], i);
+                instrument((i % 2 ? banka : bankb) + name,
+                           i % 3 ? "Paul" : "Mark mccurry",
+                           words[(i / 6) % 6], i % 4 == 0);
+            }
+        }
+
+        //Files of the entries, in order
+        static string files(const BankDb::bvec &vec) {
+            string res;
+            for(auto &e:vec)
+                res += e.bank + e.file + "\n";
+            return res;
+        }
+
+        //Entries matching all keywords, as found without an index
+        static BankDb::bvec scan(BankDb &db, string terms) {
+            BankDb::bvec res;
+            vector<string> words;
+            char buf[256];
+            strcpy(buf, terms.c_str());
+            for(char *w = strtok(buf, " "); w; w = strtok(NULL, " "))
+                words.push_back(w);
+            for(auto &e:db.search("")) {
+                bool match = true;
+                for(auto &w:words)
+                    match &= e.match(w);
+                if(match)
+                    res.push_back(e);
+            }
+            return res;
+        }
+
+        void testSearch() {
+            fill(60);
+            BankDb db;
+            db.addBankDir(banka);
+            db.addBankDir(bankb);
+            db.scanBanks();
+
+            TS_ASSERT_EQUAL_INT(db.search("").size(), 60);
+            const char *terms[] = {"warm", "STRING", "ring bri", "paul",
+                                   "mccurry dark", "#pad", "#add choir",
+                                   "leads", "Pads ell", "xiz 0013", "nothing",
+                                   "ar", "#sub"};
+            for(auto t:terms)
+                TS_ASSERT_EQUAL_CPP(files(db.search(t)), files(scan(db, t)));
+            TS_ASSERT_EQUAL_INT(db.search("#pad").size(), 15);
+            TS_ASSERT_EQUAL_INT(db.search("#sub").size(), 0);
+            TS_ASSERT_EQUAL_INT(db.tags().size(), 2);
+
+            //The types and metadata are read from the instruments
+            auto vec = db.search("0001-Warm");
+            TS_ASSERT_EQUAL_INT(vec.size(), 1);
+            TS_ASSERT_EQUAL_STR("Synth Pad", vec[0].type.c_str());
+            TS_ASSERT_EQUAL_STR("Mark mccurry", vec[0].author.c_str());
+            TS_ASSERT_EQUAL_STR("Warm 0", vec[0].name.c_str());
+            TS_ASSERT_EQUAL_INT(vec[0].id, 1);
+
+            BankDb::bvec entries;
+            TS_ASSERT(db.getBank(banka, entries));
+            TS_ASSERT_EQUAL_INT(entries.size(), 30);
+            TS_ASSERT(!db.getBank(string(root) + "/none/", entries));
+        }
+
+        void testUpdate() {
+            fill(12);
+            BankDb db;
+            db.addBankDir(banka);
+            db.addBankDir(bankb);
+            db.scanBanks();
+
+            //New, rewritten and removed files
+            instrument(banka + "0200-Organ.xiz", "Someone", "", false);
+            instrument(bankb + "0001-Warm 0.xiz", "Rewritten", "", false);
+            unlink((banka + "0002-bright STRING 1.xiz").c_str());
+#ifndef __linux__
+            db.scanBanks(); //without inotify the changes need a scan
+#endif
+            TS_ASSERT_EQUAL_INT(db.search("organ").size(), 1);
+            TS_ASSERT_EQUAL_INT(db.search("someone").size(), 1);
+            TS_ASSERT_EQUAL_INT(db.search("rewritten").size(), 1);
+            TS_ASSERT_EQUAL_INT(db.search("#pad 0001-warm").size(), 0);
+            TS_ASSERT_EQUAL_INT(db.search("0002-bright").size(), 0);
+            TS_ASSERT_EQUAL_INT(db.search("0008-bright").size(), 1);
+            TS_ASSERT_EQUAL_INT(db.search("").size(), 12);
+
+            BankDb::bvec entries;
+            TS_ASSERT(db.getBank(banka, entries));
+            TS_ASSERT_EQUAL_INT(entries.size(), 6);
+
+            //A bank which is not scanned again is dropped
+            db.clear();
+            db.addBankDir(bankb);
+            db.scanBanks();
+            TS_ASSERT_EQUAL_INT(db.search("organ").size(), 0);
+            TS_ASSERT_EQUAL_INT(db.search("").size(), 6);
+
+            //Directories which are no banks can be loaded, but they are
+            //not searched
+            TS_ASSERT(db.getBank(banka, entries));
+            TS_ASSERT_EQUAL_INT(entries.size(), 6);
+            TS_ASSERT_EQUAL_INT(db.search("organ").size(), 0);
+            TS_ASSERT_EQUAL_INT(db.search("").size(), 6);
+        }
+
+        void testCache() {
+            fill(40);
+            string expect;
+            {
+                BankDb db;
+                db.addBankDir(banka);
+                db.addBankDir(bankb);
+                db.scanBanks();
+                expect = files(db.search("#pad"));
+            }
+
+            //Unmodified directories and files come from the cache file,
+            //files modified since are read again
+            instrument(bankb + "0013-Warm 12.xiz", "Paul", "", false);
+            BankDb db;
+            db.addBankDir(banka);
+            db.addBankDir(bankb);
+            db.scanBanks();
+            TS_ASSERT_EQUAL_INT(db.search("").size(), 40);
+            TS_ASSERT(files(db.search("#pad")) != expect);
+            TS_ASSERT_EQUAL_INT(db.search("#pad").size(), 9);
+            TS_ASSERT_EQUAL_CPP(files(db.search("mark warm")),
+                                files(scan(db, "mark warm")));
+        }
+
+        //Only scanning the banks writes the cache file
+        void testNoSave() {
+            fill(4);
+            const string cache = string(root) + "/.zynaddsubfx-bank-cache.bin";
+            {
+                BankDb db;
+                db.addBankDir(banka);
+                BankDb::bvec entries;
+                TS_ASSERT(db.getBank(banka, entries));
+                TS_ASSERT_EQUAL_INT(entries.size(), 2);
+            }
+            TS_ASSERT(access(cache.c_str(), F_OK) != 0);
+
+            {
+                BankDb db;
+                db.addBankDir(banka);
+                db.scanBanks();
+            }
+            TS_ASSERT(access(cache.c_str(), F_OK) == 0);
+        }
+
+        void testSpeed() {
+            fill(1000);
+            BankDb db;
+            db.addBankDir(banka);
+            db.addBankDir(bankb);
+
+            clock_t t_on = clock();
+            db.scanBanks();
+            clock_t t_off = clock();
+            const float scan_t = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            t_on = clock();
+            db.scanBanks();
+            t_off = clock();
+            const float rescan_t = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            const char *terms[] = {"warm", "ring bri", "paul dark", "#pad"};
+            const int searches = 200;
+            size_t found = 0;
+            t_on = clock();
+            for(int i = 0; i < searches; ++i)
+                found += db.search(terms[i % 4]).size();
+            t_off = clock();
+            const float search_t = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            size_t expect = 0;
+            t_on = clock();
+            for(int i = 0; i < searches; ++i)
+                expect += scan(db, terms[i % 4]).size();
+            t_off = clock();
+            const float scan_s = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            printf("BankDbTest: %f seconds to scan 1000 instruments, %f to"
+                   " scan them again, %f seconds for %d searches (%f without"
+                   " the index).\n", scan_t, rescan_t, search_t, searches,
+                   scan_s);
+            TS_ASSERT_EQUAL_INT(found, expect);
+            //unchanged directories are not read again and the index beats
+            //scanning all entries
+            TS_ASSERT(rescan_t < scan_t / 2);
+            TS_ASSERT(search_t < scan_s);
+        }
+};
+
+int main()
+{
+    BankDbTest test;
+    RUN_TEST(testSearch);
+    RUN_TEST(testUpdate);
+    RUN_TEST(testCache);
+    RUN_TEST(testNoSave);
+    RUN_TEST(testSpeed);
+    return test_summary();
+}
@@ -0,0 +1,255 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BiquadBankTest.cpp - Test the vectorized biquad cascades
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include "../DSP/AnalogFilter.h"
+#include "../DSP/BiquadBank.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+#define FORMANTS 9
+#define SRATE 48000
+#define BUF 256
+#define BUFFERS 16
+
+class BiquadBankTest
+{
+    public:
+        float freq[FORMANTS], q[FORMANTS], amp[FORMANTS];
+        float in[BUF];
+
+        void setUp() {
+            srand(11);
+            for(int n = 0; n < FORMANTS; ++n) {
+                freq[n] = 200.0f + 450.0f * n; //whole Hz, as AnalogFilter rounds
+                q[n]    = 2.0f + n;
+                amp[n]  = 1.0f / (n + 1);
+            }
+        }
+
+        void tearDown() {}
+
+        //A filter at rest on its frequency (the first setfreq() resets the
+        //smoothing, as ModFilter and the effects do right away)
+        static AnalogFilter *analog(int type, float f, float q_, int stages) {
+            AnalogFilter *filter = new AnalogFilter(type, f, q_, stages,
+                                                    SRATE, BUF);
+            filter->setfreq(f);
+            return filter;
+        }
+
+        void noise(float *smp) {
+            for(int i = 0; i < BUF; ++i)
+                smp[i] = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+        }
+
+        //Band pass formant n of a bank, as FormantFilter sets it up
+        void load(const BiquadBank &kb, float *data, int nsections, int n,
+                  float f, float g, bool ramp) {
+            int order = 0;
+            const AnalogFilter::Coeff c = AnalogFilter::computeCoeff(
+                4, f, q[n], nsections - 1, 1.0f, SRATE, order);
+            const float values[5] = {c.c[0], c.c[1], c.c[2], c.d[1], c.d[2]};
+            for(int s = 0; s < nsections; ++s)
+                for(int v = 0; v < 5; ++v) {
+                    float &cur = data[kb.value(nsections, n, s, BiquadBank::C0 + v)];
+                    data[kb.value(nsections, n, s, BiquadBank::DC0 + v)] =
+                        ramp ? (values[v] - cur) / BUF : 0.0f;
+                    if(!ramp)
+                        cur = values[v];
+                }
+            float &gain = data[kb.header(nsections, n, BiquadBank::GAIN)];
+            data[kb.header(nsections, n, BiquadBank::DGAIN)] =
+                ramp ? (g - gain) / BUF : 0.0f;
+            if(!ramp)
+                gain = g;
+        }
+
+        //Every bank must follow parallel AnalogFilter cascades
+        void testBankMatchesAnalogFilter() {
+            const char *names[] = {"scalar", "generic", "avx2", "avx512"};
+            for(const char *name:names) {
+                const BiquadBank *kb = BiquadBank::find(name);
+                if(!kb) {
+                    printf("# %s biquad bank is not supported here\n", name);
+                    continue;
+                }
+                for(int stages = 0; stages < MAX_FILTER_STAGES; ++stages) {
+                    const int nsections = stages + 1;
+                    AnalogFilter *ref[FORMANTS];
+                    for(int n = 0; n < FORMANTS; ++n)
+                        ref[n] = analog(4, freq[n], q[n], stages);
+                    float *data = new float[kb->size(FORMANTS, nsections)]();
+                    for(int n = 0; n < FORMANTS; ++n)
+                        load(*kb, data, nsections, n, freq[n], amp[n], false);
+
+                    float maxerr = 0.0f, peak = 0.0f;
+                    for(int b = 0; b < BUFFERS; ++b) {
+                        noise(in);
+                        float expect[BUF] = {}, out[BUF] = {};
+                        for(int n = 0; n < FORMANTS; ++n) {
+                            float tmp[BUF];
+                            memcpy(tmp, in, sizeof(tmp));
+                            ref[n]->filterout(tmp);
+                            for(int i = 0; i < BUF; ++i)
+                                expect[i] += tmp[i] * amp[n];
+                        }
+                        kb->run(data, kb->groups(FORMANTS), nsections, false,
+                                in, out, BUF);
+                        for(int i = 0; i < BUF; ++i) {
+                            maxerr = fmaxf(maxerr, fabsf(expect[i] - out[i]));
+                            peak   = fmaxf(peak, fabsf(expect[i]));
+                        }
+                    }
+                    for(int n = 0; n < FORMANTS; ++n)
+                        delete ref[n];
+                    delete [] data;
+                    TS_ASSERT(peak > 1e-3f);
+                    TS_ASSERT(maxerr <= peak * 1e-3f);
+                }
+                printf("# %s biquad bank checked\n", name);
+            }
+        }
+
+        //Ramping between two stable filters stays bounded and lands on the
+        //new coefficients
+        void testRamp() {
+            const BiquadBank &kb = BiquadBank::best();
+            const int nsections = MAX_FILTER_STAGES + 1;
+            float *data = new float[kb.size(FORMANTS, nsections)]();
+            for(int n = 0; n < FORMANTS; ++n)
+                load(kb, data, nsections, n, freq[n], amp[n], false);
+
+            float peak = 0.0f;
+            bool finite = true;
+            for(int b = 0; b < BUFFERS; ++b) {
+                //sweep every formant by an octave up and down
+                for(int n = 0; n < FORMANTS; ++n)
+                    load(kb, data, nsections, n, freq[n] * (b % 2 ? 1.0f : 2.0f),
+                         amp[n] * (b % 2 ? 1.0f : 0.5f), true);
+                noise(in);
+                float out[BUF] = {};
+                kb.run(data, kb.groups(FORMANTS), nsections, true, in, out, BUF);
+                for(int i = 0; i < BUF; ++i) {
+                    finite &= std::isfinite(out[i]);
+                    peak = fmaxf(peak, fabsf(out[i]));
+                }
+            }
+            TS_ASSERT(finite);
+            TS_ASSERT(peak < 100.0f);
+
+            float drift = 0.0f;
+            for(int n = 0; n < FORMANTS; ++n) {
+                int order = 0;
+                const AnalogFilter::Coeff c = AnalogFilter::computeCoeff(
+                    4, freq[n], q[n], nsections - 1, 1.0f, SRATE, order);
+                drift = fmaxf(drift, fabsf(c.d[1] -
+                      data[kb.value(nsections, n, 0, BiquadBank::D1)]));
+                drift = fmaxf(drift, fabsf(amp[n] -
+                      data[kb.header(nsections, n, BiquadBank::GAIN)]));
+            }
+            delete [] data;
+            TS_ASSERT(drift < 1e-4f);
+        }
+
+        //The stereo pair gives exactly the outputs of two mono filters, also
+        //while the frequency glides
+        void testStereoPair() {
+            AnalogFilter *ml = analog(2, 800.0f, 3.0f, 1);
+            AnalogFilter *mr = analog(2, 900.0f, 3.0f, 1);
+            AnalogFilter *pl = analog(2, 800.0f, 3.0f, 1);
+            AnalogFilter *pr = analog(2, 900.0f, 3.0f, 1);
+            bool same = true;
+            for(int b = 0; b < BUFFERS; ++b) {
+                if(b == BUFFERS / 2) {
+                    ml->setfreq(3000.0f);
+                    pl->setfreq(3000.0f);
+                }
+                float l[BUF], r[BUF], sl[BUF], sr[BUF];
+                noise(l);
+                noise(r);
+                memcpy(sl, l, sizeof(l));
+                memcpy(sr, r, sizeof(r));
+                ml->filterout(l);
+                mr->filterout(r);
+                AnalogFilter::filterout(*pl, *pr, sl, sr);
+                same &= !memcmp(l, sl, sizeof(l)) && !memcmp(r, sr, sizeof(r));
+            }
+            delete ml;
+            delete mr;
+            delete pl;
+            delete pr;
+            TS_ASSERT(same);
+        }
+
+        void testSpeed() {
+            const int blocks = 4000;
+            const int stages = 1;
+            AnalogFilter *ref[FORMANTS];
+            for(int n = 0; n < FORMANTS; ++n)
+                ref[n] = analog(4, freq[n], q[n], stages);
+            const BiquadBank &kb = BiquadBank::best();
+            float *data = new float[kb.size(FORMANTS, stages + 1)]();
+            for(int n = 0; n < FORMANTS; ++n)
+                load(kb, data, stages + 1, n, freq[n], amp[n], false);
+            noise(in);
+            float out[BUF];
+
+            //copy, filter and accumulate every formant, as before
+            int t_on = clock();
+            for(int b = 0; b < blocks; ++b) {
+                memset(out, 0, sizeof(out));
+                for(int n = 0; n < FORMANTS; ++n) {
+                    float tmp[BUF];
+                    memcpy(tmp, in, sizeof(tmp));
+                    ref[n]->filterout(tmp);
+                    for(int i = 0; i < BUF; ++i)
+                        out[i] += tmp[i] * amp[n];
+                }
+            }
+            int t_off = clock();
+            const float serial = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+            const float check  = out[BUF - 1];
+
+            t_on = clock();
+            for(int b = 0; b < blocks; ++b) {
+                memset(out, 0, sizeof(out));
+                kb.run(data, kb.groups(FORMANTS), stages + 1, false, in, out, BUF);
+            }
+            t_off = clock();
+            const float banked = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            printf("BiquadBankTest: %f seconds per formant, %f seconds with the"
+                   " %s bank for %d formants and %d blocks.\n",
+                   serial, banked, kb.name, FORMANTS, blocks);
+
+            for(int n = 0; n < FORMANTS; ++n)
+                delete ref[n];
+            delete [] data;
+            TS_ASSERT(std::isfinite(check) && std::isfinite(out[BUF - 1]));
+        }
+};
+
+int main()
+{
+    BiquadBankTest test;
+    RUN_TEST(testBankMatchesAnalogFilter);
+    RUN_TEST(testRamp);
+    RUN_TEST(testStereoPair);
+    RUN_TEST(testSpeed);
+    return test_summary();
+}
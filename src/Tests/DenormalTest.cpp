@@ -0,0 +1,170 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  DenormalTest.cpp - Test For Flushing Denormals
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include "../Containers/NotePool.h"
+#include "../Misc/Denormals.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+//Notes of a full part with a kit, all started in the same block
+#define NOTES (POLYPHONY * EXPECTED_USAGE)
+
+class DenormalTest
+{
+    private:
+        SYNTH_T *synth;
+
+        //One pole lowpass fed with silence, its state decays into the
+        //denormal range like the tail of a filter or reverb does
+        static float decay(int samples)
+        {
+            volatile float in = 0.0f;
+            float y = 1.0f;
+            for(int i = 0; i < samples; ++i)
+                y = 0.9f * y + 0.1f * in;
+            return y;
+        }
+
+        //Render both channels of NOTES released voices, each one a one pole
+        //lowpass over a buffer that starts as a copy of in, returning the
+        //sum of their states at the end
+        float render(const float *in, int blocks)
+        {
+            const int bs = synth->buffersize;
+            float *out   = new float[bs];
+            float *state = new float[2 * NOTES];
+            for(int n = 0; n < 2 * NOTES; ++n)
+                state[n] = 1.0f;
+
+            float sum = 0.0f;
+            for(int b = 0; b < blocks; ++b)
+                for(int n = 0; n < 2 * NOTES; ++n) {
+                    memcpy(out, in, synth->bufferbytes);
+                    float y = state[n];
+                    for(int i = 0; i < bs; ++i)
+                        out[i] = y = 0.9f * y + 0.1f * out[i];
+                    state[n] = y;
+                    if(b == blocks - 1)
+                        sum += y;
+                }
+            delete [] state;
+            delete [] out;
+            return sum;
+        }
+
+    public:
+        void setUp() {
+            synth = new SYNTH_T;
+            synth->alias();
+        }
+
+        void tearDown() {
+            delete synth;
+        }
+
+        void testFlush() {
+            volatile float tiny = 1e-39f, half = 0.5f;
+            float inside;
+            {
+                DenormalGuard guard;
+                inside = tiny * half;
+            }
+            const float outside = tiny * half;
+
+            //-ffast-math builds may flush from the start of the process
+            if(getFpMode() != flushMode(getFpMode()))
+                TS_ASSERT(outside != 0.0f);
+#if ZYN_FLUSH_DENORMALS
+            TS_ASSERT(inside == 0.0f);
+            TS_ASSERT(!synth->denormalnoise);
+            bool zero = true;
+            for(int i = 0; i < synth->buffersize; ++i)
+                zero &= synth->denormalkillbuf[i] == 0.0f;
+            TS_ASSERT(zero);
+#else
+            (void)inside;
+            TS_ASSERT(synth->denormalnoise);
+#endif
+        }
+
+        void testSpeed() {
+            const int blocks = 200;
+            float *zero = new float[synth->buffersize]();
+
+            //voices fed with the denormal noise, then with silence, without
+            //and with the guard
+            int t_on = clock();
+            const float noisy = render(synth->denormalkillbuf, blocks);
+            int t_off = clock();
+            const float noise = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            t_on = clock();
+            const float silent = render(zero, blocks);
+            t_off = clock();
+            const float denormal = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            float guarded;
+            {
+                DenormalGuard guard;
+                t_on    = clock();
+                guarded = render(zero, blocks);
+                t_off   = clock();
+            }
+            const float flush = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+            delete [] zero;
+
+            printf("DenormalTest: %d voices for %d blocks, %f seconds with"
+                   " noise (%g left), %f seconds on denormals (%g left),"
+                   " %f seconds with denormals flushed (%g left).\n",
+                   2 * NOTES, blocks, noise, noisy, denormal, silent, flush,
+                   guarded);
+#if ZYN_FLUSH_DENORMALS
+            TS_ASSERT(guarded == 0.0f);
+#endif
+
+            const int samples = 10000000;
+            t_on = clock();
+            const float slow = decay(samples);
+            t_off = clock();
+            const float unflushed = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+            float fast;
+            {
+                DenormalGuard guard;
+                t_on = clock();
+                fast = decay(samples);
+                t_off = clock();
+            }
+            const float flushed = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+            printf("DenormalTest: %f seconds for a decaying filter (%g left),"
+                   " %f seconds with denormals flushed.\n", unflushed, slow,
+                   flushed);
+
+#if ZYN_FLUSH_DENORMALS
+            //the state is flushed instead of decaying through the denormals
+            TS_ASSERT(fast == 0.0f);
+#else
+            (void)fast;
+#endif
+        }
+};
+
+int main()
+{
+    DenormalTest test;
+    RUN_TEST(testFlush);
+    RUN_TEST(testSpeed);
+    return test_summary();
+}
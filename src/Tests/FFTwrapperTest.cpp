@@ -0,0 +1,83 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  FFTwrapperTest.cpp - Test the shared FFT plans and buffers
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <cstdint>
+#include "../DSP/FFTwrapper.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+#define SIZE 1024
+
+class FFTwrapperTest
+{
+    public:
+        void setUp() {}
+
+        void tearDown() {
+            FFT_cleanup();
+        }
+
+        //Wrappers of one size share their plans, so a transform of one
+        //has to be undone by the other
+        void testSharedPlans() {
+            FFTwrapper *a = new FFTwrapper(SIZE);
+            FFTwrapper *b = new FFTwrapper(SIZE);
+            FFTsampleBuffer smps = a->allocSampleBuf();
+            FFTsampleBuffer out  = b->allocSampleBuf();
+            FFTfreqBuffer  freqs = a->allocFreqBuf();
+            for(int i = 0; i < SIZE; ++i)
+                smps[i] = sinf(2 * PI * 3 * i / SIZE)
+                          + 0.5f * cosf(2 * PI * 17 * i / SIZE);
+            a->smps2freqs(smps, freqs, out);
+            delete a; //must not take the plans of b with it
+            b->freqs2smps_noconst_input(freqs, out);
+
+            float err = 0;
+            for(int i = 0; i < SIZE; ++i)
+                err = fmaxf(err, fabsf(out[i] / SIZE - smps[i]));
+            TS_ASSERT(err < 1e-4f);
+
+            FFT_freeBuffer(smps.data);
+            FFT_freeBuffer(out.data);
+            FFT_freeBuffer(freqs.data);
+            delete b;
+        }
+
+        //Released buffers come back cleared and aligned
+        void testBufferPool() {
+            FFTwrapper fft(SIZE);
+            FFTfreqBuffer freqs = fft.allocFreqBuf();
+            TS_ASSERT_EQUAL_INT(0, (int)((uintptr_t)freqs.data % 16));
+            for(int i = 0; i < freqs.allocSize(); ++i)
+                freqs[i] = fft_t(1.0f, 2.0f);
+            fft_t *old = freqs.data;
+            FFT_freeBuffer(freqs.data);
+
+            FFTfreqBuffer again = fft.allocFreqBuf();
+            TS_ASSERT(again.data == old);
+            int dirty = 0;
+            for(int i = 0; i < again.allocSize(); ++i)
+                dirty += again[i] != fft_t(0.0f, 0.0f);
+            TS_ASSERT_EQUAL_INT(0, dirty);
+            FFT_freeBuffer(again.data);
+        }
+};
+
+int main()
+{
+    FFTwrapperTest test;
+    RUN_TEST(testSharedPlans);
+    RUN_TEST(testBufferPool);
+    return test_summary();
+}
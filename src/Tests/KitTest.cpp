@@ -19,6 +19,7 @@
 #include "../Misc/Allocator.h"
 #include "../DSP/FFTwrapper.h"
 #include "../Misc/Microtonal.h"
+#include "../Misc/XMLwrapper.h"
 #define private public
 #define protected public
 #include "../Synth/SynthNote.h"
@@ -1179,6 +1180,48 @@ class KitTest
             TS_ASSERT_EQUAL_INT(pool.ndesc[3].note, 65);
         }
 
+        //Limits above the default polyphony are kept and saved
+        void testLimitsAbovePolyphony() {
+            part->Penabled = 1;
+            part->setpolyphony(300);
+            part->setkeylimit(200);
+            part->setvoicelimit(250);
+            TS_ASSERT_EQUAL_INT(part->Pkeylimit, 200);
+            TS_ASSERT_EQUAL_INT(part->Pvoicelimit, 250);
+
+            XMLwrapper xml;
+            xml.beginbranch("PART");
+            part->add2XML(xml);
+            xml.endbranch();
+
+            Part other(alloc, *synth, *time, sync, dummy, dummy, &microtonal, &fft);
+            TS_ASSERT(xml.enterbranch("PART"));
+            other.getfromXML(xml);
+            xml.exitbranch();
+            TS_ASSERT_EQUAL_INT(other.Pkeylimit, 200);
+            TS_ASSERT_EQUAL_INT(other.Pvoicelimit, 250);
+
+            //Out of range limits are clamped
+            part->setkeylimit(MAX_POLYPHONY + 1);
+            part->setvoicelimit(60000);
+            TS_ASSERT_EQUAL_INT(part->Pkeylimit, MAX_POLYPHONY);
+            TS_ASSERT_EQUAL_INT(part->Pvoicelimit, MAX_POLYPHONY);
+        }
+
+        //Without a key limit, a small polyphony keeps the note just played
+        void testSmallPolyphony() {
+            auto &pool = part->notePool;
+            for(int poly = 1; poly <= 5; ++poly) {
+                part->setpolyphony(poly);
+                part->setkeylimit(0);
+                part->NoteOn(64, 127, 0);
+                TS_ASSERT_EQUAL_INT(pool.getRunningNotes(), 1);
+                TS_ASSERT(pool.ndesc[0].playing());
+                part->monomemClear();
+                pool.killAllNotes();
+            }
+        }
+
         void testPortamentoOff(void)
         {
             auto &pool = part->notePool;
@@ -1684,6 +1727,8 @@ int main()
     RUN_TEST(testSingleKitNoLegatoYesMono);
     RUN_TEST(testKeyLimit);
     RUN_TEST(testVoiceLimit);
+    RUN_TEST(testLimitsAbovePolyphony);
+    RUN_TEST(testSmallPolyphony);
     RUN_TEST(testPortamentoOff);
     RUN_TEST(testPortamentoOnPlayingLegatoAuto);
     RUN_TEST(testPortamentoOnPlayingStaccato);
@@ -0,0 +1,92 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  MpscRingTest.cpp - Test the multiple-writer ringbuffer
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <thread>
+#include <vector>
+#include "../Containers/MpscRing.h"
+
+using namespace zyn;
+
+#define OPS 20000
+#define THREADS 4
+
+class MpscRingTest
+{
+    public:
+        void setUp() {}
+        void tearDown() {}
+
+        void testBasic(void)
+        {
+            MpscRing<int> ring(5); //rounded up to 8
+            TS_ASSERT(ring.empty());
+            TS_ASSERT(!ring.front());
+            for(int i = 0; i < 8; ++i)
+                TS_ASSERT(ring.push(i));
+            TS_ASSERT(!ring.push(8));
+            TS_ASSERT_EQUAL_INT(1, (int)ring.overflows);
+
+            //looking at an item does not take it
+            TS_ASSERT_EQUAL_INT(0, *ring.front());
+            TS_ASSERT_EQUAL_INT(0, *ring.front());
+            ring.pop();
+            TS_ASSERT(ring.push(8));
+            for(int i = 1; i <= 8; ++i) {
+                TS_ASSERT_EQUAL_INT(i, *ring.front());
+                ring.pop();
+            }
+            TS_ASSERT(ring.empty());
+        }
+
+        //Every item arrives once, in the order of its writer
+        void testThreads(void)
+        {
+            MpscRing<int> ring(64);
+            std::vector<std::thread> writers;
+            for(int t = 0; t < THREADS; ++t)
+                writers.emplace_back([&ring, t]() {
+                    for(int op = 0; op < OPS; ++op)
+                        while(!ring.push(t * OPS + op))
+                            std::this_thread::yield();
+                });
+
+            int  last[THREADS];
+            bool ordered = true;
+            for(int t = 0; t < THREADS; ++t)
+                last[t] = -1;
+            for(int n = 0; n < THREADS * OPS;) {
+                int *item = ring.front();
+                if(!item) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const int t = *item / OPS, op = *item % OPS;
+                ordered &= op == last[t] + 1;
+                last[t] = op;
+                ring.pop();
+                ++n;
+            }
+            for(auto &w:writers)
+                w.join();
+
+            TS_ASSERT(ordered);
+            TS_ASSERT(ring.empty());
+        }
+};
+
+int main()
+{
+    MpscRingTest test;
+    RUN_TEST(testBasic);
+    RUN_TEST(testThreads);
+    return test_summary();
+}
@@ -0,0 +1,242 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  NotePoolTest.cpp - Test For The Note Pool
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cstdio>
+#include <ctime>
+#include <new>
+#include "../Containers/NotePool.h"
+#include "../Misc/Allocator.h"
+#include "../Misc/Time.h"
+#include "../Params/Controller.h"
+#include "../Synth/SynthNote.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+
+//Note without any synthesis, so only the pool itself is measured
+class DummyNote:public SynthNote
+{
+    public:
+        DummyNote(const SynthParams &pars):SynthNote(pars, false) {}
+        int noteout(float *, float *) {return 1;}
+        void releasekey() {}
+        bool finished() const {return false;}
+        void entomb(void) {}
+        void legatonote(const LegatoParams &) {}
+        SynthNote *cloneLegato(void) {return NULL;}
+};
+
+class NotePoolTest
+{
+    private:
+        AllocatorClass *memory;
+        AbsTime *time;
+        Controller *ctl;
+        NotePool *pool;
+
+        NotePool::SynthDescriptor newNote(uint8_t kit)
+        {
+            SynthParams pars{*memory, *ctl, *synth, *time, 1.0f, NULL, 0.0f,
+                             false, 0};
+            return NotePool::SynthDescriptor{memory->alloc<DummyNote>(pars),
+                                             0, kit};
+        }
+
+        //One block of a part, ages the notes and removes the dying ones
+        void tick(void)
+        {
+            for(auto &d:pool->activeDesc()) {
+                d.age++;
+                if(d.dying())
+                    pool->kill(d);
+            }
+        }
+
+    public:
+        void setUp() {
+            synth  = new SYNTH_T;
+            memory = new AllocatorClass;
+            time   = new AbsTime(*synth);
+            ctl    = new Controller(*synth, time);
+            pool   = new NotePool(*memory);
+        }
+
+        void tearDown() {
+            pool->killAllNotes();
+            pool->cleanup();
+            delete pool;
+            delete ctl;
+            delete time;
+            delete memory;
+            delete synth;
+        }
+
+        void testLayout() {
+            //three kit items on one note share a descriptor
+            for(int kit=0; kit<3; ++kit)
+                pool->insertNote(60, 0, newNote(kit));
+            pool->insertNote(62, 0, newNote(0));
+            pool->insertNote(64, 0, newNote(0));
+            TS_ASSERT_EQUAL_INT(pool->usedNoteDesc(), 3);
+            TS_ASSERT_EQUAL_INT(pool->usedSynthDesc(), 5);
+            TS_ASSERT(pool->hasNote(62));
+            TS_ASSERT(!pool->hasNote(63));
+
+            //remove one synth of the first note and the second note
+            auto &first = pool->ndesc[0];
+            pool->kill(pool->activeNotes(first).begin()[1]);
+            pool->kill(pool->ndesc[1]);
+            pool->cleanup();
+
+            TS_ASSERT_EQUAL_INT(pool->usedNoteDesc(), 2);
+            TS_ASSERT_EQUAL_INT(pool->usedSynthDesc(), 3);
+            TS_ASSERT(!pool->hasNote(62));
+            TS_ASSERT_EQUAL_INT(pool->ndesc[0].note, 60);
+            TS_ASSERT_EQUAL_INT(pool->ndesc[1].note, 64);
+            TS_ASSERT_EQUAL_INT(pool->ndesc[2].status, 0);
+
+            //the key lists follow the compaction
+            int n = 0;
+            for(auto &d:pool->keyDesc(64)) {
+                TS_ASSERT(&d == &pool->ndesc[1]);
+                ++n;
+            }
+            TS_ASSERT_EQUAL_INT(n, 1);
+            pool->insertNote(60, 0, newNote(0));
+            pool->ndesc[2].age = 1;
+            pool->insertNote(60, 0, newNote(1));
+            n = 0;
+            for(auto &d:pool->keyDesc(60)) {
+                TS_ASSERT(&d == &pool->ndesc[n == 0 ? 0 : n + 1]);
+                ++n;
+            }
+            TS_ASSERT_EQUAL_INT(n, 3);
+
+            //the synths stay in the order of their notes
+            auto notes = pool->activeNotes(pool->ndesc[0]);
+            TS_ASSERT_EQUAL_INT(notes.end() - notes.begin(), 2);
+            TS_ASSERT_EQUAL_INT(notes.begin()[0].kit, 0);
+            TS_ASSERT_EQUAL_INT(notes.begin()[1].kit, 2);
+            TS_ASSERT(pool->activeNotes(pool->ndesc[1]).begin() == notes.end());
+        }
+
+        void testFull() {
+            bool early = false;
+            for(int i=0; i<POLYPHONY; ++i) {
+                early |= pool->full();
+                pool->insertNote(i, 0, newNote(0));
+            }
+            TS_ASSERT(!early);
+            TS_ASSERT(pool->full());
+
+            bool thrown = false;
+            try {
+                pool->insertNote(127, 0, newNote(0));
+            } catch(std::bad_alloc &) {
+                thrown = true;
+            }
+            TS_ASSERT(thrown);
+            TS_ASSERT_EQUAL_INT(pool->usedSynthDesc(), POLYPHONY);
+
+            pool->killNote(5);
+            TS_ASSERT(!pool->full());
+            TS_ASSERT(!pool->hasNote(5));
+        }
+
+        void testResize() {
+            TS_ASSERT_EQUAL_INT(pool->polyphony(), POLYPHONY);
+            TS_ASSERT(pool->resize(4 * POLYPHONY));
+            TS_ASSERT_EQUAL_INT(pool->polyphony(), 4 * POLYPHONY);
+
+            bool early = false;
+            for(int i=0; i<4*POLYPHONY; ++i) {
+                early |= pool->full();
+                pool->insertNote(i % 128, i / 128, newNote(0));
+            }
+            TS_ASSERT(!early);
+            TS_ASSERT(pool->full());
+            TS_ASSERT_EQUAL_INT(pool->usedNoteDesc(), 4 * POLYPHONY);
+
+            pool->killAllNotes();
+            pool->cleanup();
+            TS_ASSERT(pool->resize(8));
+            TS_ASSERT_EQUAL_INT(pool->polyphony(), 8);
+            TS_ASSERT(pool->synthFull(8 * EXPECTED_USAGE + 1));
+            TS_ASSERT(!pool->synthFull(8 * EXPECTED_USAGE));
+        }
+
+        //Fast trills on a full pool, every block has a note on and off
+        void testSpeed() {
+            const int blocks = 200000;
+            int t_on = clock(); // timer before calling func
+            for(int i = 0; i < blocks; ++i) {
+                const note_t on = 30 + (i * 7) % 64;
+                //the note which was started 40 blocks ago
+                const note_t off = 30 + ((i + 24) * 7) % 64;
+                for(auto &d:pool->keyDesc(off))
+                    if(d.note == off && d.playing())
+                        pool->release(d);
+                if(pool->full() || pool->synthFull(1))
+                    pool->enforceVoiceLimit(POLYPHONY - 1, on);
+                if(!pool->full() && !pool->synthFull(1))
+                    pool->insertNote(on, 0, newNote(0));
+                pool->enforceKeyLimit(POLYPHONY / 2);
+                tick();
+            }
+            int t_off = clock(); // timer when func returns
+
+            TS_ASSERT(pool->usedNoteDesc() <= POLYPHONY);
+            printf("NotePoolTest: %f seconds for %d note spam blocks.\n",
+                   (static_cast<float>(t_off - t_on)) / CLOCKS_PER_SEC, blocks);
+        }
+
+        //Events for keys of a full pool, found through the key lists and
+        //by scanning the pool
+        void testKeySpeed() {
+            for(int i=0; i<POLYPHONY; ++i)
+                pool->insertNote(i % 20, 0, newNote(0));
+            tick();
+
+            const int events = 1000000;
+            int found = 0;
+            int t_on = clock();
+            for(int i = 0; i < events; ++i)
+                for(auto &d:pool->keyDesc(i % 20))
+                    found += d.playing();
+            int t_off = clock();
+            const float bykey = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            t_on = clock();
+            for(int i = 0; i < events; ++i)
+                for(auto &d:pool->activeDesc())
+                    found += d.note == i % 20 && d.playing();
+            t_off = clock();
+            const float byscan = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            TS_ASSERT_EQUAL_INT(found, 2 * events * POLYPHONY / 20);
+            printf("NotePoolTest: %f seconds for %d key events, %f seconds"
+                   " scanning the pool.\n", bykey, events, byscan);
+        }
+};
+
+int main()
+{
+    NotePoolTest test;
+    RUN_TEST(testLayout);
+    RUN_TEST(testFull);
+    RUN_TEST(testResize);
+    RUN_TEST(testSpeed);
+    RUN_TEST(testKeySpeed);
+    return test_summary();
+}
@@ -0,0 +1,198 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  OfflineRenderTest.cpp - Test rendering of MIDI files
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "../Misc/Master.h"
+#include "../Misc/Config.h"
+#include "../Misc/OfflineRender.h"
+#include "../Misc/PadGenPool.h"
+#include "../Misc/Part.h"
+#include "../Params/PADnoteParameters.h"
+#include "../Misc/Util.h"
+#include "../DSP/FFTwrapper.h"
+#include "../globals.h"
+#include "../UI/NSM.H"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+NSM_Client *nsm = 0;
+char *instance_name=(char*)"";
+
+//Format 1, 96 ticks per quarter, tempo track at 60 bpm which switches to
+//120 bpm after 2 quarters, note track with running status
+static const unsigned char smf[] = {
+    'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 2, 0, 96,
+    'M', 'T', 'r', 'k', 0, 0, 0, 19,
+    0x00, 0xff, 0x51, 3, 0x0f, 0x42, 0x40,
+    0x81, 0x40, 0xff, 0x51, 3, 0x07, 0xa1, 0x20,
+    0x00, 0xff, 0x2f, 0,
+    'M', 'T', 'r', 'k', 0, 0, 0, 21,
+    0x60, 0x90, 60, 100,
+    0x00, 64, 100,
+    0x60, 60, 0,
+    0x60, 64, 0,
+    0x00, 0xb0, 7, 90,
+    0x00, 0xff, 0x2f, 0,
+};
+
+class OfflineRenderTest
+{
+    public:
+        struct FFTCleaner { ~FFTCleaner() { FFT_cleanup(); } } cleaner;
+
+        void setUp() {
+            synth = new SYNTH_T;
+            synth->buffersize = 256;
+            synth->samplerate = 48000;
+            synth->alias();
+        }
+
+        void tearDown() {
+            delete synth;
+        }
+
+        void testParse() {
+            MidiFile midi;
+            TS_ASSERT_EQUAL_INT(0, midi.parse(smf, sizeof(smf)));
+            TS_ASSERT_EQUAL_INT(5, (int)midi.events.size());
+            if(midi.events.size() != 5)
+                return;
+            TS_ASSERT_DELTA(1.0, midi.events[0].time, 1e-9);
+            TS_ASSERT_DELTA(1.0, midi.events[1].time, 1e-9);
+            TS_ASSERT_DELTA(2.0, midi.events[2].time, 1e-9);
+            TS_ASSERT_DELTA(2.5, midi.events[3].time, 1e-9);
+            TS_ASSERT_DELTA(2.5, midi.length(), 1e-9);
+            TS_ASSERT_EQUAL_INT(0x90, midi.events[1].head);
+            TS_ASSERT_EQUAL_INT(64,   midi.events[1].num);
+            TS_ASSERT_EQUAL_INT(0xb0, midi.events[4].head);
+
+            //Truncated data is rejected
+            TS_ASSERT_EQUAL_INT(-1, midi.parse(smf, sizeof(smf) - 10));
+            TS_ASSERT_EQUAL_INT(-1, midi.parse(smf + 1, sizeof(smf) - 1));
+        }
+
+        std::vector<float> render(int threads, const MidiFile *events = NULL,
+                                  bool pad = false, int keylimit = 0) {
+            Config config;
+            config.cfg.RenderThreads = threads;
+            sprng(0);
+            Master *master = new Master(*synth, &config);
+            const std::string fname = std::string(SOURCE_DIR) + "/guitar-adnote.xmz";
+            if(!events)
+                master->loadXML(fname.c_str());
+            if(keylimit)
+                master->part[0]->setkeylimit(keylimit);
+            if(pad) {
+                //a PADsynth kit item, whose samples come from the pool
+                Part *part = master->part[0];
+                part->Pkitmode = 1;
+                part->setkititemstatus(1, true);
+                part->kit[1].Padenabled  = false;
+                part->kit[1].Ppadenabled = true;
+                part->kit[1].padpars->Pquality.samplesize = 0;
+                part->applyparameters();
+            }
+
+            MidiFile midi;
+            midi.parse(smf, sizeof(smf));
+            OfflineRender render(*master);
+            render.maxtail = 2.0f;
+            std::vector<float> out;
+            render.render(events ? *events : midi, [&](const float *outl, const float *, int n) {
+                    out.insert(out.end(), outl, outl + n);
+                });
+            delete master;
+            return out;
+        }
+
+        //The notes are heard, the tail ends and the threads don't matter
+        void testRender() {
+            const std::vector<float> serial = render(1);
+            const float len = serial.size() / (float)synth->samplerate;
+            TS_ASSERT(len > 2.5f);
+            TS_ASSERT(len <= 4.5f + synth->buffersize / (float)synth->samplerate);
+
+            float sum = 0.0f;
+            for(int i = synth->samplerate; i < 2 * synth->samplerate; ++i)
+                sum += fabsf(serial[i]);
+            TS_ASSERT(sum > 0.1f);
+
+            TS_ASSERT(serial == render(4));
+        }
+
+        //PADsynth samples generated on several threads are the same in
+        //every run
+        void testPadRender() {
+            std::shared_ptr<PadGenPool> pool = PadGenPool::acquire();
+            const std::vector<float> a = render(1, NULL, true);
+            TS_ASSERT(a != render(1));
+            TS_ASSERT(a == render(1, NULL, true));
+            TS_ASSERT(a == render(4, NULL, true));
+        }
+
+        //Notes starting within a buffer sound from their exact sample on
+        //and until their very end
+        void checkOffset(const std::vector<MidiFile::Event> &events, int keylimit) {
+            const int    offset = 37;
+            const double delay  = offset / (double)synth->samplerate;
+
+            MidiFile aligned, shifted;
+            aligned.events = events;
+            shifted.events = events;
+            for(auto &e:shifted.events)
+                e.time += delay;
+            const std::vector<float> a = render(1, &aligned, false, keylimit);
+            const std::vector<float> b = render(1, &shifted, false, keylimit);
+
+            float sum = 0.0f, err = 0.0f;
+            const size_t len = std::min(a.size(), b.size()) - offset;
+            for(size_t i = 0; i < len; ++i) {
+                sum += fabsf(a[i]);
+                err  = std::max(err, fabsf(b[i + offset] - a[i]));
+            }
+            TS_ASSERT(sum > 0.1f);
+            TS_ASSERT(err < 1e-6f);
+            bool silent = true;
+            const int start = events[0].time * synth->samplerate;
+            for(int i = 0; i < start + offset; ++i)
+                silent &= b[i] == 0.0f;
+            TS_ASSERT(silent);
+        }
+
+        void testNoteOffset() {
+            const double bt = synth->buffersize / (double)synth->samplerate;
+            checkOffset({{8 * bt, 0x90, 60, 100}, {40 * bt, 0x80, 60, 0}}, 0);
+        }
+
+        //The fade-out of a note stolen by the key limit is not cut short
+        //by its start delay
+        void testStolenNoteOffset() {
+            const double bt = synth->buffersize / (double)synth->samplerate;
+            checkOffset({{8 * bt, 0x90, 60, 100}, {24 * bt, 0x90, 64, 100},
+                         {40 * bt, 0x80, 64, 0}}, 1);
+        }
+};
+
+int main()
+{
+    OfflineRenderTest test;
+    RUN_TEST(testParse);
+    RUN_TEST(testRender);
+    RUN_TEST(testPadRender);
+    RUN_TEST(testNoteOffset);
+    RUN_TEST(testStolenNoteOffset);
+    return test_summary();
+}
@@ -12,9 +12,11 @@
 */
 #include "test-suite.h"
 #include <string>
-#include "../Synth/OscilGen.h"
 #include "../Misc/XMLwrapper.h"
 #include "../DSP/FFTwrapper.h"
+#define private public
+#include "../Synth/OscilGen.h"
+#undef private
 #include "../Misc/Util.h"
 #include "../globals.h"
 using namespace std;
@@ -105,6 +107,99 @@ class OscilGenTest
             TS_ASSERT_DELTA(outR[66], 0.001293f, 0.0001f);
         }
 
+        //Notes copy the band tables instead of computing the same output
+        void testBands(void)
+        {
+            oscil->Prand              = 64;
+            oscil->Pamprandtype       = 0;
+            oscil->Padaptiveharmonics = 0;
+
+            //below the first band limit the tables are exact
+            const float low = 30.0f;
+            oscil->get(outR, low);
+            oscil->updateBands();
+            oscil->get(outL, low);
+            float err = 0.0f;
+            for(int i = 0; i < synth->oscilsize; ++i)
+                err = fmaxf(err, fabsf(outL[i] - outR[i]));
+            TS_ASSERT(err < 1e-6f);
+
+            //above they only miss harmonics within a semitone of Nyquist
+            oscil->get(outL, freq);
+            oscil->prepare(); //invalidates the tables
+            oscil->get(outR, freq);
+            err = 0.0f;
+            for(int i = 0; i < synth->oscilsize; ++i)
+                err = fmaxf(err, fabsf(outL[i] - outR[i]));
+            TS_ASSERT(err < 1e-3f);
+        }
+
+        //The mipmap levels are band tables scaled like the output of get()
+        void testMipmaps(void)
+        {
+            oscil->Prand              = 64;
+            oscil->Pamprandtype       = 0;
+            oscil->Padaptiveharmonics = 0;
+            TS_ASSERT(!oscil->hasmipmaps(freq));
+            oscil->updateBands();
+            TS_ASSERT(oscil->hasmipmaps(freq));
+            oscil->get(outL, freq);
+
+            const int nlevels = 3, top = 64;
+            float *levels[nlevels];
+            for(int l = 0; l < nlevels; ++l)
+                levels[l] = new float[synth->oscilsize];
+            oscil->getmipmaps(levels, nlevels, top, freq);
+
+            FFTsampleBuffer smps  = fft->allocSampleBuf();
+            FFTfreqBuffer   freqs = fft->allocFreqBuf();
+            memcpy(smps.data, outL, synth->oscilsize * sizeof(float));
+            fft->smps2freqs_noconst_input(smps, freqs);
+            const float fundamental = std::abs(freqs[1]);
+            TS_ASSERT(fundamental > 0.0f);
+            for(int l = 0; l < nlevels; ++l) {
+                memcpy(smps.data, levels[l], synth->oscilsize * sizeof(float));
+                fft->smps2freqs_noconst_input(smps, freqs);
+                TS_ASSERT_DELTA(std::abs(freqs[1]), fundamental,
+                                fundamental * 1e-3f);
+                float above = 0.0f;
+                for(int i = (top >> l) + 1; i < synth->oscilsize / 2; ++i)
+                    above = fmaxf(above, std::abs(freqs[i]));
+                TS_ASSERT(above < fundamental * 1e-4f);
+                delete[] levels[l];
+            }
+            FFT_freeBuffer(smps.data);
+            FFT_freeBuffer(freqs.data);
+        }
+
+        //Large oscillators use wider bands to bound the memory of the tables
+        void testBandsMemory(void)
+        {
+            const int sizes[] = {1024, 16384};
+            for(int size : sizes) {
+                SYNTH_T s;
+                s.oscilsize = size;
+                s.alias(false);
+                FFTwrapper fft(size);
+                OscilGen   osc(s, &fft, NULL);
+                osc.Prand = 64;
+                osc.updateBands();
+
+                const OscilBands *bands = osc.myBuffers().bands;
+                TS_ASSERT(bands != NULL);
+                TS_ASSERT(bands->nbands * size <= OSCIL_BANDS_SAMPLES);
+                TS_ASSERT(size == 1024 ? bands->step == 1 : bands->step > 1);
+                TS_ASSERT_EQUAL_INT(bands->band(bands->basefreq), 0);
+                TS_ASSERT(bands->band(0.45f * s.samplerate_f) >= 0);
+
+                //band b keeps the harmonics below Nyquist at its top
+                const float top = bands->basefreq
+                                  * powf(2.0f, bands->step / 12.0f);
+                TS_ASSERT_EQUAL_INT(bands->band(top * 0.999f), 1);
+                TS_ASSERT_EQUAL_INT(bands->band(top * 1.001f), 2);
+            }
+        }
+
         //performance testing
 #ifdef __linux__
         void testSpeed() {
@@ -135,6 +230,9 @@ int main()
     RUN_TEST(testInit);
     RUN_TEST(testOutput);
     RUN_TEST(testSpectrum);
+    RUN_TEST(testBands);
+    RUN_TEST(testBandsMemory);
+    RUN_TEST(testMipmaps);
 #ifdef __linux__
     RUN_TEST(testSpeed);
 #endif
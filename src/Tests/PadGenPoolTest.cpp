@@ -0,0 +1,161 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  PadGenPoolTest.cpp - Test the PADsynth sample generator threads
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <atomic>
+#include <set>
+#include <vector>
+#include "../Misc/PadGenPool.h"
+#include "../Misc/Util.h"
+#include "../Misc/Time.h"
+#include "../Params/PADnoteParameters.h"
+#include "../DSP/FFTwrapper.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+
+#define TASKS 64
+
+class PadGenPoolTest
+{
+    public:
+        struct FFTCleaner { ~FFTCleaner() { FFT_cleanup(); } } cleaner;
+
+        void setUp() {
+            synth = new SYNTH_T;
+        }
+
+        void tearDown() {
+            delete synth;
+        }
+
+        //Every task has to run exactly once per call
+        void testTaskDispatch() {
+            PadGenPool pool(4);
+            TS_ASSERT_EQUAL_INT(4, pool.threads());
+            std::atomic<int> hits[TASKS];
+            for(int round = 0; round < 10; ++round) {
+                for(auto &h:hits)
+                    h = 0;
+                pool.run(TASKS, [&hits](int task, PadGenPool::Scratch &) {
+                        hits[task]++;
+                    });
+                int wrong = 0;
+                for(auto &h:hits)
+                    wrong += h != 1;
+                TS_ASSERT_EQUAL_INT(0, wrong);
+            }
+        }
+
+        //The FFTs are planned once per worker and size
+        void testScratchReuse() {
+            PadGenPool pool(2);
+            std::mutex lock;
+            std::set<FFTwrapper*> ffts;
+            for(int round = 0; round < 4; ++round)
+                pool.run(TASKS, [&](int, PadGenPool::Scratch &scratch) {
+                        FFTwrapper *fft = scratch.fft(1024);
+                        TS_ASSERT(scratch.freqs(1024).data != NULL);
+                        std::lock_guard<std::mutex> guard(lock);
+                        ffts.insert(fft);
+                    });
+            TS_ASSERT(ffts.size() <= 2);
+        }
+
+        //Submitted jobs which run() themselves must not starve the pool
+        void testNestedJobs() {
+            PadGenPool pool(2);
+            std::atomic<int> tasks(0), jobs(0);
+            for(int i = 0; i < 8; ++i)
+                pool.submit([&](PadGenPool::Scratch &) {
+                        pool.run(TASKS, [&tasks](int, PadGenPool::Scratch &) {
+                                tasks++;
+                            });
+                        jobs++;
+                    });
+            pool.run(TASKS, [&tasks](int, PadGenPool::Scratch &) {tasks++;});
+            while(jobs != 8)
+                std::this_thread::yield();
+            TS_ASSERT_EQUAL_INT(9 * TASKS, tasks.load());
+        }
+
+        //sampleGenerator() spreads its samples over the pool of the process
+        void testSampleGenerator() {
+            std::shared_ptr<PadGenPool> pool = PadGenPool::acquire();
+            TS_ASSERT(PadGenPool::current() == pool);
+
+            AbsTime time(*synth);
+            FFTwrapper fft(synth->oscilsize);
+            PADnoteParameters pars(*synth, &fft, &time);
+            pars.Pquality.samplesize = 0;
+            std::atomic<int> hits[PAD_MAX_SAMPLES];
+            for(auto &h:hits)
+                h = 0;
+            const int n = pars.sampleGenerator(
+                    [&hits](int N, PADnoteParameters::Sample &&s) {
+                        hits[N]++;
+                        delete[] s.smp;
+                    }, []{return false;});
+            TS_ASSERT(n > 1);
+            int wrong = 0;
+            for(int i = 0; i < PAD_MAX_SAMPLES; ++i)
+                wrong += hits[i] != (i < n);
+            TS_ASSERT_EQUAL_INT(0, wrong);
+        }
+
+        //Generate the samples of pars with the random generator at seed
+        static std::vector<std::vector<float>> generate(
+                PADnoteParameters &pars, prng_t seed, unsigned max_threads) {
+            std::vector<std::vector<float>> out(PAD_MAX_SAMPLES);
+            sprng(seed);
+            pars.sampleGenerator(
+                    [&out](int N, PADnoteParameters::Sample &&s) {
+                        out[N].assign(s.smp, s.smp + s.size);
+                        delete[] s.smp;
+                    }, []{return false;}, max_threads);
+            return out;
+        }
+
+        //The random phases of a sample do not depend on the thread which
+        //generates it, so the samples are the same bit for bit
+        void testDeterministicSamples() {
+            std::shared_ptr<PadGenPool> pool = PadGenPool::acquire();
+            AbsTime time(*synth);
+            FFTwrapper fft(synth->oscilsize);
+            PADnoteParameters pars(*synth, &fft, &time);
+            pars.Pquality.samplesize = 0;
+
+            auto serial  = generate(pars, 1234, 1);
+            auto serial2 = generate(pars, 1234, 1);
+            auto pooled  = generate(pars, 1234, 0);
+            auto pooled2 = generate(pars, 1234, 0);
+            TS_ASSERT(serial[0].size() > 0 && serial[1].size() > 0);
+            TS_ASSERT(serial == serial2);
+            TS_ASSERT(serial == pooled);
+            TS_ASSERT(pooled == pooled2);
+
+            auto other = generate(pars, 4321, 0);
+            TS_ASSERT(other[0] != serial[0]);
+        }
+};
+
+int main()
+{
+    PadGenPoolTest test;
+    RUN_TEST(testTaskDispatch);
+    RUN_TEST(testScratchReuse);
+    RUN_TEST(testNestedJobs);
+    RUN_TEST(testSampleGenerator);
+    RUN_TEST(testDeterministicSamples);
+    return test_summary();
+}
@@ -279,6 +279,39 @@ class PadNoteTest
 
         }
 
+        //A replaced sample is crossfaded from once, then sent to be freed
+        void testSampleRelease() {
+            note->noteout(outL, outR);
+            const int n = note->nsample;
+            PADnoteParameters::Sample &smp = pars->sample[n];
+            float *oldsmp = smp.smp;
+            TS_ASSERT(note->playing == oldsmp);
+
+            //what the sample port does
+            const int size = smp.size;
+            pars->prevsample[n] = smp;
+            smp.smp = new float[size + PADnoteParameters::extra_samples]();
+            pars->prevpending = true;
+
+            note->noteout(outL, outR);
+            TS_ASSERT(note->playing == smp.smp);
+            TS_ASSERT(pars->prevsample[n].smp == oldsmp);
+
+            pars->releaseprevsamples(*tr);
+            TS_ASSERT(!pars->prevpending);
+            TS_ASSERT(!pars->prevsample[n].smp);
+            TS_ASSERT(tr->hasNext());
+            const char *msg = tr->read();
+            TS_ASSERT_EQUAL_STR("/free", msg);
+            TS_ASSERT(*(float**)rtosc_argument(msg, 1).b.data == oldsmp);
+            TS_ASSERT(!tr->hasNext());
+            delete[] oldsmp;
+
+            //the new sample plays on
+            note->noteout(outL, outR);
+            TS_ASSERT(note->playing == smp.smp);
+        }
+
 #define OUTPUT_PROFILE
 #ifdef OUTPUT_PROFILE
         void testSpeed() {
@@ -300,6 +333,7 @@ int main()
     PadNoteTest test;
     RUN_TEST(testDefaults);
     RUN_TEST(testInitialization);
+    RUN_TEST(testSampleRelease);
     RUN_TEST(testSpeed);
     return test_summary();
 }
@@ -0,0 +1,147 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  PadSampleCacheTest.cpp - Test the on disk PADsynth sample cache
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "../Misc/PadSampleCache.h"
+#include "../Misc/Time.h"
+#include "../Params/PADnoteParameters.h"
+#include "../DSP/FFTwrapper.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+
+class PadSampleCacheTest
+{
+    public:
+        FFTwrapper        *fft;
+        AbsTime           *time;
+        PADnoteParameters *pars;
+        char dir[64];
+
+        void setUp() {
+            synth = new SYNTH_T;
+            time  = new AbsTime(*synth);
+            fft   = new FFTwrapper(synth->oscilsize);
+            pars  = new PADnoteParameters(*synth, fft, time);
+            pars->Pquality.samplesize = 0; //keep the IFFTs small
+
+            strcpy(dir, "/tmp/zyn-pad-cache-XXXXXX");
+            TS_ASSERT(mkdtemp(dir) != NULL);
+            PadSampleCache::configure(dir, 1 << 30);
+        }
+
+        void tearDown() {
+            PadSampleCache::configure(dir, 1); //evicts every entry
+            PadSampleCache::configure("", 0);
+            rmdir(dir);
+            delete pars;
+            delete fft;
+            delete time;
+            delete synth;
+            FFT_cleanup();
+        }
+
+        //Generate the samples and keep a copy of them
+        int generate(std::vector<std::vector<float>> &out) {
+            out.assign(PAD_MAX_SAMPLES, std::vector<float>());
+            return pars->sampleGenerator([&out](int n, PADnoteParameters::Sample &&s) {
+                    out[n].assign(s.smp, s.smp + s.size + PADnoteParameters::extra_samples);
+                    delete [] s.smp;
+                }, []{return false;});
+        }
+
+        void testHitReturnsStoredSamples() {
+            std::vector<std::vector<float>> first, second;
+            const PadSampleCache::Stats before = PadSampleCache::stats();
+
+            const int n = generate(first);
+            TS_ASSERT(n > 0);
+            PadSampleCache::Stats s = PadSampleCache::stats();
+            TS_ASSERT_EQUAL_INT(1, (int)(s.misses - before.misses));
+            TS_ASSERT_EQUAL_INT(1, (int)(s.stores - before.stores));
+
+            TS_ASSERT_EQUAL_INT(n, generate(second));
+            s = PadSampleCache::stats();
+            TS_ASSERT_EQUAL_INT(1, (int)(s.hits - before.hits));
+            TS_ASSERT(first == second);
+
+            //Any change of the spectrum is another entry
+            pars->Pbandwidth += 10;
+            generate(second);
+            s = PadSampleCache::stats();
+            TS_ASSERT_EQUAL_INT(2, (int)(s.misses - before.misses));
+            TS_ASSERT_EQUAL_INT(2, (int)(s.stores - before.stores));
+            TS_ASSERT(first != second);
+        }
+
+        void testEviction() {
+            std::vector<std::vector<float>> smps;
+            generate(smps);
+            const PadSampleCache::Stats before = PadSampleCache::stats();
+            PadSampleCache::configure(dir, 1);
+            PadSampleCache::Stats s = PadSampleCache::stats();
+            TS_ASSERT(s.evictions > before.evictions);
+
+            PadSampleCache::configure(dir, 1 << 30);
+            generate(smps);
+            s = PadSampleCache::stats();
+            TS_ASSERT_EQUAL_INT(1, (int)(s.misses - before.misses));
+        }
+
+        //Temporary files of aborted writers are removed once they are old
+        void testStaleTemporaryFiles() {
+            const std::string stale = std::string(dir) + "/a.padsmp.1-0.tmp";
+            const std::string fresh = std::string(dir) + "/b.padsmp.1-1.tmp";
+            for(auto path:{stale, fresh})
+                close(open(path.c_str(), O_WRONLY | O_CREAT, 0644));
+            struct timeval old[2] = {{time(NULL) - 3600, 0},
+                                     {time(NULL) - 3600, 0}};
+            TS_ASSERT(!utimes(stale.c_str(), old));
+
+            PadSampleCache::configure(dir, 1 << 30);
+            TS_ASSERT(access(stale.c_str(), F_OK) != 0);
+            TS_ASSERT(access(fresh.c_str(), F_OK) == 0);
+            unlink(fresh.c_str());
+        }
+
+        //Generation without the cache neither loads nor stores entries
+        void testUncached() {
+            const PadSampleCache::Stats before = PadSampleCache::stats();
+            for(int i = 0; i < 2; ++i)
+                pars->sampleGenerator([](int, PADnoteParameters::Sample &&s) {
+                        delete [] s.smp;
+                    }, []{return false;}, 0, false);
+            const PadSampleCache::Stats s = PadSampleCache::stats();
+            TS_ASSERT_EQUAL_INT(0, (int)(s.stores - before.stores));
+            TS_ASSERT_EQUAL_INT(0, (int)(s.hits - before.hits));
+            TS_ASSERT_EQUAL_INT(0, (int)(s.misses - before.misses));
+        }
+};
+
+int main()
+{
+    PadSampleCacheTest test;
+    RUN_TEST(testHitReturnsStoredSamples);
+    RUN_TEST(testEviction);
+    RUN_TEST(testStaleTemporaryFiles);
+    RUN_TEST(testUncached);
+    return test_summary();
+}
@@ -0,0 +1,68 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  PluginBlockSizeTest.cpp - Test the internal block size of the plugin
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include "../Plugin/ZynAddSubFX/BlockSize.h"
+
+class PluginBlockSizeTest
+{
+    public:
+        void setUp() {}
+        void tearDown() {}
+
+        //Divisors of the host block up to the cap
+        void testDivisors() {
+            TS_ASSERT_EQUAL_INT(internalBufferSize(32), 32);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(128), 128);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(256), 128);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(1024), 128);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(8192), 128);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(480), 120);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(441), 63);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(1000), 125);
+
+            //every block size up to 8192 divides the host block or is the
+            //cap, and is never larger than it
+            bool ok = true;
+            for(uint32_t n = 1; n <= 8192; ++n) {
+                const uint32_t bs = internalBufferSize(n);
+                ok &= bs > 0 && bs <= kMaxBlockSize;
+                ok &= n % bs == 0 || bs == kMaxBlockSize;
+            }
+            TS_ASSERT(ok);
+        }
+
+        //Small host blocks and those without a divisor of at least 16
+        void testOddBlocks() {
+            TS_ASSERT_EQUAL_INT(internalBufferSize(8), 8);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(1), 1);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(127), 127);
+            TS_ASSERT_EQUAL_INT(internalBufferSize(1031), 128); //prime
+            TS_ASSERT_EQUAL_INT(internalBufferSize(0), 128);
+        }
+
+        //One internal block, in frames of the host
+        void testLatency() {
+            TS_ASSERT_EQUAL_INT(internalLatency(128, 48000, 48000), 128);
+            TS_ASSERT_EQUAL_INT(internalLatency(128, 48000, 96000), 256);
+            TS_ASSERT_EQUAL_INT(internalLatency(128, 48000, 44100), 118);
+            TS_ASSERT_EQUAL_INT(internalLatency(128, 0, 44100), 0);
+        }
+};
+
+int main()
+{
+    PluginBlockSizeTest test;
+    RUN_TEST(testDivisors);
+    RUN_TEST(testOddBlocks);
+    RUN_TEST(testLatency);
+    return test_summary();
+}
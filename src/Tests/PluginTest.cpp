@@ -262,6 +262,83 @@ class PluginTest
         }
 
 
+        static void masterChanged(void *ptr, Master *m)
+        {
+            *(Master**)ptr = m;
+        }
+
+        //A new state must not interrupt the audio of the running master
+        void testStateSwitch(void)
+        {
+            SYNTH_T s;
+            s.buffersize = 256;
+            s.samplerate = 48000;
+            s.alias();
+            MiddleWare mw(std::move(s), &config);
+            Master *m = mw.spawnMaster();
+            Master *const old = m;
+            m->setMasterChangedCallback(masterChanged, &m);
+
+            const string data = loadfile(string(SOURCE_DIR) + "/guitar-adnote.xmz");
+            mw.loadMasterData(data.c_str());
+            TS_ASSERT(m == old);
+            TS_ASSERT(mw.spawnMaster() != old);
+
+            //more than one buffer, so the new master continues the call
+            float *l = new float[1000], *r = new float[1000];
+            for(int i = 0; i < 1000; ++i)
+                l[i] = r[i] = NAN;
+            m->GetAudioOutSamples(1000, 48000, l, r);
+            TS_ASSERT(m == mw.spawnMaster());
+
+            bool written = true;
+            for(int i = 0; i < 1000; ++i)
+                written &= !std::isnan(l[i]) && !std::isnan(r[i]);
+            TS_ASSERT(written);
+
+            mw.tick(); //frees the old master
+            delete[] l;
+            delete[] r;
+        }
+
+        //A separated part is only heard on its own output
+        void testPartOutputs(void)
+        {
+            master[0]->loadXML((string(SOURCE_DIR) + "/guitar-adnote.xmz").c_str());
+            master[0]->separateOut[0] = true;
+            master[0]->noteOn(0, 64, 100);
+
+            float *l = new float[1000], *r = new float[1000];
+            float *bus[2 * NUM_MIDI_PARTS];
+            for(int i = 0; i < 2 * NUM_MIDI_PARTS; ++i)
+                bus[i] = new float[1000];
+            float *rest[2 * NUM_MIDI_PARTS];
+            for(int i = 0; i < 2 * NUM_MIDI_PARTS; ++i)
+                rest[i] = bus[i] + 300;
+
+            //pieces which don't fit the buffer size
+            master[0]->GetAudioOutSamples(300, synth->samplerate, l, r,
+                    0, 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, false, 0, bus);
+            master[0]->GetAudioOutSamples(700, synth->samplerate, l + 300,
+                    r + 300, 0, 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, false, 0,
+                    rest);
+
+            float main = 0.0f, part = 0.0f, other = 0.0f;
+            for(int i = 0; i < 1000; ++i) {
+                main  += fabsf(l[i]) + fabsf(r[i]);
+                part  += fabsf(bus[0][i]) + fabsf(bus[1][i]);
+                other += fabsf(bus[2][i]) + fabsf(bus[3][i]);
+            }
+            TS_ASSERT(main == 0.0f);
+            TS_ASSERT(part > 0.1f);
+            TS_ASSERT(other == 0.0f);
+
+            delete[] l;
+            delete[] r;
+            for(int i = 0; i < 2 * NUM_MIDI_PARTS; ++i)
+                delete[] bus[i];
+        }
+
     private:
         float *outR, *outL;
         Master *master[16];
@@ -273,5 +350,7 @@ int main()
     RUN_TEST(testInit);
     RUN_TEST(testPanic);
     RUN_TEST(testLoadSave);
+    RUN_TEST(testStateSwitch);
+    RUN_TEST(testPartOutputs);
     return test_summary();
 }
@@ -0,0 +1,140 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  RenderPoolTest.cpp - Test parallel rendering of parts
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <atomic>
+#include <cmath>
+#include <string>
+#include "../Misc/Master.h"
+#include "../Misc/Config.h"
+#include "../Misc/RenderPool.h"
+#include "../Misc/Util.h"
+#include "../DSP/FFTwrapper.h"
+#include "../globals.h"
+#include "../UI/NSM.H"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+NSM_Client *nsm = 0;
+char *instance_name=(char*)"";
+
+#define BUFFERS 200
+
+static std::atomic<int> hits[64];
+
+static void countJob(void *, int job)
+{
+    hits[job]++;
+}
+
+class RenderPoolTest
+{
+    public:
+        struct FFTCleaner { ~FFTCleaner() { FFT_cleanup(); } } cleaner;
+
+        void setUp() {
+            synth = new SYNTH_T;
+            synth->buffersize = 256;
+            synth->samplerate = 48000;
+            synth->alias();
+        }
+
+        void tearDown() {
+            delete synth;
+        }
+
+        //Every job has to run exactly once per call
+        void testJobDispatch() {
+            RenderPool pool(4);
+            TS_ASSERT_EQUAL_INT(4, pool.threads());
+            for(int i = 0; i < 64; ++i)
+                hits[i] = 0;
+            for(int run = 0; run < 1000; ++run)
+                pool.run(countJob, nullptr, 1 + run % 64);
+
+            int expected[64] = {};
+            for(int run = 0; run < 1000; ++run)
+                for(int i = 0; i < 1 + run % 64; ++i)
+                    expected[i]++;
+            bool ok = true;
+            for(int i = 0; i < 64; ++i)
+                ok &= (hits[i] == expected[i]);
+            TS_ASSERT(ok);
+        }
+
+        //Render a few buffers of a multitimbral setup
+        //(or of a chord on a single part, which spreads its notes instead)
+        void render(int threads, float *outl, float *outr, int parts = 8) {
+            Config config;
+            config.cfg.RenderThreads = threads;
+            sprng(0xfeed);
+            Master *master = new Master(*synth, &config);
+            const std::string fname = std::string(SOURCE_DIR) + "/guitar-adnote.xmz";
+            master->loadXML(fname.c_str());
+            for(int npart = 0; npart < parts; ++npart) {
+                master->partonoff(npart, 1);
+                master->part[npart]->Prcvchn = npart;
+            }
+
+            for(int i = 0; i < BUFFERS; ++i) {
+                if(i % 20 == 0)
+                    for(int n = 0; n < 8; ++n)
+                        master->noteOn(n % parts, 40 + n * 3 + i / 20, 100);
+                if(i % 20 == 10)
+                    for(int n = 0; n < 8; ++n)
+                        master->noteOff(n % parts, 40 + n * 3 + i / 20);
+                master->AudioOut(outl + i * synth->buffersize,
+                                 outr + i * synth->buffersize);
+            }
+            delete master;
+        }
+
+        //The parallel path must not change a single sample
+        void checkEquivalence(int parts) {
+            const int len = BUFFERS * synth->buffersize;
+            float *serl = new float[len], *serr = new float[len];
+            float *parl = new float[len], *parr = new float[len];
+
+            render(1, serl, serr, parts);
+            render(4, parl, parr, parts);
+
+            TS_ASSERT(!memcmp(serl, parl, len * sizeof(float)));
+            TS_ASSERT(!memcmp(serr, parr, len * sizeof(float)));
+
+            float sum = 0.0f;
+            for(int i = 0; i < len; ++i)
+                sum += fabsf(serl[i]);
+            TS_ASSERT(sum > 0.1f);
+
+            delete [] serl;
+            delete [] serr;
+            delete [] parl;
+            delete [] parr;
+        }
+
+        void testSerialEquivalence() {
+            checkEquivalence(8);
+        }
+
+        void testNoteEquivalence() {
+            checkEquivalence(1);
+        }
+};
+
+int main()
+{
+    RenderPoolTest test;
+    RUN_TEST(testJobDispatch);
+    RUN_TEST(testSerialEquivalence);
+    RUN_TEST(testNoteEquivalence);
+    return test_summary();
+}
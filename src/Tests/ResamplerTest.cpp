@@ -0,0 +1,92 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  ResamplerTest.cpp - Test the output sample rate conversion
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "../DSP/Resampler.h"
+
+using namespace zyn;
+
+#define BUFFERSIZE 256
+
+class ResamplerTest
+{
+    public:
+        void setUp() {}
+        void tearDown() {}
+
+        //Convert a second of a sine, the output is read in pieces of chunk
+        std::vector<float> convert(unsigned src, unsigned dst, double freq,
+                                   int chunk) {
+            Resampler resampler(src, dst, BUFFERSIZE);
+            std::vector<float> out, inl(BUFFERSIZE), inr(BUFFERSIZE);
+            std::vector<float> outl(chunk), outr(chunk);
+            long t = 0;
+            bool stereo = true;
+            while(out.size() < dst) {
+                const int n = std::min(chunk, resampler.available());
+                if(n) {
+                    resampler.read(outl.data(), outr.data(), n);
+                    out.insert(out.end(), outl.begin(), outl.begin() + n);
+                    stereo &= std::equal(outl.begin(), outl.begin() + n,
+                                         outr.begin());
+                    continue;
+                }
+                for(int i = 0; i < BUFFERSIZE; ++i)
+                    inl[i] = inr[i] = 0.5 * sin(2 * M_PI * freq * (t + i) / src);
+                t += BUFFERSIZE;
+                resampler.write(inl.data(), inr.data(), BUFFERSIZE);
+            }
+            TS_ASSERT(stereo);
+            out.resize(dst);
+            return out;
+        }
+
+        //A tone in the passband comes out in time with the input
+        void testPassband() {
+            const unsigned rates[][2] = {{48000, 44100}, {44100, 48000},
+                                         {44100, 96000}, {96000, 44100}};
+            for(auto &r:rates) {
+                const std::vector<float> out = convert(r[0], r[1], 1000.0, 64);
+                float err = 0.0f;
+                for(unsigned i = 1000; i < r[1]; ++i)
+                    err = std::max(err, fabsf(out[i] -
+                                   (float)(0.5 * sin(2 * M_PI * 1000.0 * i / r[1]))));
+                TS_ASSERT(err < 1e-4f);
+            }
+        }
+
+        //Content above the new Nyquist frequency is removed
+        void testStopband() {
+            const std::vector<float> out = convert(96000, 44100, 26000.0, 64);
+            float peak = 0.0f;
+            for(unsigned i = 1000; i < out.size(); ++i)
+                peak = std::max(peak, fabsf(out[i]));
+            TS_ASSERT(peak < 1e-3f);
+        }
+
+        //The result doesn't depend on how the output is requested
+        void testStreaming() {
+            TS_ASSERT(convert(48000, 44100, 3000.0, 1) ==
+                      convert(48000, 44100, 3000.0, 1000));
+        }
+};
+
+int main()
+{
+    ResamplerTest test;
+    RUN_TEST(testPassband);
+    RUN_TEST(testStopband);
+    RUN_TEST(testStreaming);
+    return test_summary();
+}
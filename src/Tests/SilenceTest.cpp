@@ -0,0 +1,146 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  SilenceTest.cpp - Test idle parts and finished note tails
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <string>
+#include "../Misc/Config.h"
+#include "../Misc/Util.h"
+#include "../DSP/FFTwrapper.h"
+#include "../globals.h"
+#include "../UI/NSM.H"
+#define private public
+#include "../Misc/Master.h"
+#include "../Misc/Part.h"
+#include "../Params/ADnoteParameters.h"
+#include "../Params/EnvelopeParams.h"
+#undef private
+
+using namespace zyn;
+
+SYNTH_T *synth;
+NSM_Client *nsm = 0;
+char *instance_name=(char*)"";
+
+class SilenceTest
+{
+    public:
+        struct FFTCleaner { ~FFTCleaner() { FFT_cleanup(); } } cleaner;
+        Config  config;
+        Master *master;
+        Part   *part;
+        float  *outl, *outr;
+
+        void setUp() {
+            synth = new SYNTH_T;
+            synth->buffersize = 256;
+            synth->samplerate = 48000;
+            synth->alias();
+            outl = new float[synth->buffersize];
+            outr = new float[synth->buffersize];
+
+            config.cfg.RenderThreads = 1;
+            master = new Master(*synth, &config);
+            part   = master->part[0];
+            TS_ASSERT(part->Penabled);
+
+            //a quiet note with a release of 10 seconds
+            auto &global = part->kit[0].adpars->GlobalPar;
+            global.Volume = -47.9588f;
+            global.AmpEnvelope->ADSRinit(0.0f, 0.1f, 127, 10.0f);
+        }
+
+        void tearDown() {
+            delete master;
+            delete [] outl;
+            delete [] outr;
+            delete synth;
+        }
+
+        //Buffers rendered in a time
+        int buffers(float seconds) {
+            return seconds * synth->samplerate_f / synth->buffersize_f;
+        }
+
+        //Render, returning the peak of the output
+        float render(int n) {
+            float peak = 0.0f;
+            for(int i = 0; i < n; ++i) {
+                master->AudioOut(outl, outr);
+                for(int j = 0; j < synth->buffersize; ++j)
+                    peak = std::max(peak, std::max(fabsf(outl[j]),
+                                                   fabsf(outr[j])));
+            }
+            return peak;
+        }
+
+        //A part without notes goes idle after the hold time
+        void testIdle() {
+            master->silenceHold = 0.1f;
+            render(1);
+            TS_ASSERT(!part->idle);
+            render(buffers(0.1f) + 1);
+            TS_ASSERT(part->idle);
+        }
+
+        //A note wakes an idle part up
+        void testWake() {
+            master->silenceHold = 0.1f;
+            render(buffers(0.1f) + 1);
+            TS_ASSERT(part->idle);
+
+            master->noteOn(0, 64, 100);
+            const float peak = render(1);
+            TS_ASSERT(!part->idle);
+            TS_ASSERT(peak > 0.0f);
+            TS_ASSERT_EQUAL_INT(part->notePool.usedNoteDesc(), 1);
+        }
+
+        //A released note below the threshold for 50 ms is finished, a held
+        //one is not
+        void testTail() {
+            master->silenceThreshold = -40.0f;
+            master->noteOn(0, 64, 100);
+            render(buffers(0.2f));
+            TS_ASSERT_EQUAL_INT(part->notePool.usedNoteDesc(), 1);
+
+            master->noteOff(0, 64);
+            render(buffers(0.04f));
+            TS_ASSERT_EQUAL_INT(part->notePool.usedNoteDesc(), 1);
+            render(buffers(0.02f) + 1);
+            TS_ASSERT_EQUAL_INT(part->notePool.usedNoteDesc(), 0);
+        }
+
+        //-200 dB turns both off
+        void testDisabled() {
+            master->silenceThreshold = -200.0f;
+            master->silenceHold      = 0.1f;
+            render(buffers(0.5f));
+            TS_ASSERT(!part->idle);
+
+            master->noteOn(0, 64, 100);
+            render(buffers(0.2f));
+            master->noteOff(0, 64);
+            render(buffers(0.5f));
+            TS_ASSERT_EQUAL_INT(part->notePool.usedNoteDesc(), 1);
+            TS_ASSERT(!part->idle);
+        }
+};
+
+int main()
+{
+    SilenceTest test;
+    RUN_TEST(testIdle);
+    RUN_TEST(testWake);
+    RUN_TEST(testTail);
+    RUN_TEST(testDisabled);
+    return test_summary();
+}
@@ -0,0 +1,138 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  SubFilterBankTest.cpp - Test the vectorized SUBnote filter bank
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "../Synth/SubFilterBank.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+#define HARMONICS 13
+#define BUF 256
+#define BUFFERS 16
+
+//One band pass per harmonic and stage, as SUBnote sets them up
+struct Biquad {
+    float b0, b2, a1, a2;
+    float xn1, xn2, yn1, yn2;
+};
+
+class SubFilterBankTest
+{
+    public:
+        Biquad filters[HARMONICS][MAX_FILTER_STAGES];
+        float  gain[HARMONICS];
+        float  in[BUF];
+
+        void setUp() {
+            srand(7);
+            for(int n = 0; n < HARMONICS; ++n) {
+                gain[n] = 1.0f / (n + 1);
+                const float omega = 2.0f * PI * 110.0f * (n + 1) / 48000.0f;
+                const float alpha = sinf(omega) * 0.01f;
+                for(int s = 0; s < MAX_FILTER_STAGES; ++s) {
+                    Biquad &f = filters[n][s];
+                    const float a0 = 1.0f + alpha;
+                    f.b0  = alpha / a0;
+                    f.b2  = -alpha / a0;
+                    f.a1  = -2.0f * cosf(omega) / a0;
+                    f.a2  = (1.0f - alpha) / a0;
+                    f.xn1 = f.xn2 = 0.0f;
+                    f.yn1 = 0.01f * n;
+                    f.yn2 = 0.0f;
+                }
+            }
+        }
+
+        void tearDown() {}
+
+        //Straight per harmonic cascades, as in SUBnote::chanOutput
+        void reference(Biquad (*bp)[MAX_FILTER_STAGES], int nstages, float *out) {
+            for(int n = 0; n < HARMONICS; ++n) {
+                float tmp[BUF];
+                memcpy(tmp, in, sizeof(tmp));
+                for(int s = 0; s < nstages; ++s) {
+                    Biquad &f = bp[n][s];
+                    for(int i = 0; i < BUF; ++i) {
+                        const float y = tmp[i] * f.b0 + f.xn2 * f.b2
+                                      - f.yn1 * f.a1 - f.yn2 * f.a2;
+                        f.xn2 = f.xn1;
+                        f.xn1 = tmp[i];
+                        f.yn2 = f.yn1;
+                        f.yn1 = y;
+                        tmp[i] = y;
+                    }
+                }
+                for(int i = 0; i < BUF; ++i)
+                    out[i] += tmp[i] * gain[n];
+            }
+        }
+
+        void bank(const SubFilterBank &fb, float *data, int nstages, float *out) {
+            fb.run(data, fb.groups(HARMONICS), nstages, in, out, BUF);
+        }
+
+        //Every bank must follow the plain filters over many buffers
+        void testBankMatchesFilters() {
+            const char *names[] = {"generic", "avx2", "avx512"};
+            for(const char *name:names) {
+                const SubFilterBank *fb = SubFilterBank::find(name);
+                if(!fb) {
+                    printf("# %s filter bank is not supported here\n", name);
+                    continue;
+                }
+                for(int nstages = 1; nstages <= MAX_FILTER_STAGES; ++nstages) {
+                    Biquad bp[HARMONICS][MAX_FILTER_STAGES];
+                    memcpy(bp, filters, sizeof(bp));
+                    const int size = fb->size(HARMONICS, nstages);
+                    float *data = new float[size]();
+                    for(int n = 0; n < HARMONICS; ++n) {
+                        data[fb->gain(nstages, n)] = gain[n];
+                        for(int s = 0; s < nstages; ++s) {
+                            const Biquad &f = bp[n][s];
+                            data[fb->value(nstages, n, s, SubFilterBank::B0)]  = f.b0;
+                            data[fb->value(nstages, n, s, SubFilterBank::B2)]  = f.b2;
+                            data[fb->value(nstages, n, s, SubFilterBank::NA1)] = -f.a1;
+                            data[fb->value(nstages, n, s, SubFilterBank::NA2)] = -f.a2;
+                            data[fb->value(nstages, n, s, SubFilterBank::YN1)] = f.yn1;
+                        }
+                    }
+
+                    float maxerr = 0.0f, peak = 0.0f;
+                    for(int b = 0; b < BUFFERS; ++b) {
+                        for(int i = 0; i < BUF; ++i)
+                            in[i] = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+                        float ref[BUF] = {}, out[BUF] = {};
+                        reference(bp, nstages, ref);
+                        bank(*fb, data, nstages, out);
+                        for(int i = 0; i < BUF; ++i) {
+                            maxerr = fmaxf(maxerr, fabsf(ref[i] - out[i]));
+                            peak   = fmaxf(peak, fabsf(ref[i]));
+                        }
+                    }
+                    delete [] data;
+                    TS_ASSERT(peak > 1e-4f);
+                    TS_ASSERT(maxerr <= peak * 1e-4f);
+                }
+                printf("# %s filter bank checked\n", name);
+            }
+        }
+};
+
+int main()
+{
+    SubFilterBankTest test;
+    RUN_TEST(testBankMatchesFilters);
+    return test_summary();
+}
@@ -0,0 +1,125 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  UnisonKernelTest.cpp - Test the vectorized unison kernels
+  Copyright (C) 2026 ZynAddSubFX developers
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cstdlib>
+#include <cstring>
+#include "../Synth/UnisonKernels.h"
+
+using namespace zyn;
+
+#define OSCILSIZE 1024
+#define MAX_UNISON 11
+#define BUFFERS 8
+
+static float frand(void)
+{
+    return rand() / (float)RAND_MAX;
+}
+
+class UnisonKernelTest
+{
+    public:
+        float smps[OSCILSIZE + 1];
+        int   freqhi[MAX_UNISON];
+        float freqlo[MAX_UNISON];
+        float lvol[MAX_UNISON], rvol[MAX_UNISON];
+
+        void setUp() {
+            srand(42);
+            for(int i = 0; i < OSCILSIZE; ++i)
+                smps[i] = frand() * 2.0f - 1.0f;
+            smps[OSCILSIZE] = smps[0];
+            for(int k = 0; k < MAX_UNISON; ++k) {
+                freqhi[k] = rand() % 40;
+                freqlo[k] = frand() * 0.999f;
+                lvol[k]   = frand() * 2.0f - 1.0f;
+                rvol[k]   = frand() * 2.0f - 1.0f;
+            }
+        }
+
+        void tearDown() {}
+
+        //Render some buffers with one kernel set and return all of the state
+        void run(const UnisonKernels &kern, int nunison, int bufsize,
+                 float *wave, float *outl, float *outr) {
+            int   poshi[MAX_UNISON];
+            float poslo[MAX_UNISON];
+            float *tw[MAX_UNISON];
+            for(int k = 0; k < nunison; ++k) {
+                poshi[k] = (k * 97) % OSCILSIZE;
+                poslo[k] = k / (float)MAX_UNISON;
+            }
+            for(int b = 0; b < BUFFERS; ++b) {
+                for(int k = 0; k < nunison; ++k)
+                    tw[k] = wave + (b * MAX_UNISON + k) * bufsize;
+                memset(outl + b * bufsize, 0, bufsize * sizeof(float));
+                memset(outr + b * bufsize, 0, bufsize * sizeof(float));
+                kern.oscLinear(smps, OSCILSIZE, poshi, poslo, freqhi, freqlo,
+                               tw, nunison, bufsize);
+                kern.mix(tw, nunison, lvol, rvol,
+                         outl + b * bufsize, outr + b * bufsize, bufsize);
+            }
+        }
+
+        //Every kernel set must match the scalar one bit for bit
+        void testKernelsMatchScalar() {
+            const UnisonKernels &scalar = *UnisonKernels::find("scalar");
+            const char *names[] = {"sse2", "avx2", "neon"};
+            const int sizes[] = {256, 37};
+            const int len = BUFFERS * MAX_UNISON * 256;
+            float *wave0 = new float[len], *wave1 = new float[len];
+            float *l0 = new float[len], *r0 = new float[len];
+            float *l1 = new float[len], *r1 = new float[len];
+
+            for(const char *name:names) {
+                const UnisonKernels *kern = UnisonKernels::find(name);
+                if(!kern) {
+                    printf("# %s kernels are not supported here\n", name);
+                    continue;
+                }
+                bool ok = true;
+                for(int bufsize:sizes)
+                    for(int nunison = 1; nunison <= MAX_UNISON; ++nunison) {
+                        run(scalar, nunison, bufsize, wave0, l0, r0);
+                        run(*kern,  nunison, bufsize, wave1, l1, r1);
+                        for(int b = 0; b < BUFFERS; ++b)
+                            ok &= !memcmp(wave0 + b * MAX_UNISON * bufsize,
+                                          wave1 + b * MAX_UNISON * bufsize,
+                                          nunison * bufsize * sizeof(float));
+                        ok &= !memcmp(l0, l1, BUFFERS * bufsize * sizeof(float));
+                        ok &= !memcmp(r0, r1, BUFFERS * bufsize * sizeof(float));
+                    }
+                printf("# %s kernels checked\n", name);
+                TS_ASSERT(ok);
+            }
+
+            delete [] wave0;
+            delete [] wave1;
+            delete [] l0;
+            delete [] r0;
+            delete [] l1;
+            delete [] r1;
+        }
+
+        void testBestIsSupported() {
+            const UnisonKernels &best = UnisonKernels::best();
+            TS_ASSERT(UnisonKernels::find(best.name) == &best);
+        }
+};
+
+int main()
+{
+    UnisonKernelTest test;
+    RUN_TEST(testKernelsMatchScalar);
+    RUN_TEST(testBestIsSupported);
+    return test_summary();
+}
@@ -176,11 +176,93 @@ class UnisonTest
             TS_ASSERT_DELTA(outL[255], 0.149882f, 0.0001f);
 #endif
         }
+
+        //Rendering of a voice with the given antialiasing (-1 = off)
+        void render(int aa, int unison, float freq_log2, float *out, int bufs)
+        {
+            sprng(0);
+            params->VoicePar[0].Unison_size = unison;
+            params->VoicePar[0].PAAEnabled  = aa >= 0;
+            params->VoicePar[0].PAAType     = aa >= 0 ? aa : 0;
+            //the mipmaps are copied from the band tables
+            if(aa == 1)
+                params->applyparameters();
+
+            SynthParams pars{memory, *controller, *synth, *time, 120, 0, freq_log2, false, prng()};
+            ADnote* note = new ADnote(params, pars, nullptr, nullptr, false);
+            for(int i = 0; i < bufs; ++i) {
+                note->noteout(outL, outR);
+                if(out)
+                    memcpy(out + i * BUF, outL, sizeof(outL));
+            }
+            delete note;
+        }
+
+        //Energy between the harmonics relative to the total energy
+        float aliasing(int aa)
+        {
+            const int size = 4096, settle = 64, cycles = 203;
+            FFTwrapper dft(size);
+            FFTsampleBuffer smps = dft.allocSampleBuf();
+            FFTfreqBuffer freqs  = dft.allocFreqBuf();
+
+            //one octave above the base frequency the oscillator has twice the
+            //harmonics it could play without aliasing, with the bend the
+            //note plays a whole number of cycles in the DFT size
+            controller->pitchwheel.bendrange = 2400;
+            controller->setpitchwheel(4096);
+            float *out = new float[(settle + size / BUF) * BUF];
+            render(aa, 1, log2f(synth->samplerate_f * cycles / size / 2.0f),
+                   out, settle + size / BUF);
+            controller->setpitchwheel(0);
+            memcpy(smps.data, out + settle * BUF, size * sizeof(float));
+            delete [] out;
+
+            dft.smps2freqs_noconst_input(smps, freqs);
+            double total = 0.0, between = 0.0;
+            for(int i = 1; i < size / 2; ++i) {
+                const double e = std::norm(freqs[i]);
+                const int    h = i % cycles;
+                total += e;
+                if(h > 3 && h < cycles - 3)
+                    between += e;
+            }
+            FFT_freeBuffer(smps.data);
+            FFT_freeBuffer(freqs.data);
+            return between / total;
+        }
+
+        void testAntiAliasing() {
+            const float off    = aliasing(-1);
+            const float sinc   = aliasing(0);
+            const float mipmap = aliasing(1);
+            printf("UnisonTest: aliasing %.1f dB without antialiasing, "
+                   "%.1f dB with sinc, %.1f dB with mipmaps\n",
+                   10 * log10f(off), 10 * log10f(sinc), 10 * log10f(mipmap));
+            TS_ASSERT(mipmap < off / 1000.0f);
+            TS_ASSERT(mipmap <= sinc);
+        }
+
+        void testAntiAliasingSpeed() {
+            const int bufs = 2000;
+            const char *names[] = {"off", "sinc", "mipmap"};
+            for(int aa = -1; aa <= 1; ++aa) {
+                int t_on = clock();
+                render(aa, 50, test_freq_log2, nullptr, bufs);
+                int t_off = clock();
+                printf("UnisonTest: %f seconds for %d buffers of 50 subvoices "
+                       "with antialiasing %s\n",
+                       (t_off - t_on) / (float)CLOCKS_PER_SEC, bufs,
+                       names[aa + 1]);
+            }
+        }
 };
 
 int main()
 {
     UnisonTest test;
     RUN_TEST(testUnison);
+    RUN_TEST(testAntiAliasing);
+    RUN_TEST(testAntiAliasingSpeed);
     return test_summary();
 }
@@ -12,7 +12,13 @@
 */
 #include "test-suite.h"
 #include "../Misc/XMLwrapper.h"
+#include "../Misc/XMLimage.h"
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <unistd.h>
 #include "../globals.h"
 using namespace std;
 using namespace zyn;
@@ -51,6 +57,218 @@ version-revision=\"1\" ZynAddSubFX-author=\"Nasca Octavian Paul\">\n\
             xmlb->putXMLdata(dat.c_str());
         }
 
+        //A branch with repeated names and ids
+        static void fill(XMLwrapper *xml) {
+            xml->beginbranch("BRANCH");
+            xml->addpar("x", 1);
+            xml->addpar("x", 2);
+            xml->addparbool("b", 1);
+            xml->addparreal("r", 0.25f);
+            xml->addparstr("s", "text");
+            xml->beginbranch("VOICE", 3);
+            xml->addpar("x", 5);
+            xml->endbranch();
+            xml->beginbranch("VOICE", 4);
+            xml->endbranch();
+            xml->endbranch();
+        }
+
+        //Reads the first of equal children, in and out of order
+        static void check(XMLwrapper *xml) {
+            TS_ASSERT(xml->enterbranch("BRANCH"));
+            TS_ASSERT_EQUAL_INT(xml->getpar("x", 0, 0, 127), 1);
+            TS_ASSERT_EQUAL_INT(xml->getpar("b", 9, 0, 127), 9);
+            TS_ASSERT(xml->getparstr("s", "") == "text");
+            TS_ASSERT(xml->getparbool("b", false));
+            TS_ASSERT(xml->getparreal("r", 0.0f) == 0.25f);
+            TS_ASSERT(xml->hasparreal("r"));
+            TS_ASSERT(!xml->enterbranch("VOICE", 5));
+            TS_ASSERT(xml->enterbranch("VOICE", 4));
+            TS_ASSERT_EQUAL_INT(xml->getpar("x", 9, 0, 127), 9);
+            xml->exitbranch();
+            TS_ASSERT(xml->enterbranch("VOICE"));
+            TS_ASSERT_EQUAL_INT(xml->getbranchid(0, 0), 3);
+            TS_ASSERT_EQUAL_INT(xml->getpar("x", 9, 0, 127), 5);
+            xml->exitbranch();
+            TS_ASSERT_EQUAL_INT(xml->getpar("x", 0, 0, 127), 1);
+            TS_ASSERT_EQUAL_INT((int)xml->getBranch().size(), 7);
+            xml->exitbranch();
+        }
+
+        static string tmpfile(void) {
+            char path[] = "/tmp/zyn-xml-XXXXXX";
+            close(mkstemp(path));
+            return path;
+        }
+
+        static string readfile(const string &path) {
+            ifstream file(path, ios::binary);
+            return string(istreambuf_iterator<char>(file),
+                          istreambuf_iterator<char>());
+        }
+
+        //The index finds what a scan of the branch found
+        void testIndexedLookup() {
+            fill(xmla);
+            char *data = xmla->getXMLdata();
+            TS_ASSERT(xmlb->putXMLdata(data));
+            free(data);
+            check(xmlb);
+
+            //adding to a branch after a lookup
+            TS_ASSERT_EQUAL_INT(xmla->getpar("late", 9, 0, 127), 9);
+            xmla->addpar("late", 7);
+            TS_ASSERT_EQUAL_INT(xmla->getpar("late", 9, 0, 127), 7);
+        }
+
+        //Images read like the XML and convert to it and back without losses
+        void testBinaryImage() {
+            fill(xmla);
+            const string image = tmpfile(), again = tmpfile();
+            TS_ASSERT_EQUAL_INT(xmla->saveBinaryfile(image), 0);
+            TS_ASSERT_EQUAL_INT(xmlb->loadXMLfile(image), 0);
+            TS_ASSERT(!(xmlb->fileversion() < version) && !(version < xmlb->fileversion()));
+            check(xmlb);
+
+            char *data = xmlb->getXMLdata();
+            XMLwrapper xmlc;
+            TS_ASSERT(xmlc.putXMLdata(data));
+            free(data);
+            check(&xmlc);
+            TS_ASSERT_EQUAL_INT(xmlc.saveBinaryfile(again), 0);
+            const string bytes = readfile(image);
+            TS_ASSERT(!bytes.empty() && bytes == readfile(again));
+
+            //Saving over a mapped image replaces the file, the mapping
+            //keeps the old contents
+            XMLwrapper empty;
+            TS_ASSERT_EQUAL_INT(empty.saveBinaryfile(image), 0);
+            check(xmlb);
+            TS_ASSERT(readfile(image) != bytes);
+
+            XMLimage broken;
+            TS_ASSERT(broken.load(bytes.data(), bytes.size()));
+            TS_ASSERT(!broken.load(bytes.data(), bytes.size() - 1));
+            string wrong = bytes;
+            wrong[wrong.size() - 1] = 'x'; //unterminated string pool
+            TS_ASSERT(!broken.load(wrong.data(), wrong.size()));
+            unlink(image.c_str());
+            unlink(again.c_str());
+        }
+
+        //Images whose nodes do not nest are rejected before any lookup
+        //walks them
+        void testCorruptImage() {
+            fill(xmla);
+            const string image = tmpfile();
+            TS_ASSERT_EQUAL_INT(xmla->saveBinaryfile(image), 0);
+            const string bytes = readfile(image);
+
+            //the nodes follow the header of 32 bytes
+            const size_t header = 32;
+            const size_t count = (bytes.size() - header) / sizeof(XMLimage::Node);
+            auto node = [header](string &img, uint32_t n) {
+                return (XMLimage::Node*)&img[header + n * sizeof(XMLimage::Node)];
+            };
+            string copy = bytes;
+            uint32_t nested = 0, sibling = 0;
+            for(uint32_t n = 1; n < count && !(nested && sibling); ++n) {
+                const XMLimage::Node &nd = *node(copy, n);
+                if(nd.parent == XMLimage::NONE || nd.parent >= n)
+                    break;
+                if(!nested && nd.parent != 0)
+                    nested = n;
+                if(!sibling && nd.end < node(copy, nd.parent)->end)
+                    sibling = n;
+            }
+            TS_ASSERT(nested && sibling);
+            XMLimage img;
+            TS_ASSERT(img.load(copy.data(), copy.size()));
+
+            //a parent which is not the enclosing node
+            node(copy, nested)->parent = 0;
+            TS_ASSERT(!img.load(copy.data(), copy.size()));
+
+            //a node overlapping its next sibling
+            copy = bytes;
+            node(copy, sibling)->end += 1;
+            TS_ASSERT(!img.load(copy.data(), copy.size()));
+
+            //which fails the load of the file instead of a lookup
+            FILE *f = fopen(image.c_str(), "wb");
+            TS_ASSERT(f != NULL);
+            if(f) {
+                fwrite(copy.data(), 1, copy.size(), f);
+                fclose(f);
+            }
+            TS_ASSERT(xmlb->loadXMLfile(image) < 0);
+            unlink(image.c_str());
+        }
+
+        //A corrupt gzip trailer does not size the buffer (4 GiB here), the
+        //file just fails to load
+        void testCorruptSizeHint() {
+            fill(xmla);
+            const string file = tmpfile();
+            TS_ASSERT_EQUAL_INT(xmla->saveXMLfile(file, 9), 0);
+            FILE *f = fopen(file.c_str(), "r+b");
+            TS_ASSERT(f != NULL);
+            if(!f)
+                return;
+            fseek(f, -4, SEEK_END);
+            fwrite("\xff\xff\xff\xff", 1, 4, f);
+            fclose(f);
+
+            TS_ASSERT(xmlb->loadXMLfile(file) < 0);
+            unlink(file.c_str());
+        }
+
+        void testLoadSpeed() {
+            const int pars = 4000, loads = 20;
+            int expect = 0;
+            for(int i = 0; i < pars; ++i) {
+                xmla->addpar("par" + to_string(i), i % 128);
+                expect += 2 * loads * (i % 128);
+            }
+            char *data = xmla->getXMLdata();
+
+            int t_on = clock();
+            int sum = 0;
+            for(int l = 0; l < loads; ++l) {
+                xmlb->putXMLdata(data);
+                for(int i = 0; i < pars; ++i)
+                    sum += xmlb->getpar127("par" + to_string(i), 0);
+            }
+            int t_off = clock();
+            free(data);
+            const float branch = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            const string image = tmpfile();
+            xmla->saveBinaryfile(image);
+            t_on = clock();
+            for(int l = 0; l < loads; ++l) {
+                xmlb->loadXMLfile(image);
+                for(int i = 0; i < pars; ++i)
+                    sum += xmlb->getpar127("par" + to_string(i), 0);
+            }
+            t_off = clock();
+            unlink(image.c_str());
+            const float mapped = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            const string location = string(SOURCE_DIR) + "/Tests/guitar-adnote.xmz";
+            t_on = clock();
+            for(int l = 0; l < loads; ++l)
+                xmlb->loadXMLfile(location);
+            t_off = clock();
+            const float file = (t_off - t_on) / (float)CLOCKS_PER_SEC;
+
+            printf("XMLwrapperTest: %f seconds to load and read a branch of"
+                   " %d parameters %d times (%f seconds from an image),"
+                   " %f seconds to load %d instruments.\n",
+                   branch, pars, loads, mapped, file, loads);
+            TS_ASSERT_EQUAL_INT(sum, expect);
+        }
+
         void tearDown() {
             delete xmla;
             delete xmlb;
@@ -68,6 +286,11 @@ int main()
     RUN_TEST(testAddPar);
     RUN_TEST(testLoad);
     RUN_TEST(testAnotherLoad);
+    RUN_TEST(testIndexedLookup);
+    RUN_TEST(testBinaryImage);
+    RUN_TEST(testCorruptImage);
+    RUN_TEST(testCorruptSizeHint);
+    RUN_TEST(testLoadSpeed);
     return test_summary();
 }
 
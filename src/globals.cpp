@@ -13,6 +13,7 @@
 */
 
 #include "Misc/Util.h"
+#include "Misc/Denormals.h"
 #include "globals.h"
 
 namespace zyn {
@@ -27,9 +28,11 @@ void SYNTH_T::alias(bool randomize)
     //produce denormal buf
     // note: once there will be more buffers, use a cleanup function
     // for deleting the buffers and also call it in the dtor
+    // the noise is only needed if the audio threads can not flush them
+    denormalnoise = randomize && !ZYN_FLUSH_DENORMALS;
     denormalkillbuf.resize(buffersize);
     for(int i = 0; i < buffersize; ++i)
-        if(randomize)
+        if(denormalnoise)
             denormalkillbuf[i] = (RND - 0.5f) * 1e-16;
         else
             denormalkillbuf[i] = 0;
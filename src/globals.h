@@ -114,10 +114,15 @@ typedef std::complex<fftwf_real> fft_t;
 #define NUM_VOICES 8
 
 /*
- * The polyphony (notes)
+ * The polyphony (notes), the default of each part
  */
 #define POLYPHONY 60
 
+/*
+ * The largest polyphony a part can be given
+ */
+#define MAX_POLYPHONY 1024
+
 /*
  * Number of system effects
  */
@@ -324,6 +329,9 @@ struct SYNTH_T {
 
     /** the buffer to add noise in order to avoid denormalisation */
     m_unique_array<float> denormalkillbuf;
+    /** if denormalkillbuf holds noise, it is all zero when the FPU flushes
+     *  denormals instead (see Misc/Denormals.h) */
+    bool denormalnoise;
 
     /**Sampling rate*/
     unsigned int samplerate;
@@ -19,6 +19,8 @@
 #include <cctype>
 #include <ctime>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 #include <signal.h>
 
 #ifndef WIN32
@@ -37,10 +39,12 @@
 
 #include "DSP/FFTwrapper.h"
 #include "Misc/MemLocker.h"
+#include "Misc/OfflineRender.h"
 #include "Misc/PresetExtractor.h"
 #include "Misc/Master.h"
 #include "Misc/Part.h"
 #include "Misc/Util.h"
+#include "Misc/XMLwrapper.h"
 #include "zyn-config.h"
 #include "zyn-version.h"
 
@@ -139,6 +143,37 @@ void exitprogram(const Config& config)
     FFT_cleanup();
 }
 
+/*
+ * Offline rendering of a MIDI file instead of running the IO
+ */
+int rendermidi(const string &midifile, const string &wavfile)
+{
+    MidiFile midi;
+    if(midi.load(midifile.c_str())) {
+        cerr << "ERROR: Could not read MIDI file " << midifile << "." << endl;
+        return 1;
+    }
+
+    OfflineRender render(*master, middleware);
+    const auto start = std::chrono::steady_clock::now();
+    const long nsamples = render.render(midi, wavfile.c_str());
+    const std::chrono::duration<double> took =
+        std::chrono::steady_clock::now() - start;
+    if(nsamples < 0) {
+        cerr << "ERROR: Could not write " << wavfile << "." << endl;
+        return 1;
+    }
+
+    const double seconds = nsamples / (double)master->synth.samplerate;
+    cout << "Rendered " << seconds << " s into " << wavfile << " in "
+         << took.count() << " s (" << seconds / took.count()
+         << "x realtime)." << endl;
+
+    delete middleware;
+    FFT_cleanup();
+    return 0;
+}
+
 //Windows MIDI OH WHAT A HACK...
 #ifdef WIN32
 #include <windows.h>
@@ -275,6 +310,9 @@ int main(int argc, char *argv[])
         {
             "oscil-size", 2, NULL, 'o'
         },
+        {
+            "render-threads", 1, NULL, 'T'
+        },
         {
             "swap", 2, NULL, 'S'
         },
@@ -320,6 +358,9 @@ int main(int argc, char *argv[])
         {
             "dump-json-schema", 2, NULL, 'D'
         },
+        {
+            "render", 1, NULL, 'R'
+        },
         // options without single char equivalents ("getopt_flag" compulsory)
         {
             "list-inputs", no_argument, &getopt_flag, 'i'
@@ -327,6 +368,12 @@ int main(int argc, char *argv[])
         {
             "list-outputs", no_argument, &getopt_flag, 'o'
         },
+        {
+            "render-output", required_argument, &getopt_flag, 'w'
+        },
+        {
+            "convert", required_argument, &getopt_flag, 'c'
+        },
         {
             0, 0, 0, 0
         }
@@ -339,7 +386,8 @@ int main(int argc, char *argv[])
         help,
         version,
         list_inputs,
-        list_outputs
+        list_outputs,
+        convert
     };
     exit_with_t exit_with = exit_with_t::dont_exit;
     int preferred_port = -1;
@@ -347,6 +395,9 @@ int main(int argc, char *argv[])
     int wmidi = -1;
 
     string loadfile, loadinstrument, execAfterInit, loadmidilearn;
+    string rendermidifile, renderoutput = "render.wav";
+    string convertformat;
+    bool renderthreads = false; //set by the user
 
     while(1) {
         int tmp = 0;
@@ -354,7 +405,7 @@ int main(int argc, char *argv[])
         /**\todo check this process for a small memory leak*/
         opt = getopt_long(argc,
                           argv,
-                          "l:L:M:r:b:o:I:O:N:e:P:A:d:D:hvapSDUYZ",
+                          "l:L:M:r:b:o:T:R:I:O:N:e:P:A:d:D:hvapSDUYZ",
                           opts,
                           &option_index);
         char *optarguments = optarg;
@@ -424,6 +475,19 @@ int main(int argc, char *argv[])
                     "synth.oscilsize is wrong (must be 2^n) or too small. Adjusting to "
                     << synth.oscilsize << "." << endl;
                 break;
+            case 'T':
+                GETOPNUM(config.cfg.RenderThreads);
+                if(config.cfg.RenderThreads < 1
+                   || config.cfg.RenderThreads > NUM_MIDI_PARTS) {
+                    cerr << "ERROR:Incorrect number of render threads: "
+                         << optarguments << endl;
+                    exit(1);
+                }
+                renderthreads = true;
+                break;
+            case 'R':
+                GETOP(rendermidifile);
+                break;
             case 'S':
                 swaplr = 1;
                 break;
@@ -489,6 +553,19 @@ int main(int argc, char *argv[])
                     case 'o':
                         exit_with = exit_with_t::list_outputs;
                         break;
+                    case 'w':
+                        GETOP(renderoutput);
+                        break;
+                    case 'c':
+                        GETOP(convertformat);
+                        if(convertformat == "binary" || convertformat == "xml")
+                            exit_with = exit_with_t::convert;
+                        else {
+                            cerr << "ERROR:Unknown format " << convertformat
+                                 << " (binary or xml)" << endl;
+                            exit_with = exit_with_t::help;
+                        }
+                        break;
                 }
                 break;
             case '?':
@@ -516,6 +593,7 @@ int main(int argc, char *argv[])
                  <<
             "  -b BS, --buffer-size=SR\t\t Set the buffer size (granularity)\n"
                  << "  -o OS, --oscil-size=OS\t\t Set the ADsynth oscil. size\n"
+                 << "  -T N, --render-threads=N\t\t Render parts with N threads\n"
                  << "  -S , --swap\t\t\t\t Swap Left <--> Right\n"
                  <<
             "  -U , --no-gui\t\t\t\t Run ZynAddSubFX without user interface\n"
@@ -531,6 +609,11 @@ int main(int argc, char *argv[])
                  << "  -e , --exec-after-init\t\t Run post-initialization script\n"
                  << "  -d , --dump-oscdoc=FILE\t\t Dump oscdoc xml to file\n"
                  << "  -D , --dump-json-schema=FILE\t\t Dump osc schema (.json) to file\n"
+                 << "  -R , --render=FILE\t\t\t Render a MIDI file offline and exit\n"
+                 << "       --render-output=FILE\t\t WAV file to render into\n"
+                 << "\t\t\t\t\t (default render.wav)\n"
+                 << "       --convert=FORMAT FILE...\t Convert instruments, sessions,\n"
+                 << "\t\t\t\t\t ... in place to binary or xml and exit\n"
                  << endl;
             break;
         case exit_with_t::list_inputs:
@@ -549,6 +632,35 @@ int main(int argc, char *argv[])
             }
             break;
         }
+        case exit_with_t::convert:
+        {
+            //every file keeps its name, loading detects the format
+            int failed = 0;
+            for(int i = optind; i < argc; ++i) {
+                const string file = argv[i], tmp = file + ".convert";
+                XMLwrapper xml;
+                int result = xml.loadXMLfile(file);
+                if(result >= 0)
+                    result = convertformat == "binary"
+                             ? xml.saveBinaryfile(tmp)
+                             : xml.saveXMLfile(tmp, config.cfg.GzipCompression);
+#ifdef WIN32
+                //rename() does not replace files there
+                if(result >= 0)
+                    remove(file.c_str());
+#endif
+                if(result >= 0 && !rename(tmp.c_str(), file.c_str()))
+                    cout << file << endl;
+                else {
+                    cerr << "ERROR:Can't convert " << file << endl;
+                    remove(tmp.c_str());
+                    ++failed;
+                }
+            }
+            if(failed)
+                return 1;
+            break;
+        }
         default:
             break;
     }
@@ -562,6 +674,14 @@ int main(int argc, char *argv[])
     cerr << "Internal latency = \t" << synth.dt() * 1000.0f << " ms" << endl;
     cerr << "ADsynth Oscil.Size = \t" << synth.oscilsize << " samples" << endl;
 
+    if(!rendermidifile.empty()) {
+        //Same output on every run, as fast as all cores allow
+        sprng(0);
+        if(!renderthreads)
+            config.cfg.RenderThreads = limit<int>(
+                    std::thread::hardware_concurrency(), 1, NUM_MIDI_PARTS);
+    }
+
     initprogram(std::move(synth), &config, preferred_port);
 
     bool altered_master = false;
@@ -609,6 +729,9 @@ int main(int argc, char *argv[])
     if(altered_master)
         middleware->updateResources(master);
 
+    if(!rendermidifile.empty())
+        return rendermidi(rendermidifile, renderoutput);
+
 
     //Run the Nio system
     printf("[INFO] Nio::start()\n");